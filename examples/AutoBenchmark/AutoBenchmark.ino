@@ -44,6 +44,206 @@ COROUTINE(counterB) {
   }
 }
 
+// The same 2 counting coroutines as counterA and counterB, run by a
+// StaticCoroutineScheduler which calls them without virtual dispatch.
+class StaticCounterA: public StaticCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        counter++;
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+class StaticCounterB: public StaticCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        counter++;
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+using StaticScheduler =
+    StaticCoroutineScheduler<StaticCounterA, StaticCounterB>;
+
+// The same 2 counting coroutines, run by the CoroutineCrtpScheduler which
+// calls them through a function pointer instead of a virtual method.
+class CrtpCounterA: public CoroutineCrtp<CrtpCounterA> {
+  public:
+    int runCoroutine() {
+      COROUTINE_LOOP() {
+        counter++;
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+class CrtpCounterB: public CoroutineCrtp<CrtpCounterB> {
+  public:
+    int runCoroutine() {
+      COROUTINE_LOOP() {
+        counter++;
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+CrtpCounterA crtpCounterA;
+CrtpCounterB crtpCounterB;
+
+#if ACE_ROUTINE_HAS_SECTION_REGISTRY
+#include <new> // placement new
+
+// The same 2 counting coroutines, registered in the 'ace_routine_coroutines'
+// section and run by the SectionCoroutineScheduler.
+COROUTINE_SECTION(sectionCounterA) {
+  COROUTINE_LOOP() {
+    counter++;
+    COROUTINE_YIELD();
+  }
+}
+
+COROUTINE_SECTION(sectionCounterB) {
+  COROUTINE_LOOP() {
+    counter++;
+    COROUTINE_YIELD();
+  }
+}
+#endif
+
+// Coroutines which sleep in COROUTINE_DELAY() for the entire duration of the
+// benchmark, and one coroutine which increments the counter. Each group uses
+// its own clock type so that it lives in its own linked list, separate from
+// counterA and counterB, which allows the cost of a single pass through the
+// scheduler to be measured as a function of the number of sleeping coroutines.
+class SleepClock8: public ClockInterface {};
+class SleepClock32: public ClockInterface {};
+class SleepClockSnapshot32: public SnapshotClockInterface<ClockInterface> {};
+
+template <typename T_CLOCK>
+class SleepingCoroutine: public CoroutineTemplate<T_CLOCK> {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(30000);
+      }
+    }
+};
+
+template <typename T_CLOCK>
+class CountingCoroutine: public CoroutineTemplate<T_CLOCK> {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        counter++;
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+SleepingCoroutine<SleepClock8> sleepers8[8];
+CountingCoroutine<SleepClock8> counter8;
+SleepingCoroutine<SleepClock32> sleepers32[32];
+CountingCoroutine<SleepClock32> counter32;
+SleepingCoroutine<SleepClockSnapshot32> snapshotSleepers32[32];
+CountingCoroutine<SleepClockSnapshot32> snapshotCounter32;
+
+// Coroutines which are blocked for the entire duration of the benchmark on a
+// condition which never becomes true, to compare COROUTINE_AWAIT(), which
+// resumes each coroutine only to evaluate its condition, against
+// COROUTINE_AWAIT_PREDICATE(), whose predicate is evaluated by the
+// CoroutineScheduler without resuming the coroutine.
+class AwaitClock32: public ClockInterface {};
+class PredicateClock32: public ClockInterface {};
+
+bool ready = false;
+
+bool isReady(void* /*context*/) { return ready; }
+
+class AwaitingCoroutine: public CoroutineTemplate<AwaitClock32> {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT(isReady(nullptr));
+      }
+    }
+};
+
+class PredicateCoroutine: public CoroutineTemplate<PredicateClock32> {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT_PREDICATE(isReady, nullptr);
+      }
+    }
+};
+
+AwaitingCoroutine awaiters32[32];
+CountingCoroutine<AwaitClock32> awaitCounter32;
+PredicateCoroutine predicateAwaiters32[32];
+CountingCoroutine<PredicateClock32> predicateCounter32;
+
+// Coroutines which sleep in COROUTINE_DELAY_SECONDS(), to compare the cost of
+// deriving the seconds by dividing millis() by 1000 against the SecondsCounter
+// used by ClockInterface::seconds() on processors without hardware division.
+class SecondsDivClock8: public ClockInterface {
+  public:
+    static unsigned long seconds() { return ::millis() / 1000; }
+};
+
+class SecondsCounterClock8: public ClockInterface {
+  public:
+    static unsigned long seconds() {
+      static SecondsCounter counter;
+      return counter.update(::millis());
+    }
+};
+
+template <typename T_CLOCK>
+class SleepingSecondsCoroutine: public CoroutineTemplate<T_CLOCK> {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY_SECONDS(30000);
+      }
+    }
+};
+
+#if defined(EPOXY_DUINO)
+// 10000 coroutines on the host, to compare the walk through the linked list of
+// the CoroutineScheduler against the scan of the contiguous registry of the
+// CoroutineRegistryScheduler, when the coroutines do not fit into the cache.
+class SleepClock10k: public ClockInterface {};
+
+const uint16_t NUM_COROUTINES_10K = 10000;
+const uint32_t NUM_LIST_PASSES_10K = 1000;
+const uint32_t NUM_REGISTRY_PASSES_10K = 20000;
+
+SleepingCoroutine<SleepClock10k> sleepers10k[NUM_COROUTINES_10K - 1];
+CountingCoroutine<SleepClock10k> counter10k;
+#endif
+
+#if ACE_ROUTINE_HAS_SECTION_REGISTRY
+// Storage for 2 counting coroutines which are constructed again on every
+// iteration of doBootLinked(), to repeat the work done by the constructors of
+// the coroutines in the linked list before setup(). They use their own clock
+// type so that they live in their own linked list.
+class BootClock: public ClockInterface {};
+
+const uint8_t NUM_BOOT_COROUTINES = 2;
+
+alignas(CountingCoroutine<BootClock>) uint8_t bootStorage[
+    NUM_BOOT_COROUTINES][sizeof(CountingCoroutine<BootClock>)];
+#endif
+
+SleepingSecondsCoroutine<SecondsDivClock8> secondsDivSleepers8[8];
+CountingCoroutine<SecondsDivClock8> secondsDivCounter8;
+SleepingSecondsCoroutine<SecondsCounterClock8> secondsCounterSleepers8[8];
+CountingCoroutine<SecondsCounterClock8> secondsCounterCounter8;
+
 void checkEqual(
     const __FlashStringHelper* msg, uint32_t expected, uint32_t observed) {
   if (expected != observed) {
@@ -99,8 +299,155 @@ uint16_t doCoroutineScheduling(uint32_t iterations) {
   return end - start;
 }
 
-void printNanosAsMicros(Print& printer, uint16_t nanos) {
-  uint16_t wholeMicros = nanos / 1000;
+uint16_t doStaticScheduling(uint32_t iterations) {
+  StaticScheduler::setup();
+  yield();
+  counter = 0;
+  uint16_t start = millis();
+  for (uint32_t i = 0; i < iterations; i++) {
+    StaticScheduler::loop();
+  }
+  uint16_t end = millis();
+  yield();
+  checkEqual(F("doStaticScheduling()"), counter, iterations);
+  return end - start;
+}
+
+uint16_t doCrtpScheduling(uint32_t iterations) {
+  CoroutineCrtpScheduler::setup();
+  yield();
+  counter = 0;
+  uint16_t start = millis();
+  for (uint32_t i = 0; i < iterations; i++) {
+    CoroutineCrtpScheduler::loop();
+  }
+  uint16_t end = millis();
+  yield();
+  checkEqual(F("doCrtpScheduling()"), counter, iterations);
+  return end - start;
+}
+
+#if ACE_ROUTINE_HAS_SECTION_REGISTRY
+
+uint16_t doSectionScheduling(uint32_t iterations) {
+  SectionCoroutineScheduler::setup();
+  yield();
+  counter = 0;
+  uint16_t start = millis();
+  for (uint32_t i = 0; i < iterations; i++) {
+    SectionCoroutineScheduler::loop();
+  }
+  uint16_t end = millis();
+  yield();
+  checkEqual(F("doSectionScheduling()"), counter, iterations);
+  return end - start;
+}
+
+// Repeat the work from boot to the first dispatch of a coroutine in the linked
+// list: the constructor of each coroutine inserts it into the list, then
+// setup() and the first loop() of the scheduler.
+uint16_t doBootLinked(uint32_t iterations) {
+  using BootScheduler = CoroutineSchedulerTemplate<CoroutineTemplate<BootClock>>;
+
+  yield();
+  counter = 0;
+  uint16_t start = millis();
+  for (uint32_t i = 0; i < iterations; i++) {
+    for (uint8_t j = 0; j < NUM_BOOT_COROUTINES; j++) {
+      new (bootStorage[j]) CountingCoroutine<BootClock>();
+    }
+    BootScheduler::setup();
+    BootScheduler::loop();
+  }
+  uint16_t end = millis();
+  yield();
+  checkEqual(F("doBootLinked()"), counter, iterations);
+  return end - start;
+}
+
+// Repeat the work from boot to the first dispatch of a coroutine in the
+// section. The coroutines are constant initialized, so there is no
+// constructor to run.
+uint16_t doBootSection(uint32_t iterations) {
+  yield();
+  counter = 0;
+  uint16_t start = millis();
+  for (uint32_t i = 0; i < iterations; i++) {
+    SectionCoroutineScheduler::setup();
+    SectionCoroutineScheduler::loop();
+  }
+  uint16_t end = millis();
+  yield();
+  checkEqual(F("doBootSection()"), counter, iterations);
+  return end - start;
+}
+
+#endif
+
+// Batch dispatch modes of the CoroutineScheduler, each followed by a call to
+// yield() to simulate the overhead of returning to the Arduino loop().
+const uint8_t kModeLoop = 0;
+const uint8_t kModeOnePass = 1;
+const uint8_t kModeLoopFor = 2;
+const uint8_t kModeUntilIdle = 3;
+
+// Budget of the loopFor() mode in micros, and of the runUntilIdle() mode in
+// number of coroutines.
+const uint32_t LOOP_FOR_MICROS = 1000;
+const uint16_t UNTIL_IDLE_RUNS = 16;
+
+// Run the CoroutineScheduler in the given mode until counterA and counterB
+// have incremented the counter at least 'iterations' times. Returns the
+// elapsed millis, and the actual number of context switches in 'switches',
+// which can overshoot 'iterations' by one batch.
+uint16_t doBatchScheduling(
+    uint8_t mode, uint32_t iterations, uint32_t& switches) {
+  CoroutineScheduler::setup();
+  yield();
+  counter = 0;
+  uint16_t start = millis();
+  while (counter < iterations) {
+    switch (mode) {
+      case kModeOnePass:
+        CoroutineScheduler::runOnePass();
+        break;
+      case kModeLoopFor:
+        CoroutineScheduler::loopFor(LOOP_FOR_MICROS);
+        break;
+      case kModeUntilIdle:
+        CoroutineScheduler::runUntilIdle(UNTIL_IDLE_RUNS);
+        break;
+      default:
+        CoroutineScheduler::loop();
+        break;
+    }
+    yield();
+  }
+  uint16_t end = millis();
+  yield();
+  switches = counter;
+  return end - start;
+}
+
+// Run the given scheduler until the counting coroutine has incremented the
+// counter 'iterations' times. Each increment is one full pass through the
+// scheduler.
+template <typename T_SCHEDULER>
+uint16_t doSleepingScheduling(uint32_t iterations) {
+  T_SCHEDULER::setup();
+  yield();
+  counter = 0;
+  uint16_t start = millis();
+  while (counter < iterations) {
+    T_SCHEDULER::loop();
+  }
+  uint16_t end = millis();
+  yield();
+  return end - start;
+}
+
+void printNanosAsMicros(Print& printer, uint32_t nanos) {
+  uint32_t wholeMicros = nanos / 1000;
   uint16_t fracMicros = nanos - wholeMicros * 1000;
   printer.print(wholeMicros);
   printer.print('.');
@@ -108,10 +455,11 @@ void printNanosAsMicros(Print& printer, uint16_t nanos) {
 }
 
 // Print millis 'ms' as micros (to 3 decimal places) per iteration as a floating
-// point number. The number of 'iterations' must be divisible by 1000.
+// point number. The number of 'iterations' should be divisible by 1000,
+// otherwise the result is slightly rounded.
 void printStats(
     const __FlashStringHelper* name, uint16_t ms, uint32_t iterations) {
-  uint16_t nanosPerIteration = (uint32_t) ms * 1000 / (iterations / 1000);
+  uint32_t nanosPerIteration = (uint32_t) ms * 1000 / (iterations / 1000);
   SERIAL_PORT_MONITOR.print(name);
   SERIAL_PORT_MONITOR.print(' ');
   printNanosAsMicros(SERIAL_PORT_MONITOR, nanosPerIteration);
@@ -132,8 +480,16 @@ void setup() {
 
   SERIAL_PORT_MONITOR.print(F("sizeof(Coroutine): "));
   SERIAL_PORT_MONITOR.println(sizeof(Coroutine));
+  SERIAL_PORT_MONITOR.print(F("sizeof(CoroutineCrtp): "));
+  SERIAL_PORT_MONITOR.println(sizeof(CrtpCounterA));
+#if ACE_ROUTINE_HAS_SECTION_REGISTRY
+  SERIAL_PORT_MONITOR.print(F("sizeof(SectionCoroutine): "));
+  SERIAL_PORT_MONITOR.println(sizeof(SectionCoroutine));
+#endif
   SERIAL_PORT_MONITOR.print(F("sizeof(CoroutineScheduler): "));
   SERIAL_PORT_MONITOR.println(sizeof(CoroutineScheduler));
+  SERIAL_PORT_MONITOR.print(F("sizeof(CoroutineDeadlineScheduler): "));
+  SERIAL_PORT_MONITOR.println(sizeof(CoroutineDeadlineScheduler));
   SERIAL_PORT_MONITOR.print(F("sizeof(Channel<int>): "));
   SERIAL_PORT_MONITOR.println(sizeof(Channel<int>));
 
@@ -151,6 +507,99 @@ void setup() {
   uint16_t schedulerMillis = doCoroutineScheduling(NUM_ITERATIONS);
   printStats(F("CoroutineScheduling"), schedulerMillis, NUM_ITERATIONS);
 
+  uint16_t staticMillis = doStaticScheduling(NUM_ITERATIONS);
+  printStats(F("StaticScheduling"), staticMillis, NUM_ITERATIONS);
+
+  uint16_t crtpMillis = doCrtpScheduling(NUM_ITERATIONS);
+  printStats(F("CrtpScheduling"), crtpMillis, NUM_ITERATIONS);
+
+#if ACE_ROUTINE_HAS_SECTION_REGISTRY
+  uint16_t sectionMillis = doSectionScheduling(NUM_ITERATIONS);
+  printStats(F("SectionScheduling"), sectionMillis, NUM_ITERATIONS);
+
+  uint16_t bootLinkedMillis = doBootLinked(NUM_ITERATIONS);
+  printStats(F("BootLinked"), bootLinkedMillis, NUM_ITERATIONS);
+
+  uint16_t bootSectionMillis = doBootSection(NUM_ITERATIONS);
+  printStats(F("BootSection"), bootSectionMillis, NUM_ITERATIONS);
+#endif
+
+  uint16_t sleep8SchedulerMillis = doSleepingScheduling<
+      CoroutineSchedulerTemplate<CoroutineTemplate<SleepClock8>>>(
+          NUM_ITERATIONS);
+  printStats(F("Sleep8Scheduler"), sleep8SchedulerMillis, NUM_ITERATIONS);
+
+  uint16_t sleep8DeadlineMillis = doSleepingScheduling<
+      CoroutineDeadlineSchedulerTemplate<CoroutineTemplate<SleepClock8>, 8>>(
+          NUM_ITERATIONS);
+  printStats(F("Sleep8Deadline"), sleep8DeadlineMillis, NUM_ITERATIONS);
+
+  uint16_t sleep32SchedulerMillis = doSleepingScheduling<
+      CoroutineSchedulerTemplate<CoroutineTemplate<SleepClock32>>>(
+          NUM_ITERATIONS);
+  printStats(F("Sleep32Scheduler"), sleep32SchedulerMillis, NUM_ITERATIONS);
+
+  uint16_t sleep32DeadlineMillis = doSleepingScheduling<
+      CoroutineDeadlineSchedulerTemplate<CoroutineTemplate<SleepClock32>, 32>>(
+          NUM_ITERATIONS);
+  printStats(F("Sleep32Deadline"), sleep32DeadlineMillis, NUM_ITERATIONS);
+
+  uint16_t sleep32SnapshotMillis = doSleepingScheduling<
+      CoroutineSchedulerTemplate<CoroutineTemplate<SleepClockSnapshot32>>>(
+          NUM_ITERATIONS);
+  printStats(F("Sleep32Snapshot"), sleep32SnapshotMillis, NUM_ITERATIONS);
+
+  uint16_t await32SchedulerMillis = doSleepingScheduling<
+      CoroutineSchedulerTemplate<CoroutineTemplate<AwaitClock32>>>(
+          NUM_ITERATIONS);
+  printStats(F("Await32Scheduler"), await32SchedulerMillis, NUM_ITERATIONS);
+
+  uint16_t await32PredicateMillis = doSleepingScheduling<
+      CoroutineSchedulerTemplate<CoroutineTemplate<PredicateClock32>>>(
+          NUM_ITERATIONS);
+  printStats(F("Await32Predicate"), await32PredicateMillis, NUM_ITERATIONS);
+
+#if defined(EPOXY_DUINO)
+  uint16_t list10kMillis = doSleepingScheduling<
+      CoroutineSchedulerTemplate<CoroutineTemplate<SleepClock10k>>>(
+          NUM_LIST_PASSES_10K);
+  printStats(F("List10k"), list10kMillis, NUM_LIST_PASSES_10K);
+
+  uint16_t registry10kMillis = doSleepingScheduling<
+      CoroutineRegistrySchedulerTemplate<
+          CoroutineTemplate<SleepClock10k>, NUM_COROUTINES_10K>>(
+          NUM_REGISTRY_PASSES_10K);
+  printStats(F("Registry10k"), registry10kMillis, NUM_REGISTRY_PASSES_10K);
+#endif
+
+  uint16_t sleep8SecondsDivMillis = doSleepingScheduling<
+      CoroutineSchedulerTemplate<CoroutineTemplate<SecondsDivClock8>>>(
+          NUM_ITERATIONS);
+  printStats(F("Sleep8SecondsDiv"), sleep8SecondsDivMillis, NUM_ITERATIONS);
+
+  uint16_t sleep8SecondsCounterMillis = doSleepingScheduling<
+      CoroutineSchedulerTemplate<CoroutineTemplate<SecondsCounterClock8>>>(
+          NUM_ITERATIONS);
+  printStats(F("Sleep8SecondsCount"), sleep8SecondsCounterMillis,
+      NUM_ITERATIONS);
+
+  uint32_t switches;
+  uint16_t batchLoopMillis = doBatchScheduling(
+      kModeLoop, NUM_ITERATIONS, switches);
+  printStats(F("BatchLoop"), batchLoopMillis, switches);
+
+  uint16_t batchOnePassMillis = doBatchScheduling(
+      kModeOnePass, NUM_ITERATIONS, switches);
+  printStats(F("BatchOnePass"), batchOnePassMillis, switches);
+
+  uint16_t batchLoopForMillis = doBatchScheduling(
+      kModeLoopFor, NUM_ITERATIONS, switches);
+  printStats(F("BatchLoopFor"), batchLoopForMillis, switches);
+
+  uint16_t batchUntilIdleMillis = doBatchScheduling(
+      kModeUntilIdle, NUM_ITERATIONS, switches);
+  printStats(F("BatchUntilIdle"), batchUntilIdleMillis, switches);
+
   SERIAL_PORT_MONITOR.println(F("END"));
 
 #if defined(EPOXY_DUINO)
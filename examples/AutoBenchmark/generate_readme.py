@@ -38,6 +38,76 @@ a baseline. This is represented by the `base` column.
 The difference between the 2 benchmarks (represented by the `diff` column below)
 is the overhead caused by the `Coroutine` context switch.
 
+The `StaticScheduling` benchmark runs 2 equivalent counting coroutines using
+the `StaticCoroutineScheduler::loop()`, which calls each `runCoroutine()`
+directly instead of through the virtual method and the linked list. The line
+below each table gives the fraction of the difference between
+`CoroutineScheduling` and `DirectScheduling` which it removes. The
+`CrtpScheduling` benchmark does the same using `CoroutineCrtp` coroutines and
+the `CoroutineCrtpScheduler::loop()`, which walks a linked list like the
+`CoroutineScheduler`, but calls each coroutine through a function pointer
+instead of its vtable. The `SectionScheduling` benchmark uses coroutines
+defined by `COROUTINE_SECTION()` and the `SectionCoroutineScheduler::loop()`,
+which walks the array of descriptors placed in a linker section.
+
+The `BootLinked` benchmark repeats the work done from boot to the first
+dispatch of a coroutine in the linked list of the `CoroutineScheduler`:
+constructing 2 coroutines, which inserts each one into the list, then calling
+`setup()` and `loop()` of the scheduler. The `BootSection` benchmark does the
+same for 2 coroutines in the linker section, which are constant initialized,
+so only `setup()` and `loop()` of the `SectionCoroutineScheduler` are called.
+These 3 benchmarks are not available on AVR.
+
+The `Sleep8Scheduler` and `Sleep32Scheduler` benchmarks run one counting
+coroutine together with 8 or 32 coroutines which sleep in `COROUTINE_DELAY()`
+for the entire benchmark, using the `CoroutineScheduler`. The time per
+iteration is the cost of one full pass through the scheduler. The
+`Sleep8Deadline` and `Sleep32Deadline` benchmarks do the same thing using the
+`CoroutineDeadlineScheduler`, whose cost per pass should not depend on the
+number of sleeping coroutines. The `Sleep32Snapshot` benchmark is the same as
+`Sleep32Scheduler`, but uses the `SnapshotClockInterface`, which reads
+`millis()` once per pass instead of once per sleeping coroutine.
+
+The `Await32Scheduler` and `Await32Predicate` benchmarks run one counting
+coroutine together with 32 coroutines which are blocked for the entire
+benchmark on a condition which never becomes true. The first uses
+`COROUTINE_AWAIT()`, so the `CoroutineScheduler` resumes each blocked
+coroutine on every pass only to evaluate its condition. The second uses
+`COROUTINE_AWAIT_PREDICATE()`, whose predicate is evaluated by the
+`CoroutineScheduler` without resuming the coroutine, but only if this program
+is compiled with `-D ACE_ROUTINE_AWAIT_PREDICATE=1`. Otherwise both rows
+measure the same thing. On an x86_64 host, the flag reduces `Await32Predicate`
+from about 0.25 to 0.15 micros, and makes no measurable difference to
+`CoroutineScheduling` or `Await32Scheduler`, whose `Yielding` coroutines pay
+one extra check of the predicate pointer.
+
+The `Sleep8SecondsDiv` and `Sleep8SecondsCount` benchmarks run 8 coroutines
+sleeping in `COROUTINE_DELAY_SECONDS()`. The first derives the seconds by
+dividing `millis()` by 1000, the second uses the `SecondsCounter` which
+`ClockInterface::seconds()` uses on processors without hardware division.
+
+The cost of the 32-bit delay fields can be measured by compiling this program
+with `-D ACE_ROUTINE_DELAY_BITS=32`, which changes `sizeof(Coroutine)` and the
+`SleepNXxx` benchmarks.
+
+The results of the microcontrollers below have not yet been collected again
+since the `Sleep8SecondsXxx` benchmarks were added, so their tables do not
+show them, nor the 32-bit delay fields. They will appear once the `*.txt`
+files are regenerated on each board.
+
+The `BatchXxx` benchmarks run the same 2 counting coroutines as
+`CoroutineScheduling`, but call `yield()` after each call into the
+`CoroutineScheduler`, to simulate the overhead of returning to the Arduino
+`loop()`. The time per iteration is the cost of each context switch:
+
+* `BatchLoop`: `CoroutineScheduler::loop()` runs 1 coroutine per `yield()`
+* `BatchOnePass`: `CoroutineScheduler::runOnePass()` runs 2 coroutines per
+  `yield()`
+* `BatchLoopFor`: `CoroutineScheduler::loopFor(1000)` runs coroutines for 1
+  millisecond per `yield()`
+* `BatchUntilIdle`: `CoroutineScheduler::runUntilIdle(16)` runs 16
+  coroutines per `yield()`, since the counting coroutines are never idle
+
 All times in below are in microseconds.
 
 **Version**: AceRoutine v1.4
@@ -135,6 +205,28 @@ $ make README.md
     * Upgrade STM32duino Core from 1.9.0 to 2.0.0.
     * Upgrade SparkFun SAMD Core from 1.8.1 to 1.8.3.
     * No changes observed.
+* Unreleased
+    * Add `Sleep8Scheduler`, `Sleep8Deadline`, `Sleep32Scheduler`, and
+      `Sleep32Deadline` benchmarks to compare the `CoroutineScheduler` with the
+      new `CoroutineDeadlineScheduler` when most coroutines are sleeping.
+    * Add `Sleep32Snapshot` benchmark to measure the `SnapshotClockInterface`.
+    * Add `Await32Scheduler` and `Await32Predicate` benchmarks to measure
+      `COROUTINE_AWAIT_PREDICATE()` against `COROUTINE_AWAIT()`.
+    * Add `StaticScheduling` benchmark to measure the
+      `StaticCoroutineScheduler`.
+    * Add `CrtpScheduling` benchmark to measure the `CoroutineCrtpScheduler`.
+    * Add `SectionScheduling`, `BootLinked`, and `BootSection` benchmarks,
+      except on AVR, to measure the `SectionCoroutineScheduler` and the time
+      from boot to the first dispatch.
+    * Add `List10k` and `Registry10k` benchmarks, on EpoxyDuino only, which
+      give the time of one pass through 9999 sleeping coroutines and 1
+      counting coroutine, using the `CoroutineScheduler` and the
+      `CoroutineRegistryScheduler`.
+    * Add `Sleep8SecondsDiv` and `Sleep8SecondsCount` benchmarks to measure
+      the `SecondsCounter`.
+    * Add `BatchLoop`, `BatchOnePass`, `BatchLoopFor`, and `BatchUntilIdle`
+      benchmarks to measure the context switch overhead of the batch dispatch
+      methods of `CoroutineScheduler`.
 
 ## Arduino Nano
 
@@ -63,7 +63,9 @@ END {
   printf("| Functionality       |  iters | micros/iter |   diff |\n")
   for (i = 0; i < TOTAL_BENCHMARKS; i++) {
     name = u[i]["name"]
-    if (name ~ /^EmptyLoop$/ || name ~ /^DirectScheduler$/){
+    if (name ~ /^EmptyLoop$/ || name ~ /^DirectScheduler$/ \
+        || name ~ /^Sleep8Scheduler$/ || name ~ /^BatchLoop$/ \
+        || name ~ /^BootLinked$/ || name ~ /^List10k$/){
       printf("|---------------------+--------+-------------+--------|\n")
     }
 
@@ -71,4 +73,29 @@ END {
       u[i]["name"], u[i]["iterations"], u[i]["micros"], u[i]["diff"])
   }
   printf("+---------------------+--------+-------------+--------+\n")
+
+  # Fraction of the overhead of CoroutineScheduling over DirectScheduling which
+  # is removed by the StaticCoroutineScheduler, the CoroutineCrtpScheduler and
+  # the SectionCoroutineScheduler.
+  for (i = 0; i < TOTAL_BENCHMARKS; i++) {
+    micros_by_name[u[i]["name"]] = u[i]["micros"]
+  }
+  num_gap_names = split(
+      "StaticScheduling CrtpScheduling SectionScheduling", gap_names, " ")
+  for (j = 1; j <= num_gap_names; j++) {
+    name = gap_names[j]
+    if (!(("DirectScheduling" in micros_by_name) \
+        && ("CoroutineScheduling" in micros_by_name) \
+        && (name in micros_by_name))) {
+      continue
+    }
+    gap = micros_by_name["CoroutineScheduling"] \
+        - micros_by_name["DirectScheduling"]
+    if (gap > 0) {
+      closed = micros_by_name["CoroutineScheduling"] \
+          - micros_by_name[name]
+      printf("%s closes %.0f%% of the gap between", name, 100 * closed / gap)
+      printf(" CoroutineScheduling and DirectScheduling.\n")
+    }
+  }
 }
@@ -12,9 +12,25 @@
  * programming, the yield() call cause additional latency of a Channel because
  * the synchronization provided by the Channel causes additional loops through
  * the Coroutine::loop() method, which causes additional calls to yield().
+ *
+ * The second table measures the end-to-end latency of a sensor -> filter ->
+ * actuator chain of 3 coroutines connected by 2 Channels, from the time that
+ * the sensor creates a sample to the time that the actuator receives it. The
+ * chain is created in the worst order for the CoroutineScheduler, which
+ * visits the actuator first, and the 2 counter coroutines run alongside it as
+ * other work which makes each pass of the scheduler longer. The 'DAG' column uses
+ * CoroutineScheduler::setDependencies() to dispatch the chain from the sensor
+ * to the actuator. The latency is measured in calls to
+ * CoroutineScheduler::loop(), then converted into microseconds using the
+ * average duration of a call, because the latency is often shorter than the
+ * resolution of micros().
  */
 
 #include <Arduino.h>
+
+// Required by setDependencies(). Must be defined before AceRoutine.h.
+#define ACE_ROUTINE_DEPENDENCIES 1
+
 #include <AceRoutine.h>
 using namespace ace_routine;
 
@@ -81,6 +97,101 @@ Incrementer master(masterInSlaveOutChannel, masterOutSlaveInChannel,
     true /*isMaster*/);
 Incrementer slave(masterOutSlaveInChannel, masterInSlaveOutChannel);
 
+// Number of calls to CoroutineScheduler::loop() by doPipeline(), used as the
+// timestamp of the samples.
+static unsigned long numLoops = 0;
+
+// Sum of the latencies of the samples received by the actuators, in calls to
+// CoroutineScheduler::loop().
+static unsigned long latencySum = 0;
+static unsigned long numSamples = 0;
+
+class Sensor: public Coroutine {
+  public:
+    Sensor(Channel<unsigned long>& outChannel):
+      mOutChannel(outChannel)
+      {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_CHANNEL_WRITE(mOutChannel, numLoops);
+      }
+    }
+
+  private:
+    Channel<unsigned long>& mOutChannel;
+};
+
+class Filter: public Coroutine {
+  public:
+    Filter(Channel<unsigned long>& inChannel,
+        Channel<unsigned long>& outChannel):
+      mInChannel(inChannel),
+      mOutChannel(outChannel)
+      {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_CHANNEL_READ(mInChannel, mSample);
+        COROUTINE_CHANNEL_WRITE(mOutChannel, mSample);
+      }
+    }
+
+  private:
+    Channel<unsigned long>& mInChannel;
+    Channel<unsigned long>& mOutChannel;
+    unsigned long mSample;
+};
+
+class Actuator: public Coroutine {
+  public:
+    Actuator(Channel<unsigned long>& inChannel):
+      mInChannel(inChannel)
+      {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_CHANNEL_READ(mInChannel, mSample);
+        latencySum += numLoops - mSample;
+        numSamples++;
+      }
+    }
+
+  private:
+    Channel<unsigned long>& mInChannel;
+    unsigned long mSample;
+};
+
+// The stages are created from the sensor to the actuator, so the linked list
+// of the CoroutineScheduler visits the actuator first.
+struct Pipeline {
+  Channel<unsigned long> sensorToFilter;
+  Channel<unsigned long> filterToActuator;
+  Sensor sensor{sensorToFilter};
+  Filter filter{sensorToFilter, filterToActuator};
+  Actuator actuator{filterToActuator};
+
+  void suspend() {
+    sensor.suspend();
+    filter.suspend();
+    actuator.suspend();
+  }
+
+  void resume() {
+    sensor.resume();
+    filter.resume();
+    actuator.resume();
+  }
+};
+
+Pipeline pipeline;
+Pipeline dagPipeline;
+
+const CoroutineScheduler::Dependency dagDependencies[] = {
+  {&dagPipeline.sensor, &dagPipeline.filter},
+  {&dagPipeline.filter, &dagPipeline.actuator},
+};
+
 void doMasterSlaveChannel() {
   master.resume();
   slave.resume();
@@ -112,6 +223,32 @@ void doCoroutineCounter() {
   yield();
 }
 
+// Return the average latency of the samples through the given pipeline, in
+// microseconds.
+float doPipeline(Pipeline& active) {
+  master.suspend();
+  slave.suspend();
+  counterA.resume();
+  counterB.resume();
+  active.resume();
+
+  numLoops = 0;
+  latencySum = 0;
+  numSamples = 0;
+  unsigned long start = millis();
+  yield();
+  while (millis() - start < DURATION) {
+    CoroutineScheduler::loop();
+    numLoops++;
+  }
+  yield();
+
+  active.suspend();
+  if (numSamples == 0) return 0.0;
+  float loopDuration = DURATION * 1000.0 / numLoops;
+  return loopDuration * latencySum / numSamples;
+}
+
 void printStats(float baselineDuration, float channelDuration) {
   char buf[100];
   float diff = channelDuration - baselineDuration;
@@ -130,6 +267,9 @@ void setup() {
   while (!Serial); // Leonardo/Micro
 
   CoroutineScheduler::setup();
+  CoroutineScheduler::setDependencies(dagDependencies, 2);
+  pipeline.suspend();
+  dagPipeline.suspend();
 
   Serial.println(
       F("------------+------+------+"));
@@ -146,6 +286,19 @@ void setup() {
 
   printStats(baselineDuration, channelDuration);
 
+  Serial.println(
+      F("------------+------+------+"));
+
+  float pipelineLatency = doPipeline(pipeline);
+  float dagLatency = doPipeline(dagPipeline);
+
+  Serial.println(
+      F("   Pipeline | DAG  | diff |"));
+  Serial.println(
+      F("------------+------+------+"));
+
+  printStats(dagLatency, pipelineLatency);
+
   Serial.println(
       F("------------+------+------+"));
 }
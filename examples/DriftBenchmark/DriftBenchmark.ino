@@ -0,0 +1,154 @@
+/*
+ * This sketch measures the drift and jitter of a 100 Hz sampler under load,
+ * using 3 ways of waiting for the next sample:
+ *
+ *  - 'Delay' uses COROUTINE_DELAY(10), which starts each delay when the
+ *    coroutine happens to resume, so the scheduling latency of every
+ *    iteration accumulates.
+ *  - 'DelayUntil' advances its own deadline by 10 millis and uses
+ *    COROUTINE_DELAY_UNTIL().
+ *  - 'Periodic' uses COROUTINE_PERIODIC(10, missed).
+ *
+ * The 3 samplers run concurrently with a 'load' coroutine, which busy-waits a
+ * random 0-2999 micros each time it runs, so that each sampler resumes up to 3
+ * millis late. About once in 100 runs, it also blocks for 25 millis, so that
+ * whole periods are missed. 'DelayUntil' catches up by sampling back to back,
+ * while 'Periodic' skips the missed periods and counts them.
+ *
+ * The 'drift' column is the difference between the measured and the nominal
+ * duration of all the sampling intervals, in percent, where skipped periods
+ * are part of the nominal duration. The 'jitter' column is the largest
+ * deviation of one interval from 10 millis, in micros.
+ */
+
+#include <Arduino.h>
+#include <AceRoutine.h>
+using namespace ace_routine;
+
+#if defined(ESP8266)
+const unsigned long DURATION = 1000;  // prevent watch dog timer exception
+#else
+const unsigned long DURATION = 3000;
+#endif
+
+// Sampling period in millis.
+const uint16_t PERIOD = 10;
+
+// Timing of the samples of one sampler.
+struct Stats {
+  void record() {
+    unsigned long now = micros();
+    if (count > 0) {
+      long deviation = (long) (now - last) - PERIOD * 1000L;
+      if (deviation < 0) deviation = -deviation;
+      if ((unsigned long) deviation > maxJitter) maxJitter = deviation;
+    } else {
+      first = now;
+    }
+    last = now;
+    count++;
+  }
+
+  // Return the drift of the intervals, in percent of the nominal duration.
+  // The missed periods are part of the nominal duration.
+  float drift() const {
+    if (count < 2) return 0.0;
+    float nominal = (count - 1 + missed) * PERIOD * 1000.0;
+    return ((last - first) - nominal) * 100.0 / nominal;
+  }
+
+  uint32_t count = 0;
+  unsigned long first = 0;
+  unsigned long last = 0;
+  unsigned long maxJitter = 0;
+  uint16_t missed = 0;
+};
+
+Stats delayStats;
+Stats untilStats;
+Stats periodicStats;
+
+COROUTINE(delaySampler) {
+  COROUTINE_LOOP() {
+    COROUTINE_DELAY(PERIOD);
+    delayStats.record();
+  }
+}
+
+unsigned long untilDeadline;
+
+COROUTINE(untilSampler) {
+  COROUTINE_BEGIN();
+  untilDeadline = millis();
+  while (true) {
+    untilDeadline += PERIOD;
+    COROUTINE_DELAY_UNTIL(untilDeadline);
+    untilStats.record();
+  }
+}
+
+COROUTINE(periodicSampler) {
+  COROUTINE_LOOP() {
+    COROUTINE_PERIODIC(PERIOD, periodicStats.missed);
+    periodicStats.record();
+  }
+}
+
+COROUTINE(load) {
+  COROUTINE_LOOP() {
+    delayMicroseconds(random(3000));
+    if (random(100) == 0) delay(25);
+    COROUTINE_YIELD();
+  }
+}
+
+void printStats(const __FlashStringHelper* name, const Stats& stats) {
+  // Clamp the drift to +/-999.99 so that it fits into the buffer.
+  char drift[10];
+  long hundredths = (long) (stats.drift() * 100);
+  if (hundredths > 99999) hundredths = 99999;
+  if (hundredths < -99999) hundredths = -99999;
+  uint32_t magnitude = (uint32_t) labs(hundredths);
+  sprintf(drift, "%s%u.%02u", (hundredths < 0) ? "-" : "",
+      (unsigned) (magnitude / 100 % 1000), (unsigned) (magnitude % 100));
+
+  char buf[100];
+  sprintf(buf, " %7lu | %6s | %7lu | %6u |",
+      (unsigned long) stats.count,
+      drift,
+      stats.maxJitter,
+      stats.missed);
+  Serial.print(name);
+  Serial.println(buf);
+}
+
+void setup() {
+#if ! defined(EPOXY_DUINO)
+  delay(1000);
+#endif
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  CoroutineScheduler::setup();
+
+  unsigned long start = millis();
+  yield();
+  while (millis() - start < DURATION) {
+    CoroutineScheduler::loop();
+  }
+  yield();
+
+  Serial.println(F("------------+---------+--------+---------+--------+"));
+  Serial.println(F("    Sampler | samples |  drift |  jitter | missed |"));
+  Serial.println(F("------------+---------+--------+---------+--------+"));
+  printStats(F("      Delay |"), delayStats);
+  printStats(F(" DelayUntil |"), untilStats);
+  printStats(F("   Periodic |"), periodicStats);
+  Serial.println(F("------------+---------+--------+---------+--------+"));
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+void loop() {}
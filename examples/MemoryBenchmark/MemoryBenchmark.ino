@@ -36,6 +36,32 @@
 #define FEATURE_SCHEDULER_MANUAL_SETUP_TWO_COROUTINES 18
 #define FEATURE_BLINK_FUNCTION 19
 #define FEATURE_BLINK_COROUTINE 20
+#define FEATURE_ONE_COROUTINE_SECONDS_DIVISION 21
+#define FEATURE_ONE_COROUTINE_DELAY32 22
+#define FEATURE_SCHEDULER_ONE_COROUTINE_DELAY32 23
+#define FEATURE_ONE_COROUTINE_CRTP 24
+#define FEATURE_SCHEDULER_ONE_COROUTINE_CRTP 25
+#define FEATURE_SCHEDULER_TWO_COROUTINES_CRTP 26
+#define FEATURE_SCHEDULER_TWO_COROUTINES_DELAY32 27
+#define FEATURE_SCHEDULER_ONE_COROUTINE_COMPACT 28
+#define FEATURE_SCHEDULER_TWO_COROUTINES_COMPACT 29
+#define FEATURE_SCHEDULER_ONE_COROUTINE_DELAY8 30
+#define FEATURE_SCHEDULER_TWO_COROUTINES_DELAY8 31
+#define FEATURE_SCHEDULER_ONE_COROUTINE_SECTION 32
+#define FEATURE_SCHEDULER_TWO_COROUTINES_SECTION 33
+
+// Select the 32-bit delay fields, which must happen before AceRoutine.h.
+#if FEATURE == FEATURE_ONE_COROUTINE_DELAY32 \
+    || FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_DELAY32 \
+    || FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_DELAY32
+  #define ACE_ROUTINE_DELAY_BITS 32
+#endif
+
+// Select the compact layout, which must happen before AceRoutine.h.
+#if FEATURE >= FEATURE_SCHEDULER_ONE_COROUTINE_COMPACT \
+    && FEATURE <= FEATURE_SCHEDULER_TWO_COROUTINES_DELAY8
+  #define ACE_ROUTINE_COMPACT 1
+#endif
 
 #if FEATURE != FEATURE_BASELINE
   #include <AceRoutine.h>
@@ -430,6 +456,210 @@ volatile int disableCompilerOptimization = 0;
     }
   }
 
+#elif FEATURE == FEATURE_ONE_COROUTINE_SECONDS_DIVISION
+
+  // Same as FEATURE_ONE_COROUTINE_SECONDS, but using the division by 1000
+  // which ClockInterface::seconds() used before SecondsCounter.
+  class DivisionClock : public ClockInterface {
+    public:
+      static unsigned long seconds() { return ::millis() / 1000; }
+  };
+
+  class MyCoroutine : public CoroutineTemplate<DivisionClock> {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY_SECONDS(10);
+        }
+      }
+  };
+
+  MyCoroutine a;
+
+#elif FEATURE == FEATURE_ONE_COROUTINE_DELAY32
+
+  COROUTINE(a) {
+    COROUTINE_LOOP() {
+      disableCompilerOptimization = 1;
+      COROUTINE_DELAY(10);
+    }
+  }
+
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_DELAY32
+
+  class MyCoroutine : public Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutine a;
+
+#elif FEATURE == FEATURE_ONE_COROUTINE_CRTP
+
+  COROUTINE_CRTP(a) {
+    COROUTINE_LOOP() {
+      disableCompilerOptimization = 1;
+      COROUTINE_DELAY(10);
+    }
+  }
+
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_CRTP
+
+  class MyCoroutine : public CoroutineCrtp<MyCoroutine> {
+    public:
+      int runCoroutine() {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutine a;
+
+#elif FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_CRTP
+
+  class MyCoroutineA : public CoroutineCrtp<MyCoroutineA> {
+    public:
+      int runCoroutine() {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  class MyCoroutineB : public CoroutineCrtp<MyCoroutineB> {
+    public:
+      int runCoroutine() {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutineA a;
+  MyCoroutineB b;
+
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_COMPACT
+
+  class MyCoroutine : public Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutine a;
+
+#elif FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_DELAY32 \
+    || FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_COMPACT
+
+  class MyCoroutineA : public Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  class MyCoroutineB : public Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutineA a;
+  MyCoroutineB b;
+
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_DELAY8
+
+  using Delay8Coroutine = CoroutineTemplate<ClockInterface, uint8_t>;
+  using Delay8Scheduler = CoroutineSchedulerTemplate<Delay8Coroutine>;
+
+  class MyCoroutine : public Delay8Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutine a;
+
+#elif FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_DELAY8
+
+  using Delay8Coroutine = CoroutineTemplate<ClockInterface, uint8_t>;
+  using Delay8Scheduler = CoroutineSchedulerTemplate<Delay8Coroutine>;
+
+  class MyCoroutineA : public Delay8Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  class MyCoroutineB : public Delay8Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutineA a;
+  MyCoroutineB b;
+
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_SECTION \
+    && ACE_ROUTINE_HAS_SECTION_REGISTRY
+
+  COROUTINE_SECTION(a) {
+    COROUTINE_LOOP() {
+      disableCompilerOptimization = 1;
+      COROUTINE_DELAY(10);
+    }
+  }
+
+#elif FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_SECTION \
+    && ACE_ROUTINE_HAS_SECTION_REGISTRY
+
+  COROUTINE_SECTION(a) {
+    COROUTINE_LOOP() {
+      disableCompilerOptimization = 1;
+      COROUTINE_DELAY(10);
+    }
+  }
+
+  COROUTINE_SECTION(b) {
+    COROUTINE_LOOP() {
+      disableCompilerOptimization = 1;
+      COROUTINE_DELAY(10);
+    }
+  }
+
 #endif
 
 // TeensyDuino seems to pull in malloc() and free() when a class with virtual
@@ -458,8 +688,12 @@ void setup() {
   foo = new FooClass();
 #endif
 
-#if FEATURE >= FEATURE_SCHEDULER_ONE_COROUTINE \
-    && FEATURE <= FEATURE_SCHEDULER_MANUAL_SETUP_TWO_COROUTINES
+#if (FEATURE >= FEATURE_SCHEDULER_ONE_COROUTINE \
+    && FEATURE <= FEATURE_SCHEDULER_MANUAL_SETUP_TWO_COROUTINES) \
+    || FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_DELAY32 \
+    || FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_DELAY32 \
+    || FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_COMPACT \
+    || FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_COMPACT
    CoroutineScheduler::setup();
 
   #if FEATURE == FEATURE_SCHEDULER_SETUP_ONE_COROUTINE \
@@ -472,6 +706,16 @@ void setup() {
     b.setupCoroutine();
   #endif
 
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_CRTP \
+    || FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_CRTP
+  CoroutineCrtpScheduler::setup();
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_DELAY8 \
+    || FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_DELAY8
+  Delay8Scheduler::setup();
+#elif (FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_SECTION \
+    || FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_SECTION) \
+    && ACE_ROUTINE_HAS_SECTION_REGISTRY
+  SectionCoroutineScheduler::setup();
 #endif
 }
 
@@ -526,5 +770,35 @@ void loop() {
   blink.runCoroutine();
 #elif FEATURE == FEATURE_BLINK_FUNCTION
   blink();
+#elif FEATURE == FEATURE_ONE_COROUTINE_SECONDS_DIVISION
+  a.runCoroutine();
+#elif FEATURE == FEATURE_ONE_COROUTINE_DELAY32
+  a.runCoroutine();
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_DELAY32
+  CoroutineScheduler::loop();
+#elif FEATURE == FEATURE_ONE_COROUTINE_CRTP
+  a.runCoroutine();
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_CRTP
+  CoroutineCrtpScheduler::loop();
+#elif FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_CRTP
+  CoroutineCrtpScheduler::loop();
+#elif FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_DELAY32
+  CoroutineScheduler::loop();
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_COMPACT
+  CoroutineScheduler::loop();
+#elif FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_COMPACT
+  CoroutineScheduler::loop();
+#elif FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_DELAY8
+  Delay8Scheduler::loop();
+#elif FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_DELAY8
+  Delay8Scheduler::loop();
+#elif (FEATURE == FEATURE_SCHEDULER_ONE_COROUTINE_SECTION \
+    || FEATURE == FEATURE_SCHEDULER_TWO_COROUTINES_SECTION) \
+    && ACE_ROUTINE_HAS_SECTION_REGISTRY
+  SectionCoroutineScheduler::loop();
+#else
+  // The section registry is not available on AVR, so the SECTION features
+  // are the same as the baseline.
+  disableCompilerOptimization = 1;
 #endif
 }
@@ -117,6 +117,31 @@ calculated flash size can jump around in unexpected ways.
     * Add benchmarks for calling `CoroutineScheduler::setupCoroutine()`.
       Increases flash memory by 50-60 bytes *per coroutine* (AVR) and 30-40
       bytes per coroutine (32-bit processors).
+* Unreleased
+    * `ClockInterface::seconds()` uses a `SecondsCounter` instead of dividing
+      `millis()` by 1000 on processors without hardware division. Add
+      "One Coroutine (seconds, div)" which uses the old division, for
+      comparison with "One Coroutine (seconds)".
+    * Add "One Coroutine (delay32)" and "Scheduler, One Coroutine (delay32)",
+      the same as "One Coroutine" and "Scheduler, One Coroutine" but compiled
+      with `ACE_ROUTINE_DELAY_BITS` set to 32, which increases
+      `sizeof(Coroutine)` by 4 bytes on AVR.
+    * The `*.txt` files of the microcontrollers have not yet been collected
+      again with these rows, so the tables below do not show the cost of the
+      `SecondsCounter` or of the 32-bit delay fields on AVR, SAMD or ESP8266.
+    * Add "One Coroutine (crtp)", "Scheduler, One Coroutine (crtp)", and
+      "Scheduler, Two Coroutines (crtp)", the same as the corresponding
+      `Coroutine` benchmarks but using `CoroutineCrtp` and
+      `CoroutineCrtpScheduler`, which have no virtual methods and no vtables.
+    * Add "Scheduler, Two Coroutines (delay32)", "Scheduler, One/Two Coroutines
+      (compact)" compiled with `ACE_ROUTINE_COMPACT`, and "Scheduler, One/Two
+      Coroutines (delay8)" which also use `CoroutineTemplate<ClockInterface,
+      uint8_t>`. The difference between the "One" and "Two" rows of each
+      group is the cost of each additional coroutine in that layout.
+    * Add "Scheduler, One/Two Coroutines (section)" which use
+      `COROUTINE_SECTION()` and the `SectionCoroutineScheduler`. The section
+      registry is not available on AVR, so these rows are the same as the
+      "Baseline" on AVR boards.
 
 ## How to Generate
 
@@ -27,6 +27,19 @@ BEGIN {
   labels[18] = "Scheduler, Two Coroutines (man setup)"
   labels[19] = "Blink Function"
   labels[20] = "Blink Coroutine"
+  labels[21] = "One Coroutine (seconds, div)"
+  labels[22] = "One Coroutine (delay32)"
+  labels[23] = "Scheduler, One Coroutine (delay32)"
+  labels[24] = "One Coroutine (crtp)"
+  labels[25] = "Scheduler, One Coroutine (crtp)"
+  labels[26] = "Scheduler, Two Coroutines (crtp)"
+  labels[27] = "Scheduler, Two Coroutines (delay32)"
+  labels[28] = "Scheduler, One Coroutine (compact)"
+  labels[29] = "Scheduler, Two Coroutines (compact)"
+  labels[30] = "Scheduler, One Coroutine (delay8)"
+  labels[31] = "Scheduler, Two Coroutines (delay8)"
+  labels[32] = "Scheduler, One Coroutine (section)"
+  labels[33] = "Scheduler, Two Coroutines (section)"
   record_index = 0
 }
 {
@@ -58,6 +71,10 @@ END {
       || labels[i] ~ /^Scheduler, One Coroutine \(setup\)$/ \
       || labels[i] ~ /^Scheduler, One Coroutine \(man setup\)$/ \
       || labels[i] ~ /^Blink Function$/ \
+      || labels[i] ~ /^One Coroutine \(seconds, div\)$/ \
+      || labels[i] ~ /^One Coroutine \(crtp\)$/ \
+      || labels[i] ~ /^Scheduler, Two Coroutines \(delay32\)$/ \
+      || labels[i] ~ /^Scheduler, One Coroutine \(section\)$/ \
     ) {
       printf("|---------------------------------------+--------------+-------------|\n")
     }
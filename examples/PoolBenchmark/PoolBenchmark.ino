@@ -0,0 +1,124 @@
+/*
+ * This sketch measures the throughput of spawning short-lived coroutines from
+ * a CoroutinePool, running them to COROUTINE_END() under the
+ * CoroutineScheduler, and recycling them. Each task yields once, then ends.
+ *
+ * For comparison, the 'StaticReset' row does the same work with the same
+ * number of statically allocated coroutines, which are restarted using
+ * reset() after they terminate. This was the only way to reuse a coroutine
+ * without the heap before CoroutinePool.
+ *
+ * Each variant uses its own ClockInterface type, so that the coroutines are
+ * in separate linked lists.
+ */
+
+#include <Arduino.h>
+#include <AceRoutine.h>
+using namespace ace_routine;
+
+#if defined(ESP8266)
+const unsigned long DURATION = 1000;  // prevent watch dog timer exception
+#else
+const unsigned long DURATION = 3000;
+#endif
+
+// Number of tasks alive at the same time.
+const uint8_t NUM_TASKS = 8;
+
+class PoolClock: public ClockInterface {};
+class ResetClock: public ClockInterface {};
+
+template <typename T_CLOCK>
+class Task: public CoroutineTemplate<T_CLOCK> {
+  public:
+    Task() = default;
+
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      COROUTINE_YIELD();
+      COROUTINE_END();
+    }
+};
+
+using PoolScheduler = CoroutineSchedulerTemplate<CoroutineTemplate<PoolClock>>;
+using ResetScheduler =
+    CoroutineSchedulerTemplate<CoroutineTemplate<ResetClock>>;
+
+CoroutinePool<Task<PoolClock>, NUM_TASKS> pool;
+Task<ResetClock> staticTasks[NUM_TASKS];
+
+// Spawn NUM_TASKS tasks, then run the scheduler until all are recycled.
+// Return the number of tasks which were spawned.
+uint32_t runPool() {
+  uint32_t count = 0;
+  unsigned long start = millis();
+  yield();
+  while (millis() - start < DURATION) {
+    while (pool.spawn() != nullptr) count++;
+    while (pool.available() < NUM_TASKS) PoolScheduler::loop();
+  }
+  yield();
+  return count;
+}
+
+bool allTerminated() {
+  for (uint8_t i = 0; i < NUM_TASKS; i++) {
+    if (! staticTasks[i].isTerminated()) return false;
+  }
+  return true;
+}
+
+// Reset NUM_TASKS static tasks, then run the scheduler until all are
+// terminated. Return the number of tasks which were restarted.
+uint32_t runStaticReset() {
+  uint32_t count = 0;
+  unsigned long start = millis();
+  yield();
+  while (millis() - start < DURATION) {
+    for (uint8_t i = 0; i < NUM_TASKS; i++) {
+      staticTasks[i].reset();
+      count++;
+    }
+    do {
+      ResetScheduler::loop();
+    } while (! allTerminated());
+  }
+  yield();
+  return count;
+}
+
+void printStats(const __FlashStringHelper* name, uint32_t count) {
+  char buf[100];
+  unsigned long nanosPerTask = (count == 0)
+      ? 0 : (unsigned long) (DURATION * 1000000.0 / count);
+  sprintf(buf, " %9lu | %8lu |", (unsigned long) count, nanosPerTask);
+  Serial.print(name);
+  Serial.println(buf);
+}
+
+void setup() {
+#if ! defined(EPOXY_DUINO)
+  delay(1000);
+#endif
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  PoolScheduler::setup();
+  ResetScheduler::setup();
+
+  uint32_t poolCount = runPool();
+  uint32_t resetCount = runStaticReset();
+
+  Serial.println(F("-------------+-----------+----------+"));
+  Serial.println(F("      Method |     tasks | ns/task  |"));
+  Serial.println(F("-------------+-----------+----------+"));
+  printStats(F("        Pool |"), poolCount);
+  printStats(F(" StaticReset |"), resetCount);
+  Serial.println(F("-------------+-----------+----------+"));
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+void loop() {}
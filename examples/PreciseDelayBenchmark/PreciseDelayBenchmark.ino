@@ -0,0 +1,136 @@
+/*
+ * This sketch measures how late a coroutine wakes up from a 1000 micros delay,
+ * as a function of the number of other coroutines run by the
+ * CoroutineScheduler. Each of the other 'Filler' coroutines busy-waits 5
+ * micros, then yields.
+ *
+ *  - 'DelayMicros' uses COROUTINE_DELAY_MICROS(1000), which wakes up on the
+ *    first scheduler pass after the delay expires, so it can be late by up to
+ *    one pass through all the coroutines.
+ *  - 'Precise' uses COROUTINE_DELAY_MICROS_PRECISE(1000), where the scheduler
+ *    spins through the last GUARD_MICROS of the delay.
+ *
+ * The 'avg' and 'max' columns are the lateness in micros over NUM_SAMPLES
+ * delays.
+ */
+
+#include <Arduino.h>
+#include <AceRoutine.h>
+using namespace ace_routine;
+
+const uint8_t MAX_FILLERS = 64;
+const uint16_t NUM_SAMPLES = 200;
+const uint16_t DELAY_MICROS = 1000;
+
+// Longer than one pass through MAX_FILLERS coroutines.
+const uint16_t GUARD_MICROS = 400;
+
+// Simulates the work of another coroutine.
+class Filler : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        // Busy-wait, because delayMicroseconds() may sleep on EpoxyDuino.
+        unsigned long start = micros();
+        while (micros() - start < 5) {}
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+// Measures the lateness of NUM_SAMPLES delays, then ends.
+class Sampler : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (count = 0; count < NUM_SAMPLES; count++) {
+        start = micros();
+        if (precise) {
+          COROUTINE_DELAY_MICROS_PRECISE(DELAY_MICROS);
+        } else {
+          COROUTINE_DELAY_MICROS(DELAY_MICROS);
+        }
+        record(micros() - start - DELAY_MICROS);
+      }
+      COROUTINE_END();
+    }
+
+    void record(unsigned long lateness) {
+      total += lateness;
+      if (lateness > max) max = lateness;
+    }
+
+    void restart(bool isPrecise) {
+      precise = isPrecise;
+      total = 0;
+      max = 0;
+      reset();
+    }
+
+    bool precise = false;
+    uint16_t count = 0;
+    unsigned long start;
+    unsigned long total = 0;
+    unsigned long max = 0;
+};
+
+Filler fillers[MAX_FILLERS];
+Sampler sampler;
+
+// Run the sampler with the given number of fillers, until it ends.
+void runSampler(uint8_t numFillers, bool precise) {
+  for (uint8_t i = 0; i < MAX_FILLERS; i++) {
+    if (i < numFillers) {
+      fillers[i].resume();
+    } else {
+      fillers[i].suspend();
+    }
+  }
+  sampler.restart(precise);
+  while (! sampler.isTerminated()) {
+    CoroutineScheduler::loop();
+  }
+}
+
+void printResult(uint8_t numFillers) {
+  char buf[100];
+
+  runSampler(numFillers, false);
+  unsigned long delayAvg = sampler.total / NUM_SAMPLES;
+  unsigned long delayMax = sampler.max;
+
+  runSampler(numFillers, true);
+  unsigned long preciseAvg = sampler.total / NUM_SAMPLES;
+  unsigned long preciseMax = sampler.max;
+
+  sprintf(buf, " %10u | %5lu | %5lu | %5lu | %5lu |",
+      numFillers, delayAvg, delayMax, preciseAvg, preciseMax);
+  Serial.println(buf);
+}
+
+void setup() {
+#if ! defined(EPOXY_DUINO)
+  delay(1000);
+#endif
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  CoroutineScheduler::setup();
+  CoroutineScheduler::setSpinGuardMicros(GUARD_MICROS);
+
+  Serial.println(F("------------+---------------+---------------+"));
+  Serial.println(F("            |   DelayMicros |       Precise |"));
+  Serial.println(F(" coroutines |   avg |   max |   avg |   max |"));
+  Serial.println(F("------------+-------+-------+-------+-------+"));
+  printResult(0);
+  printResult(4);
+  printResult(16);
+  printResult(64);
+  Serial.println(F("------------+-------+-------+-------+-------+"));
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+void loop() {}
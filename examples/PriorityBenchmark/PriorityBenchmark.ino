@@ -0,0 +1,225 @@
+/*
+ * This sketch measures the wakeup latency of a latency-critical coroutine
+ * which shares the CPU with a dozen busy coroutines (e.g. logging, UI). The
+ * urgent coroutine is parked in COROUTINE_AWAIT_ON() until an event is
+ * signaled through WaitQueue::notify() at an arbitrary point in the
+ * scheduling pass. The latency is the time from the notify() to the moment
+ * the urgent coroutine resumes.
+ *
+ * With the CoroutineScheduler, the urgent coroutine waits for the rest of the
+ * pass through the busy coroutines. With the CoroutinePriorityScheduler, the
+ * urgent coroutine is given a higher priority and runs on the next call to
+ * loop().
+ *
+ * It then measures the cost of running a busy low priority coroutine while
+ * NUM_SLEEPERS high priority coroutines sleep in COROUTINE_DELAY(). The
+ * CoroutineScheduler visits every sleeper on each pass, while the
+ * CoroutinePriorityScheduler keeps them in its heap.
+ *
+ * Each scheduler runs its own copy of the coroutines, by using a different
+ * ClockInterface type for each, so that they are in separate linked lists.
+ */
+
+#include <Arduino.h>
+
+// Required by CoroutinePriorityScheduler. Must be defined before AceRoutine.h.
+#define ACE_ROUTINE_PRIORITIES 1
+
+#include <AceRoutine.h>
+using namespace ace_routine;
+
+#if defined(ESP8266)
+const unsigned long DURATION = 1000;  // prevent watch dog timer exception
+#else
+const unsigned long DURATION = 3000;
+#endif
+
+// Number of busy coroutines competing with the urgent coroutine.
+const uint8_t NUM_BUSY = 12;
+
+// Signal an event every TRIGGER_PERIOD calls to loop(). Relatively prime to
+// the number of coroutines so that the event arrives at every position of the
+// scheduling pass.
+const uint8_t TRIGGER_PERIOD = 7;
+
+// Number of high priority coroutines sleeping while a busy coroutine runs.
+const uint8_t NUM_SLEEPERS = 32;
+
+class RoundRobinClock: public ClockInterface {};
+class PriorityClock: public ClockInterface {};
+class SleepRoundRobinClock: public ClockInterface {};
+class SleepPriorityClock: public ClockInterface {};
+
+template <typename T_CLOCK>
+using PriorityScheduler =
+    CoroutinePrioritySchedulerTemplate<CoroutineTemplate<T_CLOCK>, NUM_SLEEPERS>;
+
+// Simulates a coroutine doing a small amount of work on each iteration.
+template <typename T_CLOCK>
+class BusyCoroutine: public CoroutineTemplate<T_CLOCK> {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        for (uint8_t i = 0; i < 20; i++) {
+          work++;
+        }
+        COROUTINE_YIELD();
+      }
+    }
+
+    volatile uint16_t work = 0;
+};
+
+// Waits for an event, then records the time taken to respond to it.
+template <typename T_CLOCK>
+class UrgentCoroutine: public CoroutineTemplate<T_CLOCK> {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT_ON(queue, triggered);
+        triggered = false;
+
+        uint32_t latency = micros() - triggerMicros;
+        totalLatency += latency;
+        if (latency > maxLatency) maxLatency = latency;
+        wakeups++;
+      }
+    }
+
+    /** Signal the event. */
+    void trigger() {
+      triggered = true;
+      triggerMicros = micros();
+      queue.notify();
+    }
+
+    WaitQueueTemplate<CoroutineTemplate<T_CLOCK>> queue;
+    bool triggered = false;
+    uint32_t triggerMicros = 0;
+    uint32_t totalLatency = 0;
+    uint32_t maxLatency = 0;
+    uint32_t wakeups = 0;
+};
+
+// Sleeps longer than the duration of the benchmark.
+template <typename T_CLOCK>
+class SleeperCoroutine: public CoroutineTemplate<T_CLOCK> {
+  public:
+    SleeperCoroutine() {
+      this->setPriority(PriorityScheduler<T_CLOCK>::kMaxPriority);
+    }
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(30000);
+      }
+    }
+};
+
+BusyCoroutine<RoundRobinClock> roundRobinBusy[NUM_BUSY];
+UrgentCoroutine<RoundRobinClock> roundRobinUrgent;
+
+BusyCoroutine<PriorityClock> priorityBusy[NUM_BUSY];
+UrgentCoroutine<PriorityClock> priorityUrgent;
+
+SleeperCoroutine<SleepRoundRobinClock> roundRobinSleepers[NUM_SLEEPERS];
+BusyCoroutine<SleepRoundRobinClock> roundRobinSleepBusy;
+
+SleeperCoroutine<SleepPriorityClock> prioritySleepers[NUM_SLEEPERS];
+BusyCoroutine<SleepPriorityClock> prioritySleepBusy;
+
+template <typename T_SCHEDULER, typename T_CLOCK>
+void measureLatency(UrgentCoroutine<T_CLOCK>& urgent) {
+  T_SCHEDULER::setup();
+
+  uint8_t count = 0;
+  unsigned long start = millis();
+  yield();
+  while (millis() - start < DURATION) {
+    T_SCHEDULER::loop();
+    if (++count >= TRIGGER_PERIOD) {
+      count = 0;
+      if (! urgent.triggered) urgent.trigger();
+    }
+  }
+  yield();
+}
+
+// Return the average time in nanos of each iteration of the busy coroutine.
+template <typename T_SCHEDULER, typename T_CLOCK>
+unsigned long measureBusy(BusyCoroutine<T_CLOCK>& busy) {
+  T_SCHEDULER::setup();
+
+  uint32_t iterations = 0;
+  uint16_t previous = busy.work;
+  unsigned long start = millis();
+  yield();
+  while (millis() - start < DURATION) {
+    T_SCHEDULER::loop();
+    uint16_t work = busy.work;
+    if (work != previous) {
+      previous = work;
+      iterations++;
+    }
+  }
+  yield();
+  return (iterations == 0) ? 0 : DURATION * 1000000 / iterations;
+}
+
+template <typename T_CLOCK>
+void printStats(
+    const __FlashStringHelper* name, const UrgentCoroutine<T_CLOCK>& urgent) {
+  char buf[100];
+  unsigned long avg100 = (urgent.wakeups == 0)
+      ? 0 : urgent.totalLatency * 100 / urgent.wakeups;
+  sprintf(buf, " %5lu.%02lu | %6lu |",
+      avg100 / 100, avg100 % 100, (unsigned long) urgent.maxLatency);
+  Serial.print(name);
+  Serial.println(buf);
+}
+
+void setup() {
+#if ! defined(EPOXY_DUINO)
+  delay(1000);
+#endif
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  priorityUrgent.setPriority(PriorityScheduler<PriorityClock>::kMaxPriority);
+
+  measureLatency<CoroutineSchedulerTemplate<
+      CoroutineTemplate<RoundRobinClock>>>(roundRobinUrgent);
+  measureLatency<PriorityScheduler<PriorityClock>>(priorityUrgent);
+  unsigned long roundRobinBusyNanos = measureBusy<CoroutineSchedulerTemplate<
+      CoroutineTemplate<SleepRoundRobinClock>>>(roundRobinSleepBusy);
+  unsigned long priorityBusyNanos =
+      measureBusy<PriorityScheduler<SleepPriorityClock>>(prioritySleepBusy);
+
+  Serial.println(
+      F("------------+----------+--------+"));
+  Serial.println(
+      F("  Scheduler | avg (us) | max us |"));
+  Serial.println(
+      F("------------+----------+--------+"));
+  printStats(F(" RoundRobin |"), roundRobinUrgent);
+  printStats(F("   Priority |"), priorityUrgent);
+  Serial.println(
+      F("------------+----------+--------+"));
+
+  Serial.println();
+  Serial.println(
+      F("------------+-------------+"));
+  Serial.println(
+      F("  Scheduler | busy run ns |"));
+  Serial.println(
+      F("------------+-------------+"));
+  char buf[100];
+  sprintf(buf, " RoundRobin | %11lu |", roundRobinBusyNanos);
+  Serial.println(buf);
+  sprintf(buf, "   Priority | %11lu |", priorityBusyNanos);
+  Serial.println(buf);
+  Serial.println(
+      F("------------+-------------+"));
+}
+
+void loop() {}
@@ -0,0 +1,119 @@
+/*
+ * This sketch measures the throughput of an SpscChannel between a writer
+ * coroutine and a reader coroutine running on 2 different threads, for several
+ * sizes of the ring buffer. Each thread runs its coroutine directly (see
+ * "Direct Scheduling" in the USER_GUIDE.md) until all messages are sent or
+ * received. Each thread yields its CPU after every call to runCoroutine(), so
+ * that the benchmark also works on a single-core machine.
+ *
+ * Supported only on EpoxyDuino (Linux, MacOS), where std::thread is available.
+ */
+
+#include <Arduino.h>
+#include <AceRoutine.h>
+using namespace ace_routine;
+
+#if defined(EPOXY_DUINO)
+
+#include <thread>
+
+const uint32_t NUM_MESSAGES = 1000000;
+
+template <uint16_t N>
+class Writer: public Coroutine {
+  public:
+    explicit Writer(SpscChannel<uint32_t, N>& channel) : mChannel(channel) {}
+
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (mCount = 0; mCount < NUM_MESSAGES; mCount++) {
+        COROUTINE_CHANNEL_WRITE(mChannel, mCount);
+      }
+      COROUTINE_END();
+    }
+
+  private:
+    SpscChannel<uint32_t, N>& mChannel;
+    uint32_t mCount = 0;
+};
+
+template <uint16_t N>
+class Reader: public Coroutine {
+  public:
+    explicit Reader(SpscChannel<uint32_t, N>& channel) : mChannel(channel) {}
+
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (mCount = 0; mCount < NUM_MESSAGES; mCount++) {
+        COROUTINE_CHANNEL_READ(mChannel, mValue);
+        if (mValue != mCount) errors++;
+      }
+      COROUTINE_END();
+    }
+
+    uint32_t errors = 0;
+
+  private:
+    SpscChannel<uint32_t, N>& mChannel;
+    uint32_t mCount = 0;
+    uint32_t mValue = 0;
+};
+
+template <uint16_t N>
+void runBenchmark() {
+  static SpscChannel<uint32_t, N> channel;
+  static Writer<N> writer(channel);
+  static Reader<N> reader(channel);
+
+  unsigned long start = micros();
+  std::thread readerThread([]() {
+    while (! reader.isDone()) {
+      reader.runCoroutine();
+      std::this_thread::yield();
+    }
+  });
+  while (! writer.isDone()) {
+    writer.runCoroutine();
+    std::this_thread::yield();
+  }
+  readerThread.join();
+  unsigned long elapsed = micros() - start;
+
+  char buf[100];
+  unsigned long messagesPerSecond = (elapsed == 0)
+      ? 0 : (unsigned long) (NUM_MESSAGES * 1000000.0 / elapsed);
+  sprintf(buf, " %5u | %8lu | %10lu | %6lu |",
+      (unsigned) N, elapsed / 1000, messagesPerSecond,
+      (unsigned long) reader.errors);
+  Serial.println(buf);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  Serial.println(F("-------+----------+------------+--------+"));
+  Serial.println(F("  size |   millis |    msg/sec | errors |"));
+  Serial.println(F("-------+----------+------------+--------+"));
+  runBenchmark<1>();
+  runBenchmark<4>();
+  runBenchmark<16>();
+  runBenchmark<64>();
+  runBenchmark<256>();
+  runBenchmark<1024>();
+  Serial.println(F("-------+----------+------------+--------+"));
+
+  exit(0);
+}
+
+#else
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+  Serial.println(F("SpscChannelBenchmark requires EpoxyDuino"));
+}
+
+#endif
+
+void loop() {}
@@ -0,0 +1,111 @@
+/*
+ * This sketch measures the throughput of the CoroutineWorkStealingScheduler
+ * on a large number of CPU-bound coroutines. Each coroutine does a fixed
+ * amount of busy work between yields, then terminates. The same coroutines are
+ * run with 1, 2, ... N_MAX_WORKERS threads, and the elapsed time and speedup
+ * relative to 1 thread is printed.
+ *
+ * Supported only on EpoxyDuino (Linux, MacOS) and ESP32.
+ */
+
+#include <Arduino.h>
+#include <AceRoutine.h>
+#include <ace_routine/CoroutineWorkStealingScheduler.h>
+using namespace ace_routine;
+
+#if defined(EPOXY_DUINO) || defined(ESP32)
+
+#if defined(ESP32)
+const uint16_t NUM_COROUTINES = 200;
+const uint8_t MAX_WORKERS = 2;
+#else
+const uint16_t NUM_COROUTINES = 2000;
+const uint8_t MAX_WORKERS = 8;
+#endif
+
+// Number of yields of each coroutine before it terminates.
+const uint16_t NUM_YIELDS = 20;
+
+// Number of iterations of busy work between yields.
+const uint16_t WORK = 2000;
+
+using Scheduler = CoroutineWorkStealingSchedulerTemplate<
+    Coroutine, MAX_WORKERS>;
+
+class BusyCoroutine: public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (i = 0; i < NUM_YIELDS; i++) {
+        for (uint16_t j = 0; j < WORK; j++) {
+          // Simple LCG, kept opaque to the compiler by the volatile.
+          state = state * 1664525 + 1013904223;
+        }
+        COROUTINE_YIELD();
+      }
+      COROUTINE_END();
+    }
+
+    volatile uint32_t state = 1;
+    uint16_t i = 0;
+};
+
+BusyCoroutine coroutines[NUM_COROUTINES];
+
+// Run all coroutines to completion using numWorkers threads. Return the
+// elapsed time in millis.
+unsigned long runAll(uint8_t numWorkers) {
+  for (uint16_t i = 0; i < NUM_COROUTINES; i++) {
+    coroutines[i].reset();
+  }
+  Scheduler::setup(numWorkers);
+
+  unsigned long start = millis();
+  Scheduler::start();
+  while (Scheduler::getNumActive() > 0) {
+    delay(1);
+  }
+  unsigned long elapsed = millis() - start;
+  Scheduler::stop();
+  return elapsed;
+}
+
+void setup() {
+#if ! defined(EPOXY_DUINO)
+  delay(1000);
+#endif
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  Serial.println(F("---------+-------------+---------+"));
+  Serial.println(F(" threads | millis      | speedup |"));
+  Serial.println(F("---------+-------------+---------+"));
+
+  char buf[100];
+  unsigned long base = 0;
+  for (uint8_t n = 1; n <= MAX_WORKERS; n++) {
+    unsigned long elapsed = runAll(n);
+    if (n == 1) base = elapsed;
+    unsigned long speedup100 = (elapsed == 0) ? 0 : base * 100 / elapsed;
+    sprintf(buf, " %7u | %11lu | %4lu.%02lu |",
+        (unsigned) n, elapsed, speedup100 / 100, speedup100 % 100);
+    Serial.println(buf);
+  }
+  Serial.println(F("---------+-------------+---------+"));
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+#else
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+  Serial.println(F("WorkStealingBenchmark requires EpoxyDuino or ESP32"));
+}
+
+#endif
+
+void loop() {}
@@ -48,6 +48,19 @@ SOFTWARE.
 
 #include "ace_routine/Coroutine.h"
 #include "ace_routine/CoroutineScheduler.h"
+#include "ace_routine/CoroutineDeadlineScheduler.h"
+#include "ace_routine/CoroutinePriorityScheduler.h"
+#include "ace_routine/CoroutineEdfScheduler.h"
+#include "ace_routine/WaitQueue.h"
+#include "ace_routine/CoroutineGroup.h"
+#include "ace_routine/CoroutinePartition.h"
+#include "ace_routine/CoroutinePool.h"
+#include "ace_routine/StaticCoroutineScheduler.h"
+#include "ace_routine/CyclicExecutiveScheduler.h"
+#include "ace_routine/CoroutineCrtp.h"
+#include "ace_routine/CoroutineRegistryScheduler.h"
+#include "ace_routine/SectionCoroutine.h"
 #include "ace_routine/Channel.h"
+#include "ace_routine/SpscChannel.h"
 
 #endif
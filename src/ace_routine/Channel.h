@@ -3,17 +3,26 @@
 
 #include <stdint.h>
 #include "Coroutine.h"
+#include "WaitQueue.h"
 
-/** Write the given value x to the given channel within a Coroutine. */
+/**
+ * Write the given value x to the given channel within a Coroutine. The
+ * coroutine is parked on the WaitQueue of the channel until the reader is
+ * ready.
+ */
 #define COROUTINE_CHANNEL_WRITE(channel, x) \
 do { \
   (channel).setValue(x); \
-  COROUTINE_AWAIT((channel).write()); \
+  COROUTINE_AWAIT_ON((channel).getWaitQueue(), (channel).write()); \
 } while (false)
 
-/** Read the value in the channel to variable x within a Coroutine. */
+/**
+ * Read the value in the channel to variable x within a Coroutine. The
+ * coroutine is parked on the WaitQueue of the channel until the writer is
+ * ready.
+ */
 #define COROUTINE_CHANNEL_READ(channel, x) \
-  COROUTINE_AWAIT((channel).read(x))
+  COROUTINE_AWAIT_ON((channel).getWaitQueue(), (channel).read(x))
 
 namespace ace_routine {
 
@@ -38,8 +47,17 @@ namespace ace_routine {
  * @endcode
  *
  * This sequence of events matches the user's expectations.
+ *
+ * Every change of the internal state calls WaitQueue::notify(), so that a
+ * reader or writer parked by COROUTINE_CHANNEL_READ() or
+ * COROUTINE_CHANNEL_WRITE() is not run again until the other side has made
+ * progress.
+ *
+ * @tparam T type of the value sent through the channel
+ * @tparam T_COROUTINE class of the reader and writer coroutines, usually
+ *    `Coroutine`
  */
-template<typename T>
+template<typename T, typename T_COROUTINE = Coroutine>
 class Channel {
   public:
     /** Constructor. */
@@ -54,6 +72,13 @@ class Channel {
       mValueToWrite = value;
     }
 
+    /**
+     * Return the WaitQueue used by COROUTINE_CHANNEL_WRITE() and
+     * COROUTINE_CHANNEL_READ() to park the writer and the reader. Not designed
+     * to be used directly by the user.
+     */
+    WaitQueueTemplate<T_COROUTINE>& getWaitQueue() { return mWaitQueue; }
+
     /**
      * Same as write(constT& value) except use the value of setValue(). Used by
      * COROUTINE_CHANNEL_WRITE() macro. Not designed to be used directly by the
@@ -66,11 +91,13 @@ class Channel {
         case kReaderReady:
           mValue = mValueToWrite;
           mChannelState = kDataProduced;
+          mWaitQueue.notify();
           return false;
         case kDataProduced:
           return false;
         case kDataConsumed:
           mChannelState = kWriterReady;
+          mWaitQueue.notify();
           return true;
         default:
           return false;
@@ -88,11 +115,13 @@ class Channel {
         case kReaderReady:
           mValue = value;
           mChannelState = kDataProduced;
+          mWaitQueue.notify();
           return false;
         case kDataProduced:
           return false;
         case kDataConsumed:
           mChannelState = kWriterReady;
+          mWaitQueue.notify();
           return true;
         default:
           return false;
@@ -107,12 +136,14 @@ class Channel {
       switch (mChannelState) {
         case kWriterReady:
           mChannelState = kReaderReady;
+          mWaitQueue.notify();
           return false;
         case kReaderReady:
           return false;
         case kDataProduced:
           value = mValue;
           mChannelState = kDataConsumed;
+          mWaitQueue.notify();
           return true;
         case kDataConsumed:
           return false;
@@ -134,6 +165,7 @@ class Channel {
     uint8_t mChannelState = kWriterReady;
     T mValue;
     T mValueToWrite;
+    WaitQueueTemplate<T_COROUTINE> mWaitQueue;
 };
 
 }
@@ -30,6 +30,61 @@ SOFTWARE.
 
 namespace ace_routine {
 
+/**
+ * Converts a millis clock into seconds incrementally, without the software long
+ * division by 1000 which is expensive in flash and CPU on processors without a
+ * hardware division instruction. Each call to update() advances the seconds
+ * counter by the number of whole seconds which have passed since the previous
+ * second boundary, using a loop of subtractions which runs at most once when
+ * update() is called at least once a second. After a gap of kMaxLoopSeconds or
+ * more, a binary long division by shifts and subtractions is used instead, so
+ * that catching up after several minutes takes 23 steps instead of thousands
+ * of iterations, still without the division routine of the compiler.
+ *
+ * Unlike `millis() / 1000`, the counter does not jump backwards when the 32-bit
+ * millis() clock rolls over after 49.7 days, so seconds are always exactly 1000
+ * millis long. It does lose time if update() is not called for 49.7 days.
+ */
+class SecondsCounter {
+  public:
+    /** Advance the counter to nowMillis, and return the seconds. */
+    uint32_t update(uint32_t nowMillis) {
+      uint32_t elapsed = nowMillis - mSecondMillis;
+      if (elapsed >= kMaxLoopSeconds * 1000) {
+        // Find one bit of the quotient per step, starting from 1000 << 22,
+        // the largest multiple of 1000 by a power of 2 which fits in 32 bits.
+        uint32_t stepSeconds = (uint32_t) 1 << 22;
+        uint32_t stepMillis = 1000 * stepSeconds;
+        while (stepSeconds != 0) {
+          if (elapsed >= stepMillis) {
+            elapsed -= stepMillis;
+            mSecondMillis += stepMillis;
+            mSeconds += stepSeconds;
+          }
+          stepSeconds >>= 1;
+          stepMillis >>= 1;
+        }
+        return mSeconds;
+      }
+      while (elapsed >= 1000) {
+        elapsed -= 1000;
+        mSecondMillis += 1000;
+        mSeconds++;
+      }
+      return mSeconds;
+    }
+
+  private:
+    /** Largest gap, in seconds, handled by the loop of subtractions. */
+    static const uint32_t kMaxLoopSeconds = 4;
+
+    /** The millis() at the start of the current second. */
+    uint32_t mSecondMillis = 0;
+
+    /** Number of seconds since millis() was 0. */
+    uint32_t mSeconds = 0;
+};
+
 /**
  * A utility class (all methods are static) that provides a layer of indirection
  * to Arduino clock functions (millis() and micros()). This thin layer of
@@ -46,23 +101,233 @@ class ClockInterface {
     static unsigned long micros() { return ::micros(); }
 
     /**
-     * Get the current seconds. This is derived by dividing millis() by 1000,
-     * which works pretty well until the `unsigned long` rolls over at
+     * Get the current seconds.
+     *
+     * On processors without a hardware division instruction (AVR, ARM
+     * Cortex-M0/M0+ such as the SAMD21, and the ESP8266), this is maintained
+     * incrementally from millis() by a SecondsCounter, which avoids the
+     * software long division by 1000 on every call. That division used to add
+     * about 150 bytes of flash on AVR processors, and a few microseconds to
+     * every isDelaySecondsExpired().
+     *
+     * On the other processors (e.g. ESP32, Cortex-M3/M4 such as STM32 and
+     * Teensy, and EpoxyDuino), which have fast hardware division, and some of
+     * which run coroutines on multiple threads (see
+     * CoroutineWorkStealingScheduler), the seconds are derived by dividing
+     * millis() by 1000, which needs no shared state. This works pretty well
+     * until the `unsigned long` rolls over at
      * 4294967296 milliseconds. At that last second (4294967), this function
-     * returns the next second (0) a little bit too early. More precisely, it
-     * rolls over to 0 seconds 704 milliseconds too early. If the
+     * returns the next second (0) 704 milliseconds too early. If the
      * COROUTINE_DELAY_SECONDS() is large enough, this inaccuracy should not
      * matter too much.
-     *
-     * The other problem with this function is that on 8-bit processors without
-     * a hardware division instruction, the software long division by 1000 is
-     * very expensive in both memory and CPU. The flash memory increases by
-     * about 150 bytes on AVR processors. Therefore, the
-     * COROUTINE_DELAY_SECONDS() should be used sparingly.
      */
-    static unsigned long seconds() { return ::millis() / 1000; }
+    static unsigned long seconds() {
+    #if defined(ARDUINO_ARCH_AVR) || defined(__AVR__) \
+        || defined(__ARM_ARCH_6M__) || defined(ESP8266)
+      static SecondsCounter counter;
+      return counter.update(::millis());
+    #else
+      return ::millis() / 1000;
+    #endif
+    }
+};
+
+/**
+ * Calls the optional methods of a clock policy T_CLOCK, falling back to the
+ * required millis(), micros() and seconds() if T_CLOCK does not provide them,
+ * so that a custom clock such as ClockInterface only needs those 3 methods.
+ *
+ *   * snapshot() is called by the schedulers at the start of each pass. It
+ *     does nothing by default.
+ *   * liveMillis(), liveMicros() and liveSeconds() read the clock without
+ *     using a value cached during the pass, to stamp the start of a delay.
+ *     They return millis(), micros() and seconds() by default.
+ *   * nanos() is used by COROUTINE_DELAY_NANOS(). It returns micros() * 1000
+ *     by default.
+ */
+template <typename T_CLOCK>
+class ClockTraits {
+  public:
+    /** Call T_CLOCK::snapshot() if it exists. */
+    static void snapshot() { doSnapshot<T_CLOCK>(0); }
+
+    /** Call T_CLOCK::liveMillis() if it exists, otherwise millis(). */
+    static auto liveMillis() -> decltype(T_CLOCK::millis()) {
+      return doLiveMillis<T_CLOCK>(0);
+    }
+
+    /** Call T_CLOCK::liveMicros() if it exists, otherwise micros(). */
+    static auto liveMicros() -> decltype(T_CLOCK::micros()) {
+      return doLiveMicros<T_CLOCK>(0);
+    }
+
+    /** Call T_CLOCK::liveSeconds() if it exists, otherwise seconds(). */
+    static auto liveSeconds() -> decltype(T_CLOCK::seconds()) {
+      return doLiveSeconds<T_CLOCK>(0);
+    }
+
+    /** Call T_CLOCK::nanos() if it exists, otherwise micros() * 1000. */
+    static auto nanos() -> decltype(T_CLOCK::micros()) {
+      return doNanos<T_CLOCK>(0);
+    }
+
+  private:
+    // The (int) overloads are preferred for the argument 0, but are removed by
+    // SFINAE if T does not have the method, leaving the (long) fallbacks.
+
+    template <typename T>
+    static auto doSnapshot(int) -> decltype(T::snapshot()) {
+      return T::snapshot();
+    }
+
+    template <typename T>
+    static void doSnapshot(long) {}
+
+    template <typename T>
+    static auto doLiveMillis(int) -> decltype(T::liveMillis()) {
+      return T::liveMillis();
+    }
+
+    template <typename T>
+    static auto doLiveMillis(long) -> decltype(T::millis()) {
+      return T::millis();
+    }
+
+    template <typename T>
+    static auto doLiveMicros(int) -> decltype(T::liveMicros()) {
+      return T::liveMicros();
+    }
+
+    template <typename T>
+    static auto doLiveMicros(long) -> decltype(T::micros()) {
+      return T::micros();
+    }
+
+    template <typename T>
+    static auto doLiveSeconds(int) -> decltype(T::liveSeconds()) {
+      return T::liveSeconds();
+    }
+
+    template <typename T>
+    static auto doLiveSeconds(long) -> decltype(T::seconds()) {
+      return T::seconds();
+    }
+
+    template <typename T>
+    static auto doNanos(int) -> decltype(T::nanos()) {
+      return T::nanos();
+    }
+
+    template <typename T>
+    static auto doNanos(long) -> decltype(T::micros()) {
+      return T::micros() * 1000;
+    }
+};
+
+/**
+ * A clock policy which reads the underlying T_CLOCK at most once per
+ * scheduler pass, and returns the cached value to every coroutine in that
+ * pass. On AVR processors, each call to ::millis() or ::micros() disables
+ * interrupts and reads the timer, which dominates the cost of a pass through
+ * many coroutines sleeping in COROUTINE_DELAY(). With this policy,
+ * isDelayExpired() (and its micros and seconds variants) read the cached
+ * value instead. The start of a delay is still read from T_CLOCK, through
+ * liveMillis() and friends, because the cached value can be a whole pass old
+ * when the coroutine runs, which would make the delay expire early.
+ *
+ * Enable it by using it as the T_CLOCK of the coroutines and the scheduler:
+ *
+ * @code
+ * using SnapshotCoroutine = CoroutineTemplate<SnapshotClockInterface<>>;
+ * using SnapshotScheduler = CoroutineSchedulerTemplate<SnapshotCoroutine>;
+ * @endcode
+ *
+ * The CoroutineScheduler calls snapshot() at the start of each pass through
+ * the linked list, and before each coroutine in loopFor(). The
+ * CoroutineDeadlineScheduler and CoroutinePriorityScheduler call it on each
+ * loop(). Coroutines which are run directly must call snapshot()
+ * themselves. The clocks are read lazily by the first caller in each pass, so
+ * a pass in which no coroutine needs the micros() clock does not read it.
+ *
+ * A delay is checked against the snapshot of each pass, so it can expire up to
+ * one pass late, but never early. It must not be used with the
+ * CoroutineWorkStealingScheduler, because the cached values are shared by all
+ * threads.
+ *
+ * @tparam T_CLOCK the underlying clock, usually `ClockInterface`
+ */
+template <typename T_CLOCK = ClockInterface>
+class SnapshotClockInterface {
+  public:
+    /** Get the millis at the first call in the current pass. */
+    static unsigned long millis() {
+      if (! (sValid & kValidMillis)) return liveMillis();
+      return sMillis;
+    }
+
+    /** Get the micros at the first call in the current pass. */
+    static unsigned long micros() {
+      if (! (sValid & kValidMicros)) return liveMicros();
+      return sMicros;
+    }
+
+    /** Get the seconds at the first call in the current pass. */
+    static unsigned long seconds() {
+      if (! (sValid & kValidSeconds)) return liveSeconds();
+      return sSeconds;
+    }
+
+    /**
+     * Read the millis of T_CLOCK, and cache it for the rest of the pass, so
+     * that millis() never returns a value earlier than a delay started with
+     * liveMillis().
+     */
+    static unsigned long liveMillis() {
+      sMillis = T_CLOCK::millis();
+      sValid |= kValidMillis;
+      return sMillis;
+    }
+
+    /** Read the micros of T_CLOCK, like liveMillis(). */
+    static unsigned long liveMicros() {
+      sMicros = T_CLOCK::micros();
+      sValid |= kValidMicros;
+      return sMicros;
+    }
+
+    /** Read the seconds of T_CLOCK, like liveMillis(). */
+    static unsigned long liveSeconds() {
+      sSeconds = T_CLOCK::seconds();
+      sValid |= kValidSeconds;
+      return sSeconds;
+    }
+
+    /** Discard the cached values, so that the next call reads T_CLOCK. */
+    static void snapshot() { sValid = 0; }
+
+  private:
+    static const uint8_t kValidMillis = 0x1;
+    static const uint8_t kValidMicros = 0x2;
+    static const uint8_t kValidSeconds = 0x4;
+
+    static uint8_t sValid;
+    static unsigned long sMillis;
+    static unsigned long sMicros;
+    static unsigned long sSeconds;
 };
 
+template <typename T_CLOCK>
+uint8_t SnapshotClockInterface<T_CLOCK>::sValid;
+
+template <typename T_CLOCK>
+unsigned long SnapshotClockInterface<T_CLOCK>::sMillis;
+
+template <typename T_CLOCK>
+unsigned long SnapshotClockInterface<T_CLOCK>::sMicros;
+
+template <typename T_CLOCK>
+unsigned long SnapshotClockInterface<T_CLOCK>::sSeconds;
+
 }
 
 #endif
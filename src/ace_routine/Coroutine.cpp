@@ -40,6 +40,7 @@ static const char kStatusDelayingString[] PROGMEM = "Delaying";
 static const char kStatusRunningString[] PROGMEM = "Running";
 static const char kStatusEndingString[] PROGMEM = "Ending";
 static const char kStatusTerminatedString[] PROGMEM = "Terminated";
+static const char kStatusWaitingString[] PROGMEM = "Waiting";
 #if 0
 const __FlashStringHelper* const sStatusStrings[] = {
 #else
@@ -51,6 +52,7 @@ const __FlashStringHelper* const sStatusStrings[] PROGMEM = {
   FPSTR(kStatusRunningString),
   FPSTR(kStatusEndingString),
   FPSTR(kStatusTerminatedString),
+  FPSTR(kStatusWaitingString),
 };
 #endif
 }
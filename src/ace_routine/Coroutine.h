@@ -62,6 +62,129 @@ class SuspendTest_suspendAndResume;
   #define ACE_ROUTINE_DEPRECATED
 #endif
 
+/**
+ * If set to 1, selects the compact layout of a Coroutine for processors with
+ * very little static RAM, by changing the defaults of
+ * ACE_ROUTINE_COMPACT_STATUS, ACE_ROUTINE_LINE_NUMBER and ACE_ROUTINE_NAMES.
+ * Each of those can still be set individually. Like all the macros below, it
+ * must be defined before the first `#include <AceRoutine.h>`, and must be the
+ * same in every translation unit.
+ */
+#if ! defined(ACE_ROUTINE_COMPACT)
+  #define ACE_ROUTINE_COMPACT 0
+#endif
+
+/**
+ * If set to 1, the Status is a small integer instead of 4 ASCII characters,
+ * and it is packed with the unit of the delay into a single byte. Saves 4
+ * bytes of static RAM per coroutine. Defaults to ACE_ROUTINE_COMPACT.
+ */
+#if ! defined(ACE_ROUTINE_COMPACT_STATUS)
+  #define ACE_ROUTINE_COMPACT_STATUS ACE_ROUTINE_COMPACT
+#endif
+
+/**
+ * If set to 1 (the default unless ACE_ROUTINE_COMPACT), each COROUTINE_YIELD(),
+ * COROUTINE_DELAY(), COROUTINE_AWAIT() and COROUTINE_END() records its source
+ * line number, which is printed by CoroutineScheduler::list(). Setting it to 0
+ * saves 2 bytes of static RAM per coroutine, and a store instruction at each
+ * of those macros.
+ */
+#if ! defined(ACE_ROUTINE_LINE_NUMBER)
+  #define ACE_ROUTINE_LINE_NUMBER (! ACE_ROUTINE_COMPACT)
+#endif
+
+/**
+ * If set to 1 (the default unless ACE_ROUTINE_COMPACT), the COROUTINE() macro
+ * overrides printName() to print the name of the coroutine. Setting it to 0
+ * removes the name strings from flash memory, and printName() prints '?'.
+ */
+#if ! defined(ACE_ROUTINE_NAMES)
+  #define ACE_ROUTINE_NAMES (! ACE_ROUTINE_COMPACT)
+#endif
+
+/**
+ * If set to 1, each Coroutine stores the predicate of its
+ * COROUTINE_AWAIT_PREDICATE(), so that the CoroutineScheduler evaluates it
+ * without resuming the coroutine. This costs 2 pointers of static RAM per
+ * coroutine, and a check of the predicate on each dispatch of a Yielding
+ * coroutine. Defaults to 0, in which case the coroutine evaluates its own
+ * predicate like COROUTINE_AWAIT().
+ */
+#if ! defined(ACE_ROUTINE_AWAIT_PREDICATE)
+  #define ACE_ROUTINE_AWAIT_PREDICATE 0
+#endif
+
+/**
+ * If set to 1, each Coroutine remembers the CoroutinePartition which runs it,
+ * so that resume(), reset() and WaitQueue::notify() put it back into the
+ * linked list of its partition. Required by CoroutinePartition::add(). Costs
+ * 1 pointer of static RAM per coroutine. Defaults to 0.
+ */
+#if ! defined(ACE_ROUTINE_PARTITIONS)
+  #define ACE_ROUTINE_PARTITIONS 0
+#endif
+
+/**
+ * If set to 1, each Coroutine stores the dataflow rank assigned by
+ * CoroutineScheduler::setDependencies(), which requires it. Costs 1 byte of
+ * static RAM per coroutine, often more with padding. Defaults to 0.
+ */
+#if ! defined(ACE_ROUTINE_DEPENDENCIES)
+  #define ACE_ROUTINE_DEPENDENCIES 0
+#endif
+
+/**
+ * If set to 1, each Coroutine stores the priority level set by
+ * setPriority(), which is required by the CoroutinePriorityScheduler. Costs 1
+ * byte of static RAM per coroutine, often more with padding. Defaults to 0.
+ */
+#if ! defined(ACE_ROUTINE_PRIORITIES)
+  #define ACE_ROUTINE_PRIORITIES 0
+#endif
+
+/**
+ * The default size in bits of Coroutine::mDelayStart and
+ * Coroutine::mDelayDuration, either 8, 16 (the default), 32 or 64. With 16
+ * bits, the maximum delay of COROUTINE_DELAY(), COROUTINE_DELAY_MICROS(), and
+ * COROUTINE_DELAY_SECONDS() is 32767 units. With 32 bits, it is 2147483647
+ * units, at the cost of 4 extra bytes of static RAM per coroutine and some
+ * flash on 8-bit processors. With 8 bits, it is only 127 units, but saves 2
+ * bytes per coroutine. 64 bits is meant for the 64-bit clocks of
+ * HighResClockInterface.h, which never roll over. The delay fields must not be
+ * wider than the values returned by the clock, otherwise the elapsed time no
+ * longer wraps around when the clock rolls over, and delays expire early. So
+ * 64 bits fails to compile with the default ClockInterface wherever
+ * `unsigned long` is 32 bits, i.e. on all Arduino processors. The size can
+ * also be selected for each coroutine class through the T_DELAY template
+ * parameter of CoroutineTemplate.
+ */
+#if ! defined(ACE_ROUTINE_DELAY_BITS)
+  #define ACE_ROUTINE_DELAY_BITS 16
+#endif
+
+#if ACE_ROUTINE_DELAY_BITS != 8 \
+    && ACE_ROUTINE_DELAY_BITS != 16 \
+    && ACE_ROUTINE_DELAY_BITS != 32 \
+    && ACE_ROUTINE_DELAY_BITS != 64
+  #error ACE_ROUTINE_DELAY_BITS must be 8, 16, 32 or 64
+#endif
+
+#if ACE_ROUTINE_NAMES
+  /** Internal helper macro to declare the printName() of a COROUTINE(). */
+  #define ACE_ROUTINE_NAME_DECL(specifier) \
+      void printName(Print* pPrinter) specifier;
+
+  /** Internal helper macro to define the printName() of a COROUTINE(). */
+  #define ACE_ROUTINE_NAME_DEF(className, name) \
+      void className::printName(Print* pPrinter) { \
+        pPrinter->print(F(name)); \
+      }
+#else
+  #define ACE_ROUTINE_NAME_DECL(specifier)
+  #define ACE_ROUTINE_NAME_DEF(className, name)
+#endif
+
 /**
  * Create a Coroutine instance named 'name'. Two forms are supported
  *
@@ -85,28 +208,24 @@ class SuspendTest_suspendAndResume;
 #define COROUTINE1(name) \
 struct Coroutine_##name : ace_routine::Coroutine { \
   Coroutine_##name(); \
-  void printName(Print* pPrinter) override; \
+  ACE_ROUTINE_NAME_DECL(override) \
   int runCoroutine() override; \
 } name; \
 Coroutine_##name :: Coroutine_##name() { \
 } \
-void Coroutine_##name::printName(Print* pPrinter) { \
-  pPrinter->print(F("Coroutine_" #name)); \
-} \
+ACE_ROUTINE_NAME_DEF(Coroutine_##name, "Coroutine_" #name) \
 int Coroutine_##name :: runCoroutine()
 
 /** Implement the 2-argument COROUTINE() macro. */
 #define COROUTINE2(className, name) \
 struct className##_##name : className { \
   className##_##name(); \
-  void printName(Print* pPrinter) override; \
+  ACE_ROUTINE_NAME_DECL(override) \
   int runCoroutine() override; \
 } name; \
 className##_##name :: className##_##name() { \
 } \
-void className##_##name::printName(Print* pPrinter) { \
-  pPrinter->print(F(#className "_" #name)); \
-} \
+ACE_ROUTINE_NAME_DEF(className##_##name, #className "_" #name) \
 int className##_##name :: runCoroutine()
 
 /**
@@ -130,24 +249,20 @@ int className##_##name :: runCoroutine()
 #define EXTERN_COROUTINE1(name) \
 struct Coroutine_##name : ace_routine::Coroutine { \
   Coroutine_##name(); \
-  void printName(Print* pPrinter) override; \
+  ACE_ROUTINE_NAME_DECL(override) \
   int runCoroutine() override; \
 }; \
-void Coroutine_##name::printName(Print* pPrinter) { \
-  pPrinter->print(F("Coroutine_" #name)); \
-} \
+ACE_ROUTINE_NAME_DEF(Coroutine_##name, "Coroutine_" #name) \
 extern Coroutine_##name name
 
 /** Implement the 2-argument EXTERN_COROUTINE() macro. */
 #define EXTERN_COROUTINE2(className, name) \
 struct className##_##name : className { \
   className##_##name(); \
-  void printName(Print* pPrinter) override; \
+  ACE_ROUTINE_NAME_DECL(override) \
   int runCoroutine() override; \
 }; \
-void Coroutine_##name :: printName(Print* pPrinter) { \
-  pPrinter->print(F(#className "_" #name)); \
-} \
+ACE_ROUTINE_NAME_DEF(className##_##name, #className "_" #name) \
 extern className##_##name name
 
 /** Mark the beginning of a coroutine. */
@@ -173,7 +288,7 @@ extern className##_##name name
 #define COROUTINE_YIELD_INTERNAL_LINE(line) \
     do { \
       __label__ jumpLabel; \
-      mLineNumber = line; \
+      this->setLineNumber(line); \
       this->setJump(&& jumpLabel); \
       return 0; \
       jumpLabel: ; \
@@ -183,7 +298,7 @@ extern className##_##name name
 #define COROUTINE_YIELD() COROUTINE_YIELD_LINE(__LINE__)
 #define COROUTINE_YIELD_LINE(line) \
     do { \
-      mLineNumber = line; \
+      this->setLineNumber(line); \
       this->setYielding(); \
       COROUTINE_YIELD_INTERNAL(); \
       this->setRunning(); \
@@ -202,7 +317,7 @@ extern className##_##name name
 #define COROUTINE_AWAIT(condition) COROUTINE_AWAIT_LINE(condition, __LINE__)
 #define COROUTINE_AWAIT_LINE(condition, line) \
     do { \
-      mLineNumber = line; \
+      this->setLineNumber(line); \
       this->setYielding(); \
       do { \
         COROUTINE_YIELD_INTERNAL(); \
@@ -210,14 +325,110 @@ extern className##_##name name
       this->setRunning(); \
     } while (false)
 
+/**
+ * Wait until condition is true, like COROUTINE_AWAIT(), but poll an expensive
+ * condition with exponentially growing intervals, instead of on every
+ * scheduler pass. If the condition is false, it is checked again after
+ * minMicros, then after twice the previous interval each time, up to
+ * maxMicros. Each COROUTINE_AWAIT_BACKOFF() starts again from minMicros, and
+ * does not yield if the condition is already true.
+ *
+ * The coroutine is Delaying between the checks, so a scheduler which sleeps
+ * (see CoroutineScheduler::loopOrSleep()) sleeps until the next check. Both
+ * intervals are limited to kMaxDelay micros (see ACE_ROUTINE_DELAY_BITS).
+ */
+#define COROUTINE_AWAIT_BACKOFF(condition, minMicros, maxMicros) \
+    COROUTINE_AWAIT_BACKOFF_LINE(condition, minMicros, maxMicros, __LINE__)
+#define COROUTINE_AWAIT_BACKOFF_LINE(condition, minMicros, maxMicros, line) \
+    do { \
+      this->setLineNumber(line); \
+      if (!(condition)) { \
+        this->setDelayMicros(minMicros); \
+        this->setDelaying(); \
+        while (true) { \
+          do { \
+            COROUTINE_YIELD_INTERNAL(); \
+          } while (!this->isDelayMicrosExpired()); \
+          if (condition) break; \
+          this->setBackoffMicros(maxMicros); \
+        } \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Wait until predicate(context) returns true, like COROUTINE_AWAIT(), but let
+ * the CoroutineScheduler evaluate the predicate while the coroutine is
+ * blocked, instead of resuming the coroutine on every pass only to evaluate
+ * its condition. The predicate is a function of type AwaitPredicate, which
+ * takes the context pointer and returns a bool, for example:
+ *
+ * @code
+ * bool isButtonPressed(void* context) {
+ *   return digitalRead(*(int*) context) == LOW;
+ * }
+ * ...
+ *   COROUTINE_AWAIT_PREDICATE(isButtonPressed, &buttonPin);
+ * @endcode
+ *
+ * Both arguments are evaluated more than once, so they should be simple
+ * expressions without side effects. The predicate is evaluated first, and the
+ * coroutine does not yield at all if it is already true. If
+ * ACE_ROUTINE_AWAIT_PREDICATE is 1, and the CoroutineScheduler finds the
+ * predicate true, the coroutine is resumed without evaluating it again.
+ * Otherwise, and with other schedulers or direct calls to runCoroutine(), the
+ * coroutine is resumed on each pass and evaluates the predicate itself.
+ */
+#define COROUTINE_AWAIT_PREDICATE(predicate, context) \
+    COROUTINE_AWAIT_PREDICATE_LINE(predicate, context, __LINE__)
+#define COROUTINE_AWAIT_PREDICATE_LINE(predicate, context, line) \
+    do { \
+      this->setLineNumber(line); \
+      if (!(predicate)(context)) { \
+        this->setAwaitPredicate(predicate, context); \
+        do { \
+          COROUTINE_YIELD_INTERNAL(); \
+        } while (!this->isAwaitPredicateDone(predicate, context)); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Wait until condition is true, parking the coroutine on the given WaitQueue
+ * while the condition is false. The CoroutineScheduler removes a parked
+ * coroutine from its list and does not run it again until some other code
+ * calls WaitQueue::notify(), so a blocked coroutine costs nothing while it
+ * waits. The condition is re-evaluated upon each notify(), so the condition
+ * must only become true through code which also calls notify() on the same
+ * queue.
+ *
+ * Unlike COROUTINE_AWAIT(), the condition is evaluated first, and the
+ * coroutine does not yield at all if it is already true. If the coroutine is
+ * called directly instead of through the CoroutineScheduler, this behaves like
+ * COROUTINE_AWAIT().
+ */
+#define COROUTINE_AWAIT_ON(queue, condition) \
+    COROUTINE_AWAIT_ON_LINE(queue, condition, __LINE__)
+#define COROUTINE_AWAIT_ON_LINE(queue, condition, line) \
+    do { \
+      this->setLineNumber(line); \
+      while (!(condition)) { \
+        this->setWaiting(&(queue)); \
+        COROUTINE_YIELD_INTERNAL(); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
 /**
  * Yield for delayMillis. A delayMillis of 0 is functionally equivalent to
  * COROUTINE_YIELD(). To save memory, the delayMillis is stored as a uint16_t
- * but the actual maximum is limited to 32767 millliseconds. See
+ * by default, but the actual maximum is limited to 32767 millliseconds. See
  * setDelayMillis() for the reason for this limitation.
  *
  * If you need to wait for longer than that, use a for-loop to call
- * COROUTINE_DELAY() as many times as necessary.
+ * COROUTINE_DELAY() as many times as necessary, or define
+ * ACE_ROUTINE_DELAY_BITS to 32 to raise the maximum to 2147483647
+ * milliseconds.
  *
  * This could have been implemented using COROUTINE_AWAIT() but this macro
  * matches the global delay(millis) function already provided by the Arduino
@@ -228,7 +439,7 @@ extern className##_##name name
 #define COROUTINE_DELAY(delayMillis) COROUTINE_DELAY_LINE(delayMillis, __LINE__)
 #define COROUTINE_DELAY_LINE(delayMillis, line) \
     do { \
-      mLineNumber = line; \
+      this->setLineNumber(line); \
       this->setDelayMillis(delayMillis); \
       this->setDelaying(); \
       do { \
@@ -237,11 +448,107 @@ extern className##_##name name
       this->setRunning(); \
     } while (false)
 
+/**
+ * Yield until the millis clock reaches deadlineMillis, an absolute time in the
+ * same unit as millis(). Unlike COROUTINE_DELAY(), the time at which the
+ * coroutine happens to resume does not move the deadline, so a loop which
+ * advances its own deadline by a fixed amount does not drift:
+ *
+ * @code
+ * COROUTINE_LOOP() {
+ *   next += 10;
+ *   COROUTINE_DELAY_UNTIL(next);
+ *   ...
+ * }
+ * @endcode
+ *
+ * A deadline which has already passed, or which is more than kMaxDelay
+ * milliseconds in the future (see ACE_ROUTINE_DELAY_BITS), is treated as
+ * expired, so the coroutine only yields once.
+ */
+#define COROUTINE_DELAY_UNTIL(deadlineMillis) \
+    COROUTINE_DELAY_UNTIL_LINE(deadlineMillis, __LINE__)
+#define COROUTINE_DELAY_UNTIL_LINE(deadlineMillis, line) \
+    do { \
+      this->setLineNumber(line); \
+      this->setDelayUntilMillis(deadlineMillis); \
+      this->setDelaying(); \
+      do { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } while (!this->isDelayExpired()); \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Yield until the start of the next period of periodMillis. The next deadline
+ * is periodMillis after the deadline of the previous COROUTINE_PERIODIC() or
+ * COROUTINE_DELAY_UNTIL(), instead of periodMillis after the time the
+ * coroutine happens to resume, so the scheduling latency of each iteration
+ * does not accumulate. Two forms are supported:
+ *
+ *   - COROUTINE_PERIODIC(periodMillis)
+ *   - COROUTINE_PERIODIC(periodMillis, missed)
+ *
+ * If the coroutine is late by one or more whole periods, the missed periods
+ * are skipped instead of being run back to back, and the 2-argument form adds
+ * their number to the integer variable 'missed'.
+ *
+ * The first COROUTINE_PERIODIC(), or one which follows a different delay
+ * macro, starts the periods from the current time. So does one which runs
+ * more than kMaxDelay milliseconds after the previous deadline (see
+ * ACE_ROUTINE_DELAY_BITS), since the previous deadline can no longer be
+ * distinguished from a future one.
+ */
+#define COROUTINE_PERIODIC(...) \
+    GET_COROUTINE_PERIODIC(\
+        __VA_ARGS__, COROUTINE_PERIODIC2, COROUTINE_PERIODIC1)(__VA_ARGS__)
+
+/** Internal helper macro to allow overloading of COROUTINE_PERIODIC(). */
+#define GET_COROUTINE_PERIODIC(_1, _2, NAME, ...) NAME
+
+/** Implement the 1-argument COROUTINE_PERIODIC() macro. */
+#define COROUTINE_PERIODIC1(periodMillis) \
+    COROUTINE_PERIODIC_LINE(periodMillis, (void), __LINE__)
+
+/** Implement the 2-argument COROUTINE_PERIODIC() macro. */
+#define COROUTINE_PERIODIC2(periodMillis, missed) \
+    COROUTINE_PERIODIC_LINE(periodMillis, (missed) +=, __LINE__)
+
+#define COROUTINE_PERIODIC_LINE(periodMillis, countMissed, line) \
+    do { \
+      this->setLineNumber(line); \
+      countMissed this->setPeriodicMillis(periodMillis); \
+      this->setDelaying(); \
+      do { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } while (!this->isDelayExpired()); \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Yield for delayNanos. Similiar to COROUTINE_DELAY(delayMillis). Requires a
+ * T_CLOCK with a nanos() method, such as the clocks of HighResClockInterface.h
+ * (otherwise micros() * 1000 is used), and a T_DELAY of uint32_t (up to 2.1
+ * seconds) or uint64_t, since 16 bits allow only 32 micros.
+ */
+#define COROUTINE_DELAY_NANOS(delayNanos) \
+    COROUTINE_DELAY_NANOS_LINE(delayNanos, __LINE__)
+#define COROUTINE_DELAY_NANOS_LINE(delayNanos, line) \
+    do { \
+      this->setLineNumber(line); \
+      this->setDelayNanos(delayNanos); \
+      this->setDelaying(); \
+      do { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } while (!this->isDelayNanosExpired()); \
+      this->setRunning(); \
+    } while (false)
+
 /** Yield for delayMicros. Similiar to COROUTINE_DELAY(delayMillis). */
 #define COROUTINE_DELAY_MICROS(delayMicros) COROUTINE_DELAY_MICROS_LINE(delayMicros, __LINE__)
 #define COROUTINE_DELAY_MICROS_LINE(delayMicros, line) \
     do { \
-      mLineNumber = line; \
+      this->setLineNumber(line); \
       this->setDelayMicros(delayMicros); \
       this->setDelaying(); \
       do { \
@@ -251,24 +558,43 @@ extern className##_##name name
     } while (false)
 
 /**
- * Yield for delaySeconds. Similar to COROUTINE_DELAY(delayMillis).
+ * Yield for delayMicros, like COROUTINE_DELAY_MICROS(), but wake up on time
+ * instead of on the first scheduler pass after the delay expires. The
+ * coroutine yields normally until the remaining delay falls within the guard
+ * window of the CoroutineScheduler (see
+ * CoroutineScheduler::setSpinGuardMicros()). The scheduler then busy-waits for
+ * the remainder of the delay before resuming the coroutine, blocking the other
+ * coroutines for at most the guard window.
  *
- * The accuracy of the delay interval in units of seconds is not perfectly
- * accurate. The current implementation uses the builtin millis() to infer the
- * "seconds". The millis() function returns a value that overflows after
- * 4,294,967.296 seconds. Therefore, the last inferred second just before
- * overflowing contains only 0.296 seconds instead of a full second. A delay
- * which straddles this overflow will return 0.704 seconds earlier than it
- * should.
+ * Only the CoroutineScheduler spins. Other schedulers treat this like
+ * COROUTINE_DELAY_MICROS().
+ */
+#define COROUTINE_DELAY_MICROS_PRECISE(delayMicros) \
+    COROUTINE_DELAY_MICROS_PRECISE_LINE(delayMicros, __LINE__)
+#define COROUTINE_DELAY_MICROS_PRECISE_LINE(delayMicros, line) \
+    do { \
+      this->setLineNumber(line); \
+      this->setDelayMicrosPrecise(delayMicros); \
+      this->setDelaying(); \
+      do { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } while (!this->isDelayMicrosExpired()); \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Yield for delaySeconds. Similar to COROUTINE_DELAY(delayMillis).
  *
- * On microcontrollers without hardware integer division instruction, (i.e. AVR,
- * SAMD21, ESP8266), the division by 1000 is relatively slow and consumes
- * significant amount of flash memory (100-150 bytes on AVR).
+ * The delay is measured using ClockInterface::seconds(), which counts the
+ * seconds incrementally from millis() on processors without a hardware integer
+ * division instruction (i.e. AVR, SAMD21, ESP8266), and divides millis() by
+ * 1000 on the others. See ClockInterface::seconds() for the accuracy of each
+ * method.
  */
 #define COROUTINE_DELAY_SECONDS(delaySeconds) COROUTINE_DELAY_SECONDS_LINE(delaySeconds, __LINE__)
 #define COROUTINE_DELAY_SECONDS_LINE(delaySeconds, line) \
     do { \
-      mLineNumber = line; \
+      this->setLineNumber(line); \
       this->setDelaySeconds(delaySeconds); \
       this->setDelaying(); \
       do { \
@@ -285,7 +611,7 @@ extern className##_##name name
 #define COROUTINE_END_LINE(line) \
     do { \
       __label__ jumpLabel; \
-      mLineNumber = line; \
+      this->setLineNumber(line); \
       this->setEnding(); \
       this->setJump(&& jumpLabel); \
       jumpLabel: ; \
@@ -297,123 +623,168 @@ namespace ace_routine {
 /** A lookup table from Status integer to human-readable strings. */
 extern const __FlashStringHelper* const sStatusStrings[];
 
+/**
+ * Predicate of COROUTINE_AWAIT_PREDICATE(), called with its context pointer.
+ * Returns true when the coroutine can continue.
+ */
+typedef bool (*AwaitPredicate)(void* context);
+
 // Forward declaration of CoroutineSchedulerTemplate<T>
 template <typename T> class CoroutineSchedulerTemplate;
 
-/**
- * Base class of all coroutines. The actual coroutine code is an implementation
- * of the virtual runCoroutine() method.
- */
-template <typename T_CLOCK>
-class CoroutineTemplate {
-  friend class CoroutineSchedulerTemplate<CoroutineTemplate<T_CLOCK>>;
-  friend class ::AceRoutineTest_statusStrings;
-  friend class ::SuspendTest_suspendAndResume;
+// Forward declaration of CoroutineDeadlineSchedulerTemplate<T, N>
+template <typename T, uint16_t N> class CoroutineDeadlineSchedulerTemplate;
 
-  public:
-    /**
-     * Print the name of the Coroutine.
-     */
-    virtual void printName(Print* pPrinter) { pPrinter->print('?'); }
-    /**
-     * The body of the coroutine. The COROUTINE macro creates a subclass of
-     * this class and puts the body of the coroutine into this method.
-     *
-     * @return The return value is always ignored. This method is declared to
-     * return an int to prevent the user from accidentally returning from this
-     * method using an explicit 'return' statement instead of through one of
-     * the macros (e.g. COROUTINE_YIELD(), COROUTINE_DELAY(), COROUTINE_AWAIT()
-     * or COROUTINE_END()).
-     */
-    virtual int runCoroutine() = 0;
+// Forward declaration of DeadlineHeap<T, N>
+template <typename T, uint16_t N> class DeadlineHeap;
 
-    /**
-     * Perform coroutine initialization. This is intended to be called directly
-     * from the global `setup()` function, or through the
-     * `CoroutineScheduler::setupCoroutines()` method which should also be
-     * called from the global `setup()` function.
-     *
-     * If your coroutines do not override this method, hence do not need to
-*     * perform any setup, then you should *not* call
-     * `CoroutineScheduler::setupCoroutines()` to avoid consuming unnecessary
-     * flash memory. On AVR processors, each `Coroutine::setupCoroutine()` seems
-     * to consume at least 50-60 bytes of flash memory overhead per coroutine.
-     * On 32-bit processors, the overhead seems to be only about 30-40 bytes per
-     * coroutine.
-     */
-    virtual void setupCoroutine() {}
+// Forward declaration of CoroutinePrioritySchedulerTemplate<T, N>
+template <typename T, uint16_t N> class CoroutinePrioritySchedulerTemplate;
 
-    /**
-     * Suspend the coroutine at the next scheduler iteration. If the coroutine
-     * is already in the process of ending or is already terminated, then this
-     * method does nothing. A coroutine cannot use this method to suspend
-     * itself, it can only suspend some other coroutine. Currently, there is no
-     * ability for a coroutine to suspend itself, that would require the
-     * addition of a COROUTINE_SUSPEND() macro. Also, this method works only if
-     * the CoroutineScheduler::loop() is used because the suspend functionality
-     * is implemented by the CoroutineScheduler.
-     */
-    void suspend() {
-      if (isDone()) return;
-      mStatus = kStatusSuspended;
-    }
+// Forward declaration of CoroutineWorkStealingSchedulerTemplate<T, N>
+template <typename T, uint8_t N> class CoroutineWorkStealingSchedulerTemplate;
 
-    /**
-     * Add a Suspended coroutine into the head of the scheduler linked list,
-     * and change the state to Yielding. If the coroutine is in any other
-     * state, this method does nothing. This method works only if the
-     * CoroutineScheduler::loop() is used.
-     */
-    void resume() {
-      if (mStatus != kStatusSuspended) return;
+// Forward declaration of WaitQueueTemplate<T>
+template <typename T> class WaitQueueTemplate;
 
-      // We lost the original state of the coroutine when suspend() was called
-      // but the coroutine will automatically go back into the original state
-      // when Coroutine::runCoroutine() is called because COROUTINE_YIELD(),
-      // COROUTINE_DELAY() and COROUTINE_AWAIT() are written to restore their
-      // status.
-      mStatus = kStatusYielding;
-    }
+// Forward declaration of CoroutinePool<T, N>
+template <typename T, uint8_t N> class CoroutinePool;
 
-    /**
-     * Reset the coroutine to its initial state. Only the Coroutine base-class
-     * state is reset to the original state. If the subclass runCoroutine()
-     * uses any static variables (for example, a loop counter), you must reset
-     * those variables manually as well, since this library does not have any
-     * knowledge about them.
-     *
-     * It is expected that this method will be called from outside the
-     * runCoroutine() method. If it is called within the method, I'm not sure
-     * what will happen. I think the coroutine will abandon the current
-     * continuation point, and start executing from the beginning of the
-     * Coroutine upon the next iteration.
-     */
-    void reset() {
-      mStatus = kStatusYielding;
-      mJumpPoint = nullptr;
-    }
+// Forward declaration of StaticCoroutineScheduler<T...>
+template <typename... T> class StaticCoroutineScheduler;
+
+// Forward declaration of CoroutineRegistrySchedulerTemplate<T, N>
+template <typename T, uint16_t N> class CoroutineRegistrySchedulerTemplate;
+
+// Forward declaration of CoroutineEdfSchedulerTemplate<T, N>
+template <typename T, uint8_t N> class CoroutineEdfSchedulerTemplate;
+
+// Forward declaration of CyclicExecutiveSchedulerTemplate<C, M, T...>
+template <typename C, uint16_t M, typename... T>
+class CyclicExecutiveSchedulerTemplate;
+
+/** Forward declaration of CoroutinePartitionTemplate. */
+template <typename T> class CoroutinePartitionTemplate;
+
+/**
+ * The types derived from the type T_DELAY of mDelayStart and mDelayDuration,
+ * which must be uint8_t, uint16_t, uint32_t or uint64_t.
+ */
+template <typename T_DELAY> struct CoroutineDelayTraits;
+
+template <> struct CoroutineDelayTraits<uint8_t> {
+  /** Signed type used to compare two delay values across a rollover. */
+  typedef int8_t Diff;
+  /**
+   * Type of the argument of setDelayMillis() and friends, wide enough to
+   * saturate a constant like COROUTINE_DELAY(1000) instead of truncating it.
+   */
+  typedef uint16_t Arg;
+};
 
+template <> struct CoroutineDelayTraits<uint16_t> {
+  typedef int16_t Diff;
+  typedef uint16_t Arg;
+};
+
+template <> struct CoroutineDelayTraits<uint32_t> {
+  typedef int32_t Diff;
+  typedef uint32_t Arg;
+};
+
+template <> struct CoroutineDelayTraits<uint64_t> {
+  typedef int64_t Diff;
+  typedef uint64_t Arg;
+};
+
+#if ACE_ROUTINE_DELAY_BITS == 64
+  /** Default type of mDelayStart and mDelayDuration. */
+  typedef uint64_t DefaultDelayValue;
+#elif ACE_ROUTINE_DELAY_BITS == 32
+  typedef uint32_t DefaultDelayValue;
+#elif ACE_ROUTINE_DELAY_BITS == 8
+  typedef uint8_t DefaultDelayValue;
+#else
+  typedef uint16_t DefaultDelayValue;
+#endif
+
+/**
+ * The state of a coroutine which is independent of how it is dispatched: the
+ * continuation point, the Status, and the delay. It has no virtual methods, so
+ * it is shared by CoroutineTemplate, which is called through its virtual
+ * runCoroutine(), and by CoroutineCrtp, which is not.
+ *
+ * @tparam T_CLOCK class that provides micros(), millis(), and seconds() as
+ *    static methods
+ * @tparam T_DELAY type of the delay fields, uint8_t, uint16_t, uint32_t or
+ *    uint64_t, no wider than the values returned by T_CLOCK
+ */
+template <typename T_CLOCK, typename T_DELAY>
+class CoroutineCoreTemplate {
+  public:
     /** Check if delay millis time is over. */
     bool isDelayExpired() const {
-      uint16_t nowMillis = coroutineMillis();
-      uint16_t elapsed = nowMillis - mDelayStart;
+      DelayValue nowMillis = coroutineMillis();
+      DelayValue elapsed = nowMillis - mDelayStart;
       return elapsed >= mDelayDuration;
     }
 
     /** Check if delay micros time is over. */
     bool isDelayMicrosExpired() const {
-      uint16_t nowMicros = coroutineMicros();
-      uint16_t elapsed = nowMicros - mDelayStart;
+      DelayValue nowMicros = coroutineMicros();
+      DelayValue elapsed = nowMicros - mDelayStart;
+      return elapsed >= mDelayDuration;
+    }
+
+    /** Check if delay nanos time is over. */
+    bool isDelayNanosExpired() const {
+      DelayValue nowNanos = coroutineNanos();
+      DelayValue elapsed = nowNanos - mDelayStart;
       return elapsed >= mDelayDuration;
     }
 
     /** Check if delay seconds time is over. */
     bool isDelaySecondsExpired() const {
-      uint16_t nowSeconds = coroutineSeconds();
-      uint16_t elapsed = nowSeconds - mDelayStart;
+      DelayValue nowSeconds = coroutineSeconds();
+      DelayValue elapsed = nowSeconds - mDelayStart;
       return elapsed >= mDelayDuration;
     }
 
+    /**
+     * Return the number of microseconds until the most recent delay expires,
+     * or 0 if it has already expired. The result has the resolution of the
+     * unit of the delay (millis, micros or seconds), and saturates at
+     * 0xFFFFFFFF for delays longer than about 71 minutes. A delay in nanos is
+     * divided by 1024 instead of 1000 to avoid a software division, so it
+     * errs on the short side by up to 2.4%. Meaningful only if isDelaying()
+     * is true.
+     */
+    uint32_t getDelayRemainingMicros() const {
+      DelayValue now;
+      switch (mDelayType) {
+        case kDelayTypeMicros:
+        case kDelayTypeMicrosPrecise: now = coroutineMicros(); break;
+        case kDelayTypeNanos: now = coroutineNanos(); break;
+        case kDelayTypeSeconds: now = coroutineSeconds(); break;
+        default: now = coroutineMillis(); break;
+      }
+      DelayValue elapsed = now - mDelayStart;
+      if (elapsed >= mDelayDuration) return 0;
+
+      DelayValue remaining = mDelayDuration - elapsed;
+      switch (mDelayType) {
+        case kDelayTypeMicros:
+        case kDelayTypeMicrosPrecise:
+          return toMicros(remaining, 1);
+        case kDelayTypeSeconds:
+          return toMicros(remaining, 1000000);
+        case kDelayTypeNanos:
+          return toMicros(remaining >> 10, 1);
+        default:
+          return toMicros(remaining, 1000);
+      }
+    }
+
     /** The coroutine was suspended with a call to suspend(). */
     bool isSuspended() const { return mStatus == kStatusSuspended; }
 
@@ -423,6 +794,9 @@ class CoroutineTemplate {
     /** The coroutine returned using COROUTINE_DELAY(). */
     bool isDelaying() const { return mStatus == kStatusDelaying; }
 
+    /** The coroutine is parked on a WaitQueue by COROUTINE_AWAIT_ON(). */
+    bool isWaiting() const { return mStatus == kStatusWaiting; }
+
     /** The coroutine is currently running. True only within the coroutine. */
     bool isRunning() const { return mStatus == kStatusRunning; }
 
@@ -450,23 +824,6 @@ class CoroutineTemplate {
       return mStatus == kStatusEnding || mStatus == kStatusTerminated;
     }
 
-    /**
-     * Deprecated method that does nothing. Starting v1.3, the setup into the
-     * singly-linked list is automatically performed by the constructor and
-     * this method no longer needs to be called manually. This method is
-     * retained for backwards compatibility.
-     */
-    void setupCoroutine(const char* /*name*/) ACE_ROUTINE_DEPRECATED {}
-
-    /**
-     * Deprecated method that does nothing. Starting v1.3, the setup into the
-     * singly-linked list is automatically performed by the constructor and
-     * this method no longer needs to be called manually. This method is
-     * retained for backwards compatibility.
-     */
-    void setupCoroutine(const __FlashStringHelper* /*name*/)
-        ACE_ROUTINE_DEPRECATED {}
-
   protected:
     /**
      * The execution status of the coroutine, corresponding to the
@@ -497,8 +854,11 @@ class CoroutineTemplate {
      *              v
      *         Terminated
      * @endverbatim
+     *
+     * The Waiting state, entered through COROUTINE_AWAIT_ON(), has the same
+     * transitions as the Yielding state.
      */
-#if 0
+#if ACE_ROUTINE_COMPACT_STATUS
     typedef uint8_t Status;
 #else
     typedef uint32_t Status;
@@ -509,7 +869,7 @@ class CoroutineTemplate {
      * whether the coroutine is still in the queue or not with this status. We
      * can add that later if we need to.
      */
-#if 0
+#if ACE_ROUTINE_COMPACT_STATUS
     static const Status kStatusSuspended = 0;
 
     /** Coroutine returned using the COROUTINE_YIELD() statement. */
@@ -526,6 +886,9 @@ class CoroutineTemplate {
 
     /** Coroutine has ended and no longer in the scheduler queue. */
     static const Status kStatusTerminated = 5;
+
+    /** Coroutine returned using the COROUTINE_AWAIT_ON() statement. */
+    static const Status kStatusWaiting = 6;
 #elif 0
     static const Status kStatusSuspended = 'S'; // was 0;
 
@@ -543,6 +906,9 @@ class CoroutineTemplate {
 
     /** Coroutine has ended and no longer in the scheduler queue. */
     static const Status kStatusTerminated = 'T'; // was 5;
+
+    /** Coroutine returned using the COROUTINE_AWAIT_ON() statement. */
+    static const Status kStatusWaiting = 'W'; // was 6;
 #else
     static const Status kStatusSuspended = 'S' + 'u'*0x100 + 's'*0x10000; // was 0;
 
@@ -560,32 +926,88 @@ class CoroutineTemplate {
 
     /** Coroutine has ended and no longer in the scheduler queue. */
     static const Status kStatusTerminated = 'T' + 'r'*0x100 + 'm*0x10000'; // was 5;
-#endif
-    /** Constructor. Automatically insert self into singly-linked list. */
-    CoroutineTemplate() {
-      insertAtRoot();
-    }
 
+    /** Coroutine returned using the COROUTINE_AWAIT_ON() statement. */
+    static const Status kStatusWaiting = 'W' + 'a'*0x100 + 'i'*0x10000; // was 6;
+#endif
     /**
-     * Destructor. Non-virtual.
-     *
-     * A virtual destructor increases the flash memory consumption on 8-bit AVR
-     * processors by 500-600 bytes because it pulls in the free() and malloc()
-     * functions. On the 32-bit SAMD21, the flash memory increases by by about
-     * 350 bytes. On other 32-bit processors (STM32, ESP8266, ESP32, Teensy
-     * 3.2), the flash memory increase is modest, about 50-150 bytes.
-     *
-     * Since a Coroutine is expected to be created statically, instead of the
-     * heap, a non-virtual destructor is good enough.
+     * The unit of the delay stored in mDelayStart and mDelayDuration. The
+     * coroutine itself does not need this because its continuation point
+     * knows which isDelayXxxExpired() to call, but a scheduler which tracks
+     * the deadline of a delaying coroutine (e.g. CoroutineDeadlineScheduler)
+     * needs to know which clock to compare against.
      */
-    ~CoroutineTemplate() = default;
+    typedef uint8_t DelayType;
+
+    /** Delay set by COROUTINE_DELAY(). */
+    static const DelayType kDelayTypeMillis = 0;
+
+    /** Delay set by COROUTINE_DELAY_MICROS(). */
+    static const DelayType kDelayTypeMicros = 1;
+
+    /** Delay set by COROUTINE_DELAY_SECONDS(). */
+    static const DelayType kDelayTypeSeconds = 2;
+
+    /**
+     * Delay in millis set by COROUTINE_DELAY_UNTIL() or COROUTINE_PERIODIC(),
+     * whose deadline is the start of the next COROUTINE_PERIODIC().
+     */
+    static const DelayType kDelayTypeDeadline = 3;
+
+    /**
+     * Delay in micros set by COROUTINE_DELAY_MICROS_PRECISE(), whose end the
+     * CoroutineScheduler spins through.
+     */
+    static const DelayType kDelayTypeMicrosPrecise = 4;
+
+    /** Delay set by COROUTINE_DELAY_NANOS(). */
+    static const DelayType kDelayTypeNanos = 5;
+
+    /** Type of mDelayStart and mDelayDuration, see ACE_ROUTINE_DELAY_BITS. */
+    typedef T_DELAY DelayValue;
+
+    /** Signed type used to compare two DelayValue across a rollover. */
+    typedef typename CoroutineDelayTraits<T_DELAY>::Diff DelayDiff;
+
+    /** Type of the argument of setDelayMillis() and friends. */
+    typedef typename CoroutineDelayTraits<T_DELAY>::Arg DelayArg;
+
+    /**
+     * Type returned by the millis(), micros() and seconds() of T_CLOCK, usually
+     * `unsigned long`, or `uint64_t` for the clocks of HighResClockInterface.h.
+     */
+    typedef decltype(T_CLOCK::millis()) ClockValue;
+
+    // The elapsed time (now - mDelayStart) wraps around at the rollover of the
+    // clock only if DelayValue is not wider than ClockValue.
+    static_assert(sizeof(T_DELAY) <= sizeof(ClockValue),
+        "T_DELAY must not be wider than the values returned by T_CLOCK");
+
+    /** The longest delay, half of the range of DelayValue. */
+    static const DelayValue kMaxDelay = ((DelayValue) -1) / 2;
+
+    /**
+     * Constructor. It is a constexpr so that a coroutine which does not insert
+     * itself into a linked list (e.g. SectionCoroutine) can be constant
+     * initialized, with no code run at boot.
+     */
+    constexpr CoroutineCoreTemplate() :
+        mStatus(kStatusYielding),
+        mDelayType(kDelayTypeMillis),
+        mDelayStart(0),
+        mDelayDuration(0) {}
+
+    /** Destructor. Non-virtual. */
+    ~CoroutineCoreTemplate() = default;
 
     /** Return the status of the coroutine. Used by the CoroutineScheduler. */
     Status getStatus() const { return mStatus; }
 
     /** Print the human-readable string of the Status. */
     void statusPrintTo(Print& printer) {
-#if 0
+#if ACE_ROUTINE_COMPACT_STATUS
+      printer.print("SYDRETW"[mStatus]);
+#elif 0
       printer.print(sStatusStrings[mStatus]);
 #elif 0
       printer.print((__FlashStringHelper*)pgm_read_word(&sStatusStrings[mStatus]));
@@ -608,10 +1030,39 @@ class CoroutineTemplate {
      */
     void* getJump() const { return mJumpPoint; }
 
+    /** Return the unit of the most recent delay. */
+    DelayType getDelayType() const { return mDelayType; }
+
+    /**
+     * Return the time when the most recent delay expires, in the unit given
+     * by getDelayType(), truncated to ACE_ROUTINE_DELAY_BITS like mDelayStart.
+     */
+    DelayValue getDelayDeadline() const {
+      return mDelayStart + mDelayDuration;
+    }
+
     /**
      * Return the Line Number of last milestone.
      */
-    uint16_t getLineNumber() const { return mLineNumber; }
+    uint16_t getLineNumber() const {
+    #if ACE_ROUTINE_LINE_NUMBER
+      return mLineNumber;
+    #else
+      return 0;
+    #endif
+    }
+
+    /**
+     * Record the line number of the current milestone. Does nothing if
+     * ACE_ROUTINE_LINE_NUMBER is 0.
+     */
+    void setLineNumber(uint16_t line) {
+    #if ACE_ROUTINE_LINE_NUMBER
+      mLineNumber = line;
+    #else
+      (void) line;
+    #endif
+    }
 
     /** Set the kStatusRunning state. */
     void setRunning() { mStatus = kStatusRunning; }
@@ -634,52 +1085,142 @@ class CoroutineTemplate {
     /**
      * Configure the delay timer for delayMillis.
      *
-     * The maximum duration is set to (UINT16_MAX / 2) (i.e. 32767
-     * milliseconds) if given a larger value. This makes the longest allowable
-     * time between two successive calls to isDelayExpired() for a given
-     * coroutine to be 32767 (UINT16_MAX - UINT16_MAX / 2 - 1) milliseconds,
-     * which should be long enough for all practical use-cases. (The '- 1'
-     * comes from an edge case where isDelayExpired() evaluates to be true in
-     * the CoroutineScheduler::runCoroutine() but becomes to be false in the
+     * The maximum duration is set to kMaxDelay (i.e. 32767 milliseconds, or
+     * 2147483647 milliseconds if T_DELAY is uint32_t, or 127 milliseconds if
+     * T_DELAY is uint8_t) if given a larger value. This makes the longest allowable time between two
+     * successive calls to isDelayExpired() for a given coroutine to be 32767
+     * (UINT16_MAX - UINT16_MAX / 2 - 1) milliseconds, which should be long
+     * enough for all practical use-cases. (The '- 1' comes from an edge case
+     * where isDelayExpired() evaluates to be true in the
+     * CoroutineScheduler::runCoroutine() but becomes to be false in the
      * COROUTINE_DELAY() macro inside Coroutine::runCoroutine()) because the
      * clock increments by 1 millisecond.)
+     *
+     * The start of the delay is read by ClockTraits::liveMillis(), bypassing
+     * the per-pass cache of a SnapshotClockInterface, so that the delay never
+     * expires early.
      */
-    void setDelayMillis(uint16_t delayMillis) {
-      mDelayStart = coroutineMillis();
+    void setDelayMillis(DelayArg delayMillis) {
+      mDelayStart = ClockTraits<T_CLOCK>::liveMillis();
+      mDelayType = kDelayTypeMillis;
 
       // If delayMillis is a compile-time constant, the compiler seems to
       // completely optimize away this bounds checking code.
-      mDelayDuration = (delayMillis >= UINT16_MAX / 2)
-          ? UINT16_MAX / 2
-          : delayMillis;
+      mDelayDuration = (delayMillis >= kMaxDelay)
+          ? (DelayValue) kMaxDelay : (DelayValue) delayMillis;
+    }
+
+    /**
+     * Configure the delay timer to expire when the millis clock reaches
+     * deadlineMillis. A deadline which is not within kMaxDelay in the future
+     * is treated as already passed. Either way, getDelayDeadline() returns
+     * deadlineMillis, truncated to DelayValue, so that the next
+     * setPeriodicMillis() is relative to it.
+     */
+    void setDelayUntilMillis(ClockValue deadlineMillis) {
+      DelayValue now = ClockTraits<T_CLOCK>::liveMillis();
+      DelayValue deadline = deadlineMillis;
+      DelayValue remaining = deadline - now;
+      mDelayType = kDelayTypeDeadline;
+      if ((DelayDiff) remaining > 0) {
+        mDelayStart = now;
+        mDelayDuration = remaining;
+      } else {
+        mDelayStart = deadline;
+        mDelayDuration = 0;
+      }
+    }
+
+    /**
+     * Configure the delay timer for the next period of COROUTINE_PERIODIC(),
+     * which ends periodMillis after the previous deadline. If that has already
+     * passed, whole periods are skipped until the end of the period falls in
+     * the future. Dividing is needed only in that case, so the usual cost is
+     * the same as setDelayMillis().
+     *
+     * @return the number of periods which were skipped
+     */
+    DelayValue setPeriodicMillis(DelayArg periodMillis) {
+      DelayValue period = (periodMillis >= kMaxDelay)
+          ? (DelayValue) kMaxDelay : (DelayValue) periodMillis;
+      DelayValue now = ClockTraits<T_CLOCK>::liveMillis();
+      if (mDelayType == kDelayTypeDeadline && period > 0) {
+        DelayValue previous = getDelayDeadline();
+        DelayValue elapsed = now - previous;
+        if (elapsed <= kMaxDelay) {
+          DelayValue missed = 0;
+          if (elapsed >= period) {
+            missed = elapsed / period;
+            previous += missed * period;
+          }
+          mDelayStart = previous;
+          mDelayDuration = period;
+          return missed;
+        }
+      }
+
+      mDelayType = kDelayTypeDeadline;
+      mDelayStart = now;
+      mDelayDuration = period;
+      return 0;
     }
 
     /**
      * Configure the delay timer for delayMicros. Similar to seDelayMillis(),
-     * the maximum delay is 32767 micros.
+     * the maximum delay is kMaxDelay micros.
      */
-    void setDelayMicros(uint16_t delayMicros) {
-      mDelayStart = coroutineMicros();
+    void setDelayMicros(DelayArg delayMicros) {
+      mDelayStart = ClockTraits<T_CLOCK>::liveMicros();
+      mDelayType = kDelayTypeMicros;
 
       // If delayMicros is a compile-time constant, the compiler seems to
       // completely optimize away this bounds checking code.
-      mDelayDuration = (delayMicros >= UINT16_MAX / 2)
-          ? UINT16_MAX / 2
-          : delayMicros;
+      mDelayDuration = (delayMicros >= kMaxDelay)
+          ? (DelayValue) kMaxDelay : (DelayValue) delayMicros;
+    }
+
+    /**
+     * Configure the delay timer for the next check of
+     * COROUTINE_AWAIT_BACKOFF(), twice as long as the previous delay, but at
+     * most maxMicros. A previous delay of 0 becomes 1.
+     */
+    void setBackoffMicros(DelayArg maxMicros) {
+      DelayArg next = (mDelayDuration > 0) ? (DelayArg) mDelayDuration * 2 : 1;
+      setDelayMicros((next < maxMicros) ? next : maxMicros);
+    }
+
+    /**
+     * Configure the delay timer for delayNanos. Similar to seDelayMillis(),
+     * the maximum delay is kMaxDelay nanos.
+     */
+    void setDelayNanos(DelayArg delayNanos) {
+      mDelayStart = coroutineNanos();
+      mDelayType = kDelayTypeNanos;
+      mDelayDuration = (delayNanos >= kMaxDelay)
+          ? (DelayValue) kMaxDelay : (DelayValue) delayNanos;
+    }
+
+    /**
+     * Configure the delay timer for delayMicros, like setDelayMicros(), but
+     * let the CoroutineScheduler spin through the end of the delay.
+     */
+    void setDelayMicrosPrecise(DelayArg delayMicros) {
+      setDelayMicros(delayMicros);
+      mDelayType = kDelayTypeMicrosPrecise;
     }
 
     /**
      * Configure the delay timer for delaySeconds. Similar to seDelayMillis(),
-     * the maximum delay is 32767 seconds.
+     * the maximum delay is kMaxDelay seconds.
      */
-    void setDelaySeconds(uint16_t delaySeconds) {
-      mDelayStart = coroutineSeconds();
+    void setDelaySeconds(DelayArg delaySeconds) {
+      mDelayStart = ClockTraits<T_CLOCK>::liveSeconds();
+      mDelayType = kDelayTypeSeconds;
 
       // If delaySeconds is a compile-time constant, the compiler seems to
       // completely optimize away this bounds checking code.
-      mDelayDuration = (delaySeconds >= UINT16_MAX / 2)
-          ? UINT16_MAX / 2
-          : delaySeconds;
+      mDelayDuration = (delaySeconds >= kMaxDelay)
+          ? (DelayValue) kMaxDelay : (DelayValue) delaySeconds;
     }
 
     /**
@@ -687,7 +1228,7 @@ class CoroutineTemplate {
      * millis() function from Arduino but can be overridden by providing a
      * different T_CLOCK template parameter.
      */
-    static unsigned long coroutineMillis() {
+    static ClockValue coroutineMillis() {
       return T_CLOCK::millis();
     }
 
@@ -696,20 +1237,395 @@ class CoroutineTemplate {
      * micros() function from Arduino but can be overridden by providing a
      * different T_CLOCK template parameter.
      */
-    static unsigned long coroutineMicros() {
+    static ClockValue coroutineMicros() {
       return T_CLOCK::micros();
     }
 
+    /**
+     * Returns the current nanoseconds clock, from T_CLOCK::nanos() if it
+     * exists, otherwise from T_CLOCK::micros() * 1000.
+     */
+    static ClockValue coroutineNanos() {
+      return ClockTraits<T_CLOCK>::nanos();
+    }
+
     /**
      * Returns the current clock in unit of seconds, truncated to the lower
      * 16-bits. This is an approximation of (millis / 1000). It does not need
      * to be perfectly accurate because COROUTINE_DELAY_SECONDS() is not
      * guaranteed to be precise.
      */
-    static unsigned long coroutineSeconds() {
+    static ClockValue coroutineSeconds() {
       return T_CLOCK::seconds();
     }
 
+    /**
+     * Called by the schedulers at the start of each pass, to allow a T_CLOCK
+     * such as SnapshotClockInterface to read the clock once per pass instead
+     * of once per coroutine. Does nothing if T_CLOCK has no snapshot().
+     */
+    static void coroutineClockSnapshot() {
+      ClockTraits<T_CLOCK>::snapshot();
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    CoroutineCoreTemplate(const CoroutineCoreTemplate&) = delete;
+    CoroutineCoreTemplate& operator=(const CoroutineCoreTemplate&) = delete;
+
+    /**
+     * Return a delay converted to micros by multiplying by scale, saturated
+     * at 0xFFFFFFFF. The scale is a constant at each call site, so the
+     * division is done by the compiler.
+     */
+    static uint32_t toMicros(DelayValue value, uint32_t scale) {
+      return (value > 0xFFFFFFFF / scale)
+          ? 0xFFFFFFFF : (uint32_t) value * scale;
+    }
+
+  protected:
+    /** Address of the label used by the computed-goto. */
+    void* mJumpPoint = nullptr;
+
+  #if ACE_ROUTINE_LINE_NUMBER
+    /** Line Number of last milestone. */
+    uint16_t mLineNumber = 0;
+  #endif
+
+  #if ACE_ROUTINE_COMPACT_STATUS
+    /** Run-state of the coroutine, packed with mDelayType. */
+    Status mStatus : 4;
+
+    /** Unit of mDelayStart and mDelayDuration. */
+    DelayType mDelayType : 4;
+  #else
+    /** Run-state of the coroutine. */
+    Status mStatus;
+
+    /** Unit of mDelayStart and mDelayDuration. */
+    DelayType mDelayType;
+  #endif
+
+    /**
+     * Start time provided by COROUTINE_DELAY(), COROUTINE_DELAY_MICROS(), or
+     * COROUTINE_DELAY_SECONDS(). The unit of this number is context dependent,
+     * milliseconds, microseconds, or seconds.
+     */
+    DelayValue mDelayStart;
+
+    /**
+     * Delay time specified by COROUTINE_DELAY(), COROUTINE_DELAY_MICROS() or,
+     * COROUTINE_DELAY_SECONDS(). The unit of this number is context dependent,
+     * milliseconds, microseconds, or seconds.
+     */
+    DelayValue mDelayDuration;
+};
+
+/**
+ * Base class of all coroutines. The actual coroutine code is an implementation
+ * of the virtual runCoroutine() method.
+ *
+ * @tparam T_CLOCK class that provides micros(), millis(), and seconds() as
+ *    static methods
+ * @tparam T_DELAY type of the delay fields, uint8_t, uint16_t or uint32_t,
+ *    selected by ACE_ROUTINE_DELAY_BITS by default
+ */
+template <typename T_CLOCK, typename T_DELAY = DefaultDelayValue>
+class CoroutineTemplate: public CoroutineCoreTemplate<T_CLOCK, T_DELAY> {
+  friend class CoroutineSchedulerTemplate<CoroutineTemplate>;
+  template <typename T, uint16_t N>
+  friend class CoroutineDeadlineSchedulerTemplate;
+  template <typename T, uint16_t N>
+  friend class CoroutinePrioritySchedulerTemplate;
+  template <typename T, uint16_t N>
+  friend class DeadlineHeap;
+  template <typename T, uint8_t N>
+  friend class CoroutineWorkStealingSchedulerTemplate;
+  friend class WaitQueueTemplate<CoroutineTemplate>;
+  template <typename T, uint8_t N>
+  friend class CoroutinePool;
+  template <typename... T>
+  friend class StaticCoroutineScheduler;
+  template <typename T, uint16_t N>
+  friend class CoroutineRegistrySchedulerTemplate;
+  template <typename T, uint8_t N>
+  friend class CoroutineEdfSchedulerTemplate;
+  template <typename C, uint16_t M, typename... T>
+  friend class CyclicExecutiveSchedulerTemplate;
+  friend class CoroutinePartitionTemplate<CoroutineTemplate>;
+  friend class ::AceRoutineTest_statusStrings;
+  friend class ::SuspendTest_suspendAndResume;
+
+  public:
+    /**
+     * Print the name of the Coroutine.
+     */
+    virtual void printName(Print* pPrinter) { pPrinter->print('?'); }
+    /**
+     * The body of the coroutine. The COROUTINE macro creates a subclass of
+     * this class and puts the body of the coroutine into this method.
+     *
+     * @return The return value is always ignored. This method is declared to
+     * return an int to prevent the user from accidentally returning from this
+     * method using an explicit 'return' statement instead of through one of
+     * the macros (e.g. COROUTINE_YIELD(), COROUTINE_DELAY(), COROUTINE_AWAIT()
+     * or COROUTINE_END()).
+     */
+    virtual int runCoroutine() = 0;
+
+    /**
+     * Perform coroutine initialization. This is intended to be called directly
+     * from the global `setup()` function, or through the
+     * `CoroutineScheduler::setupCoroutines()` method which should also be
+     * called from the global `setup()` function.
+     *
+     * If your coroutines do not override this method, hence do not need to
+*     * perform any setup, then you should *not* call
+     * `CoroutineScheduler::setupCoroutines()` to avoid consuming unnecessary
+     * flash memory. On AVR processors, each `Coroutine::setupCoroutine()` seems
+     * to consume at least 50-60 bytes of flash memory overhead per coroutine.
+     * On 32-bit processors, the overhead seems to be only about 30-40 bytes per
+     * coroutine.
+     */
+    virtual void setupCoroutine() {}
+
+    /**
+     * Called by the CoroutineScheduler after the coroutine has terminated and
+     * has been moved out of its linked list. The default does nothing. It is
+     * overridden by CoroutinePool to return the coroutine to its free list.
+     * The coroutine must not be accessed by the scheduler after this returns.
+     */
+    virtual void recycleCoroutine() {}
+
+    /**
+     * Suspend the coroutine at the next scheduler iteration. If the coroutine
+     * is already in the process of ending or is already terminated, then this
+     * method does nothing. A coroutine cannot use this method to suspend
+     * itself, it can only suspend some other coroutine. Currently, there is no
+     * ability for a coroutine to suspend itself, that would require the
+     * addition of a COROUTINE_SUSPEND() macro. Also, this method works only if
+     * the CoroutineScheduler::loop() is used because the suspend functionality
+     * is implemented by the CoroutineScheduler.
+     *
+     * When the CoroutineScheduler next reaches the suspended coroutine, it
+     * moves the coroutine out of its linked list into the list of suspended
+     * coroutines, so that it no longer costs anything on each pass.
+     */
+    void suspend() {
+      if (this->isDone()) return;
+      this->mStatus = this->kStatusSuspended;
+    }
+
+    /**
+     * Add a Suspended coroutine back into the scheduler linked list (at the
+     * head, unless it has a rank), and change the state to Yielding. If the coroutine is in any other
+     * state, this method does nothing. This method works only if the
+     * CoroutineScheduler::loop() is used. Moving the coroutine out of the list
+     * of suspended coroutines is O(1), because that list is doubly-linked.
+     */
+    void resume() {
+      if (this->mStatus != this->kStatusSuspended) return;
+
+      // We lost the original state of the coroutine when suspend() was called
+      // but the coroutine will automatically go back into the original state
+      // when Coroutine::runCoroutine() is called because COROUTINE_YIELD(),
+      // COROUTINE_DELAY() and COROUTINE_AWAIT() are written to restore their
+      // status.
+      this->mStatus = this->kStatusYielding;
+      reactivate();
+    }
+
+    /**
+     * Reset the coroutine to its initial state. Only the Coroutine base-class
+     * state is reset to the original state. If the subclass runCoroutine()
+     * uses any static variables (for example, a loop counter), you must reset
+     * those variables manually as well, since this library does not have any
+     * knowledge about them.
+     *
+     * It is expected that this method will be called from outside the
+     * runCoroutine() method. If it is called within the method, I'm not sure
+     * what will happen. I think the coroutine will abandon the current
+     * continuation point, and start executing from the beginning of the
+     * Coroutine upon the next iteration.
+     *
+     * A coroutine which was moved into the list of suspended or terminated
+     * coroutines by the CoroutineScheduler, or parked on a WaitQueue, is
+     * inserted back into the scheduler linked list, at the head unless it has
+     * a rank (see getRank()). A parked coroutine therefore restarts without
+     * waiting for WaitQueue::notify().
+     */
+    void reset() {
+      this->mStatus = this->kStatusYielding;
+      this->mJumpPoint = nullptr;
+      // Make the next COROUTINE_PERIODIC() start from the current time.
+      this->mDelayType = this->kDelayTypeMillis;
+    #if ACE_ROUTINE_AWAIT_PREDICATE
+      mAwaitPredicate = nullptr;
+    #endif
+      reactivate();
+    }
+
+    /**
+     * Set the priority level used by the CoroutinePriorityScheduler, from 0
+     * (the default, lowest) to CoroutinePriorityScheduler::kMaxPriority
+     * (highest). Ignored by the other schedulers. Requires
+     * ACE_ROUTINE_PRIORITIES.
+     */
+    void setPriority(uint8_t priority) {
+    #if ACE_ROUTINE_PRIORITIES
+      mPriority = priority;
+    #else
+      static_assert(sizeof(T_CLOCK) == 0,
+          "setPriority() requires ACE_ROUTINE_PRIORITIES=1");
+      (void) priority;
+    #endif
+    }
+
+    /** Return the priority level, always 0 without ACE_ROUTINE_PRIORITIES. */
+    uint8_t getPriority() const {
+    #if ACE_ROUTINE_PRIORITIES
+      return mPriority;
+    #else
+      return 0;
+    #endif
+    }
+
+    /**
+     * Return the dataflow rank assigned by
+     * CoroutineScheduler::setDependencies(): 0 for a coroutine without
+     * producers, otherwise one more than the highest rank of its producers.
+     * Always 0 unless ACE_ROUTINE_DEPENDENCIES is 1.
+     */
+    uint8_t getRank() const {
+    #if ACE_ROUTINE_DEPENDENCIES
+      return mRank;
+    #else
+      return 0;
+    #endif
+    }
+
+    /**
+     * Deprecated method that does nothing. Starting v1.3, the setup into the
+     * singly-linked list is automatically performed by the constructor and
+     * this method no longer needs to be called manually. This method is
+     * retained for backwards compatibility.
+     */
+    void setupCoroutine(const char* /*name*/) ACE_ROUTINE_DEPRECATED {}
+
+    /**
+     * Deprecated method that does nothing. Starting v1.3, the setup into the
+     * singly-linked list is automatically performed by the constructor and
+     * this method no longer needs to be called manually. This method is
+     * retained for backwards compatibility.
+     */
+    void setupCoroutine(const __FlashStringHelper* /*name*/)
+        ACE_ROUTINE_DEPRECATED {}
+
+  protected:
+    /** Constructor. Automatically insert self into singly-linked list. */
+    CoroutineTemplate() {
+      insertAtRoot();
+    }
+
+    /** Tag type of the constructor which does not call insertAtRoot(). */
+    struct NotLinked {};
+
+    /**
+     * Constructor used by StaticCoroutineTemplate, whose instances are run by
+     * a StaticCoroutineScheduler and are never inserted into the linked list.
+     */
+    explicit CoroutineTemplate(NotLinked) {}
+
+    /**
+     * Destructor. Non-virtual.
+     *
+     * A virtual destructor increases the flash memory consumption on 8-bit AVR
+     * processors by 500-600 bytes because it pulls in the free() and malloc()
+     * functions. On the 32-bit SAMD21, the flash memory increases by by about
+     * 350 bytes. On other 32-bit processors (STM32, ESP8266, ESP32, Teensy
+     * 3.2), the flash memory increase is modest, about 50-150 bytes.
+     *
+     * Since a Coroutine is expected to be created statically, instead of the
+     * heap, a non-virtual destructor is good enough.
+     */
+    ~CoroutineTemplate() = default;
+
+    /**
+     * Set the kStatusWaiting state, and remember the queue so that the
+     * CoroutineScheduler can park this coroutine on it after runCoroutine()
+     * returns.
+     */
+    void setWaiting(WaitQueueTemplate<CoroutineTemplate>* queue) {
+    #if defined(EPOXY_DUINO) || defined(ESP32)
+      // The workers of CoroutineWorkStealingScheduler poll instead of
+      // parking, and must not race on the parking queue.
+      if (*getParkingDisabled()) {
+        this->mStatus = this->kStatusYielding;
+        return;
+      }
+    #endif
+      this->mStatus = this->kStatusWaiting;
+      *getParkingQueue() = queue;
+    }
+
+    /**
+     * Overload of setWaiting() used by COROUTINE_AWAIT_ON() when the queue is
+     * not a WaitQueue, for example an SpscChannel whose other end runs on a
+     * different thread and cannot insert this coroutine back into the linked
+     * list of its scheduler. The coroutine stays in the Yielding state, so
+     * that the scheduler polls its condition on every pass.
+     */
+    template <typename T_QUEUE>
+    void setWaiting(T_QUEUE* /*queue*/) {
+      this->mStatus = this->kStatusYielding;
+    }
+
+    /**
+     * Set the kStatusYielding state, and remember the predicate of
+     * COROUTINE_AWAIT_PREDICATE() so that the CoroutineScheduler can evaluate
+     * it without resuming this coroutine.
+     */
+    void setAwaitPredicate(AwaitPredicate predicate, void* context) {
+      this->mStatus = this->kStatusYielding;
+    #if ACE_ROUTINE_AWAIT_PREDICATE
+      mAwaitPredicate = predicate;
+      mAwaitContext = context;
+    #else
+      (void) predicate;
+      (void) context;
+    #endif
+    }
+
+    /**
+     * Return true if the predicate of COROUTINE_AWAIT_PREDICATE() is true,
+     * without evaluating it again if the CoroutineScheduler already found it
+     * true.
+     */
+    bool isAwaitPredicateDone(AwaitPredicate predicate, void* context) {
+    #if ACE_ROUTINE_AWAIT_PREDICATE
+      if (mAwaitPredicate == nullptr) return true;
+      if (! predicate(context)) return false;
+      mAwaitPredicate = nullptr;
+      return true;
+    #else
+      return predicate(context);
+    #endif
+    }
+
+  #if ACE_ROUTINE_AWAIT_PREDICATE
+    /**
+     * Evaluate the predicate given to setAwaitPredicate(), and forget it if
+     * it is true. Return true if this coroutine must be resumed, which is also
+     * the case if it is not blocked in COROUTINE_AWAIT_PREDICATE().
+     */
+    bool checkAwaitPredicate() {
+      if (mAwaitPredicate == nullptr) return true;
+      if (! mAwaitPredicate(mAwaitContext)) return false;
+      mAwaitPredicate = nullptr;
+      return true;
+    }
+  #endif
+
   private:
     // Disable copy-constructor and assignment operator
     CoroutineTemplate(const CoroutineTemplate&) = delete;
@@ -727,6 +1643,29 @@ class CoroutineTemplate {
       return &root;
     }
 
+    /**
+     * Get the pointer to the WaitQueue given to the most recent setWaiting().
+     * Only one coroutine runs at a time, so a single static variable is
+     * enough to pass the queue from COROUTINE_AWAIT_ON() to the scheduler,
+     * without adding a pointer to every Coroutine instance.
+     */
+    static WaitQueueTemplate<CoroutineTemplate>** getParkingQueue() {
+      static WaitQueueTemplate<CoroutineTemplate>* parkingQueue;
+      return &parkingQueue;
+    }
+
+  #if defined(EPOXY_DUINO) || defined(ESP32)
+    /**
+     * Get the pointer to the flag which makes setWaiting() poll instead of
+     * park. Set by CoroutineWorkStealingScheduler while its workers are
+     * running, and written only while they are stopped.
+     */
+    static bool* getParkingDisabled() {
+      static bool parkingDisabled;
+      return &parkingDisabled;
+    }
+  #endif
+
     /**
      * Return the next pointer as a pointer to the pointer, similar to
      * getRoot(). This makes it much easier to manipulate a singly-linked list.
@@ -747,32 +1686,156 @@ class CoroutineTemplate {
       *root = this;
     }
 
+    /**
+     * Return the pointer to the root of the linked list which this coroutine
+     * belongs to: the list of its CoroutinePartition, or the global list
+     * given by getRoot().
+     */
+    CoroutineTemplate** getHome() const {
+    #if ACE_ROUTINE_PARTITIONS
+      return (mHome != nullptr) ? mHome : getRoot();
+    #else
+      return getRoot();
+    #endif
+    }
+
+  #if ACE_ROUTINE_PARTITIONS
+    /**
+     * Move this coroutine from the linked list of its current scheduler into
+     * the linked list given by home. A coroutine which is not in the linked
+     * list (i.e. suspended, terminated, or parked on a WaitQueue) goes into
+     * the new list when it is resumed, reset or notified.
+     */
+    void moveTo(CoroutineTemplate** home) {
+      if (mPrev == nullptr) {
+        for (CoroutineTemplate** p = getHome(); *p != nullptr;
+            p = (*p)->getNext()) {
+          if (*p == this) {
+            *p = mNext;
+            mHome = home;
+            insertByRank();
+            return;
+          }
+        }
+      }
+      mHome = home;
+    }
+  #endif
+
+    /**
+     * Insert the current coroutine into its scheduler linked list (see
+     * getHome()), which is kept sorted by rank. A coroutine of rank 0 is inserted at the root in
+     * constant time, like insertAtRoot(). Otherwise it is inserted after the
+     * last coroutine whose rank is not higher, so that a consumer woken up by
+     * its producer runs later in the same pass.
+     */
+    void insertByRank() {
+      CoroutineTemplate** p = getHome();
+    #if ACE_ROUTINE_DEPENDENCIES
+      if (mRank != 0) {
+        while (*p != nullptr && (*p)->mRank <= mRank) {
+          p = (*p)->getNext();
+        }
+      }
+    #endif
+      mNext = *p;
+      *p = this;
+    }
+
+    /**
+     * Get the pointer to the root of the doubly-linked list of coroutines
+     * which were found Suspended by the CoroutineScheduler.
+     */
+    static CoroutineTemplate** getSuspendedRoot() {
+      static CoroutineTemplate* root;
+      return &root;
+    }
+
+    /**
+     * Get the pointer to the root of the doubly-linked list of coroutines
+     * which were terminated by the CoroutineScheduler.
+     */
+    static CoroutineTemplate** getTerminatedRoot() {
+      static CoroutineTemplate* root;
+      return &root;
+    }
+
+    /**
+     * Insert this coroutine, which has already been removed from the
+     * scheduler linked list, at the head of the doubly-linked list of
+     * suspended or terminated coroutines, or of parked coroutines, given by
+     * root.
+     */
+    void insertInactive(CoroutineTemplate** root) {
+      mNext = *root;
+      if (mNext != nullptr) mNext->mPrev = &mNext;
+      *root = this;
+      mPrev = root;
+    }
+
+    /**
+     * If this coroutine is in the list of suspended or terminated coroutines,
+     * or parked on a WaitQueue, remove it from that list in constant time, and
+     * insert it back into the scheduler linked list according to its rank.
+     */
+    void reactivate() {
+      if (mPrev == nullptr) return;
+      removeInactive();
+      insertByRank();
+    }
+
+    /**
+     * Remove this coroutine from the list of suspended or terminated
+     * coroutines, or from its WaitQueue, in constant time.
+     */
+    void removeInactive() {
+      *mPrev = mNext;
+      if (mNext != nullptr) mNext->mPrev = mPrev;
+      mPrev = nullptr;
+    }
+
   protected:
     /** Pointer to the next coroutine in a singly-linked list. */
     CoroutineTemplate* mNext = nullptr;
 
-    /** Address of the label used by the computed-goto. */
-    void* mJumpPoint = nullptr;
-
-    /** Line Number of last milestone. */
-    uint16_t mLineNumber = 0;
-
-    /** Run-state of the coroutine. */
-    Status mStatus = kStatusYielding;
+    /**
+     * Address of the pointer which points to this coroutine, while this
+     * coroutine is in the list of suspended or terminated coroutines, or
+     * parked on a WaitQueue. Always nullptr while the coroutine is in the
+     * scheduler linked list, so that only the CoroutineScheduler and the
+     * WaitQueue need to maintain it.
+     */
+    CoroutineTemplate** mPrev = nullptr;
 
+  #if ACE_ROUTINE_PARTITIONS
     /**
-     * Start time provided by COROUTINE_DELAY(), COROUTINE_DELAY_MICROS(), or
-     * COROUTINE_DELAY_SECONDS(). The unit of this number is context dependent,
-     * milliseconds, microseconds, or seconds.
+     * Root of the linked list of the CoroutinePartition which runs this
+     * coroutine, or nullptr for the global list given by getRoot().
      */
-    uint16_t mDelayStart;
+    CoroutineTemplate** mHome = nullptr;
+  #endif
+
+  #if ACE_ROUTINE_PRIORITIES
+    /** Priority level used by CoroutinePriorityScheduler. */
+    uint8_t mPriority = 0;
+  #endif
+
+  #if ACE_ROUTINE_DEPENDENCIES
+    /** Dataflow rank used to order the scheduler linked list. */
+    uint8_t mRank = 0;
+  #endif
 
+  #if ACE_ROUTINE_AWAIT_PREDICATE
     /**
-     * Delay time specified by COROUTINE_DELAY(), COROUTINE_DELAY_MICROS() or,
-     * COROUTINE_DELAY_SECONDS(). The unit of this number is context dependent,
-     * milliseconds, microseconds, or seconds.
+     * Predicate of COROUTINE_AWAIT_PREDICATE() evaluated by the
+     * CoroutineScheduler, or nullptr if this coroutine is not blocked on one.
      */
-    uint16_t mDelayDuration;
+    AwaitPredicate mAwaitPredicate = nullptr;
+
+    /** Context pointer passed to mAwaitPredicate. */
+    void* mAwaitContext = nullptr;
+  #endif
+
 };
 
 /**
@@ -0,0 +1,350 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_CRTP_H
+#define ACE_ROUTINE_COROUTINE_CRTP_H
+
+#include <stdint.h> // uint8_t
+#include <Print.h> // Print
+#include "ClockInterface.h"
+#include "Coroutine.h"
+
+/**
+ * @file CoroutineCrtp.h
+ *
+ * Coroutines which are dispatched without virtual methods. A CoroutineCrtp is
+ * written with the same COROUTINE_BEGIN(), COROUTINE_YIELD(),
+ * COROUTINE_DELAY(), COROUTINE_AWAIT(), and COROUTINE_END() macros as a
+ * Coroutine, but it is run by a CoroutineCrtpScheduler instead of the
+ * CoroutineScheduler.
+ */
+
+/**
+ * Create a CoroutineCrtp instance named 'name'. The code in {} following this
+ * macro becomes the body of its runCoroutine() method. The equivalent of the
+ * 1-argument COROUTINE() macro.
+ */
+#define COROUTINE_CRTP(name) \
+struct CoroutineCrtp_##name : \
+    ace_routine::CoroutineCrtp<CoroutineCrtp_##name> { \
+  ACE_ROUTINE_NAME_DECL() \
+  int runCoroutine(); \
+} name; \
+ACE_ROUTINE_NAME_DEF(CoroutineCrtp_##name, "CoroutineCrtp_" #name) \
+int CoroutineCrtp_##name :: runCoroutine()
+
+/**
+ * Create an extern reference to a coroutine that is defined in another .cpp
+ * file using COROUTINE_CRTP(). The equivalent of the 1-argument
+ * EXTERN_COROUTINE() macro.
+ */
+#define EXTERN_COROUTINE_CRTP(name) \
+struct CoroutineCrtp_##name : \
+    ace_routine::CoroutineCrtp<CoroutineCrtp_##name> { \
+  ACE_ROUTINE_NAME_DECL() \
+  int runCoroutine(); \
+}; \
+extern CoroutineCrtp_##name name
+
+namespace ace_routine {
+
+template <typename T_CLOCK, typename T_DELAY>
+class CoroutineCrtpSchedulerTemplate;
+
+/**
+ * The part of CoroutineCrtp which does not depend on the class of the
+ * coroutine. It holds the singly-linked list walked by the
+ * CoroutineCrtpScheduler, and a pointer to a function which calls the
+ * runCoroutine() of the derived class. That pointer replaces the vtable
+ * pointer of a Coroutine: it is the same size, but the call needs one memory
+ * load instead of two, and there is no vtable in flash memory.
+ *
+ * @tparam T_CLOCK class that provides micros(), millis(), and seconds() as
+ *    static methods
+ * @tparam T_DELAY type of the delay fields, uint8_t, uint16_t or uint32_t
+ */
+template <typename T_CLOCK, typename T_DELAY = DefaultDelayValue>
+class CoroutineCrtpBaseTemplate:
+    public CoroutineCoreTemplate<T_CLOCK, T_DELAY> {
+  friend class CoroutineCrtpSchedulerTemplate<T_CLOCK, T_DELAY>;
+
+  public:
+    /**
+     * Suspend the coroutine. The CoroutineCrtpScheduler skips a suspended
+     * coroutine, but leaves it in its linked list. If the coroutine is ending
+     * or terminated, this method does nothing.
+     */
+    void suspend() {
+      if (this->isDone()) return;
+      this->mStatus = this->kStatusSuspended;
+    }
+
+    /**
+     * Change a Suspended coroutine to the Yielding state. If the coroutine is
+     * in any other state, this method does nothing.
+     */
+    void resume() {
+      if (this->mStatus != this->kStatusSuspended) return;
+      this->mStatus = this->kStatusYielding;
+    }
+
+    /**
+     * Reset the coroutine to its initial state, like CoroutineBase::reset(). A
+     * coroutine which was removed from the linked list by the
+     * CoroutineCrtpScheduler when it terminated is inserted back at its root.
+     */
+    void reset() {
+      bool unlinked = (this->mStatus == this->kStatusTerminated);
+      this->mStatus = this->kStatusYielding;
+      this->mJumpPoint = nullptr;
+      // Make the next COROUTINE_PERIODIC() start from the current time.
+      this->mDelayType = this->kDelayTypeMillis;
+      if (unlinked) insertAtRoot();
+    }
+
+  protected:
+    /** Function which calls the runCoroutine() of the derived class. */
+    typedef int (*Runner)(CoroutineCrtpBaseTemplate*);
+
+    /** Constructor. Automatically insert self into singly-linked list. */
+    explicit CoroutineCrtpBaseTemplate(Runner runner) :
+        mRunner(runner) {
+      insertAtRoot();
+    }
+
+    /** Destructor. Non-virtual. */
+    ~CoroutineCrtpBaseTemplate() = default;
+
+    /**
+     * Used by COROUTINE_AWAIT_ON(). A CoroutineCrtp is never parked on a
+     * WaitQueue, so it stays in the Yielding state and its condition is
+     * polled on every pass.
+     */
+    template <typename T_QUEUE>
+    void setWaiting(T_QUEUE* /*queue*/) {
+      this->mStatus = this->kStatusYielding;
+    }
+
+    /**
+     * Used by COROUTINE_AWAIT_PREDICATE(). A CoroutineCrtp is not run by the
+     * CoroutineScheduler, so it stays in the Yielding state and evaluates its
+     * own predicate on every pass.
+     */
+    void setAwaitPredicate(AwaitPredicate /*predicate*/, void* /*context*/) {
+      this->mStatus = this->kStatusYielding;
+    }
+
+    /** Used by COROUTINE_AWAIT_PREDICATE() to evaluate the predicate. */
+    bool isAwaitPredicateDone(AwaitPredicate predicate, void* context) {
+      return predicate(context);
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    CoroutineCrtpBaseTemplate(const CoroutineCrtpBaseTemplate&) = delete;
+    CoroutineCrtpBaseTemplate& operator=(const CoroutineCrtpBaseTemplate&) =
+        delete;
+
+    /** Get the pointer to the root pointer of the singly-linked list. */
+    static CoroutineCrtpBaseTemplate** getRoot() {
+      // Use a static variable inside a function to solve the static
+      // initialization ordering problem.
+      static CoroutineCrtpBaseTemplate* root;
+      return &root;
+    }
+
+    /** Return the next pointer as a pointer to the pointer. */
+    CoroutineCrtpBaseTemplate** getNext() { return &mNext; }
+
+    /** Insert the current coroutine at the root of the singly linked list. */
+    void insertAtRoot() {
+      CoroutineCrtpBaseTemplate** root = getRoot();
+      mNext = *root;
+      *root = this;
+    }
+
+    /** Call the runCoroutine() of the derived class. */
+    int run() { return mRunner(this); }
+
+    /** Pointer to the next coroutine in a singly-linked list. */
+    CoroutineCrtpBaseTemplate* mNext = nullptr;
+
+    /** Calls the runCoroutine() method of the derived class. */
+    Runner mRunner;
+};
+
+/**
+ * Base class of a coroutine which is dispatched without virtual methods,
+ * using the Curiously Recurring Template Pattern. The derived class T_DERIVED
+ * provides a non-virtual `int runCoroutine()`, and optionally a non-virtual
+ * `void printName(Print*)`:
+ *
+ * @code
+ * class Blink: public CoroutineCrtp<Blink> {
+ *   public:
+ *     int runCoroutine() {
+ *       COROUTINE_LOOP() {
+ *         ...
+ *         COROUTINE_DELAY(100);
+ *       }
+ *     }
+ * };
+ * @endcode
+ *
+ * The constructor stores the address of a static thunk which casts the base
+ * pointer back to T_DERIVED and calls its runCoroutine() directly, so that the
+ * body of the coroutine can be inlined into the thunk. Since the class has no
+ * virtual methods, each instance is smaller by the vtable pointer (replaced by
+ * the thunk pointer), and no vtable is generated for each coroutine class.
+ *
+ * @tparam T_DERIVED the class of the coroutine, which derives from this class
+ * @tparam T_CLOCK class that provides micros(), millis(), and seconds() as
+ *    static methods
+ * @tparam T_DELAY type of the delay fields, uint8_t, uint16_t or uint32_t
+ */
+template <
+    typename T_DERIVED,
+    typename T_CLOCK = ClockInterface,
+    typename T_DELAY = DefaultDelayValue>
+class CoroutineCrtp: public CoroutineCrtpBaseTemplate<T_CLOCK, T_DELAY> {
+  public:
+    /** Print the name of the coroutine. Hidden by T_DERIVED if needed. */
+    void printName(Print* pPrinter) { pPrinter->print('?'); }
+
+  protected:
+    /** Constructor. Automatically insert self into singly-linked list. */
+    CoroutineCrtp() :
+        CoroutineCrtpBaseTemplate<T_CLOCK, T_DELAY>(&runDerived) {}
+
+    /** Destructor. Non-virtual. */
+    ~CoroutineCrtp() = default;
+
+  private:
+    /** The type-erased thunk stored in CoroutineCrtpBaseTemplate. */
+    static int runDerived(
+        CoroutineCrtpBaseTemplate<T_CLOCK, T_DELAY>* coroutine) {
+      return static_cast<T_DERIVED*>(coroutine)->runCoroutine();
+    }
+};
+
+/**
+ * A round-robin scheduler of the CoroutineCrtp instances which use the clock
+ * T_CLOCK and the delay type T_DELAY. It is the equivalent of the CoroutineScheduler, without the
+ * features which need the virtual methods or the doubly-linked lists of the
+ * Coroutine: a suspended coroutine is skipped but stays in the linked list, a
+ * terminated coroutine is removed from the linked list, and a coroutine in
+ * COROUTINE_AWAIT_ON() is polled on every pass.
+ *
+ * @tparam T_CLOCK class that provides micros(), millis(), and seconds() as
+ *    static methods
+ * @tparam T_DELAY type of the delay fields, uint8_t, uint16_t or uint32_t
+ */
+template <typename T_CLOCK, typename T_DELAY = DefaultDelayValue>
+class CoroutineCrtpSchedulerTemplate {
+  public:
+    /** Set up the scheduler. Should be called from the global setup(). */
+    static void setup() { getScheduler()->setupScheduler(); }
+
+    /** Run the current coroutine, then advance to the next one. */
+    static void loop() { getScheduler()->runCoroutine(); }
+
+    /**
+     * Run the coroutines from the current position to the end of the linked
+     * list. If the previous call to loop() finished a pass, this runs every
+     * coroutine exactly once.
+     */
+    static void runOnePass() {
+      CoroutineCrtpSchedulerTemplate* scheduler = getScheduler();
+      do {
+        scheduler->runCoroutine();
+      } while (*scheduler->mCurrent != nullptr);
+    }
+
+  private:
+    using CoroutineBase = CoroutineCrtpBaseTemplate<T_CLOCK, T_DELAY>;
+
+    // Disable copy-constructor and assignment operator
+    CoroutineCrtpSchedulerTemplate(const CoroutineCrtpSchedulerTemplate&) =
+        delete;
+    CoroutineCrtpSchedulerTemplate& operator=(
+        const CoroutineCrtpSchedulerTemplate&) = delete;
+
+    /** Return the singleton instance of the scheduler. */
+    static CoroutineCrtpSchedulerTemplate* getScheduler() {
+      static CoroutineCrtpSchedulerTemplate singletonScheduler;
+      return &singletonScheduler;
+    }
+
+    /** Constructor. */
+    CoroutineCrtpSchedulerTemplate() = default;
+
+    /** Start at the root of the linked list. */
+    void setupScheduler() {
+      mCurrent = CoroutineBase::getRoot();
+      ClockTraits<T_CLOCK>::snapshot();
+    }
+
+    /** Run the current coroutine, then advance to the next one. */
+    void runCoroutine() {
+      // If reached the end, start from the beginning again.
+      if (*mCurrent == nullptr) {
+        mCurrent = CoroutineBase::getRoot();
+        if (*mCurrent == nullptr) {
+          return;
+        }
+        ClockTraits<T_CLOCK>::snapshot();
+      }
+
+      CoroutineBase* current = *mCurrent;
+      switch (current->getStatus()) {
+        case CoroutineBase::kStatusYielding:
+        case CoroutineBase::kStatusDelaying:
+          current->run();
+          break;
+
+        case CoroutineBase::kStatusEnding:
+          // mark it terminated, and remove it from the linked list
+          current->setTerminated();
+          *mCurrent = current->mNext;
+          current->mNext = nullptr;
+          return;
+
+        default:
+          // Suspended, skip to the next coroutine.
+          break;
+      }
+
+      mCurrent = current->getNext();
+    }
+
+    /** Address of the pointer to the coroutine to run on the next loop(). */
+    CoroutineBase** mCurrent = nullptr;
+};
+
+/** A CoroutineCrtpSchedulerTemplate using the ClockInterface. */
+using CoroutineCrtpScheduler = CoroutineCrtpSchedulerTemplate<ClockInterface>;
+
+}
+
+#endif
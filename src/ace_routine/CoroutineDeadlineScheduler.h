@@ -0,0 +1,282 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_DEADLINE_SCHEDULER_H
+#define ACE_ROUTINE_COROUTINE_DEADLINE_SCHEDULER_H
+
+#include <stdint.h> // uint16_t
+#include "Coroutine.h"
+#include "DeadlineHeap.h"
+#include "WaitQueue.h"
+
+class Print;
+
+namespace ace_routine {
+
+/**
+ * An alternative to `CoroutineSchedulerTemplate` which does not resume a
+ * coroutine in `COROUTINE_DELAY()` just so that it can check whether its
+ * delay has expired.
+ *
+ * The `CoroutineScheduler` calls `Coroutine::runCoroutine()` on every
+ * coroutine in the linked list, including the ones which are delaying. Each of
+ * those coroutines jumps back into its `COROUTINE_DELAY()`, calls
+ * `isDelayExpired()`, and most of the time, yields right back. If most of the
+ * coroutines are sleeping, almost all of the CPU time of the scheduler is
+ * spent on those pointless round trips.
+ *
+ * This scheduler removes a coroutine from the linked list when it returns
+ * through `COROUTINE_DELAY()`, and places it into a binary min-heap ordered by
+ * the deadline of its delay (`mDelayStart + mDelayDuration`). Each call to
+ * loop() checks only the top of the heap. Every coroutine whose deadline has
+ * expired is put back into the linked list at the current position, so that
+ * they run on the following calls to loop(). The cost of each call to loop()
+ * is therefore independent of the number of sleeping coroutines.
+ *
+ * Like `CoroutineScheduler`, suspended and terminated coroutines are moved to
+ * separate lists, and an ending coroutine is recycled through
+ * `Coroutine::recycleCoroutine()`, so that a `CoroutinePool` gets its slots
+ * back.
+ *
+ * Limitations:
+ *
+ * * Only delays in milliseconds are placed into the heap. Coroutines in
+ *   `COROUTINE_DELAY_MICROS()` or `COROUTINE_DELAY_SECONDS()` remain in the
+ *   linked list and are polled, just like in `CoroutineScheduler`, because
+ *   their deadlines cannot be compared with each other.
+ * * The heap holds at most N coroutines. If it is full, additional delaying
+ *   coroutines remain in the linked list and are polled.
+ * * A coroutine in the heap is not inspected until its deadline expires, so
+ *   `suspend()`, `resume()`, or `reset()` called on a sleeping coroutine takes
+ *   effect only after its original delay has expired.
+ * * The deadlines are compared using 16-bit unsigned arithmetic, so the
+ *   scheduler must be called at least once every 32 seconds. This is the same
+ *   requirement imposed by `Coroutine::setDelayMillis()`.
+ *
+ * Only one scheduler should be used for a given `T_COROUTINE` type, since all
+ * schedulers share the same linked list given by `T_COROUTINE::getRoot()`.
+ *
+ * @tparam T_COROUTINE class of the coroutine, usually `Coroutine`
+ * @tparam N maximum number of sleeping coroutines held in the heap
+ */
+template <typename T_COROUTINE, uint16_t N>
+class CoroutineDeadlineSchedulerTemplate {
+  public:
+    /** Set up the scheduler. Should be called from the global setup(). */
+    static void setup() { getScheduler()->setupScheduler(); }
+
+    /** Set up the coroutines by calling their setupCoroutine() methods. */
+    static void setupCoroutines() {
+      getScheduler()->setupCoroutinesInternal();
+    }
+
+    /**
+     * Run the current coroutine, or the sleeping coroutine whose deadline
+     * has expired.
+     */
+    static void loop() { getScheduler()->runCoroutine(); }
+
+    /**
+     * Print out the known coroutines to the printer (usually Serial),
+     * including the coroutines which are sleeping in the heap.
+     */
+    static void list(Print& printer) {
+      getScheduler()->listCoroutines(printer);
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    CoroutineDeadlineSchedulerTemplate(
+        const CoroutineDeadlineSchedulerTemplate&) = delete;
+    CoroutineDeadlineSchedulerTemplate& operator=(
+        const CoroutineDeadlineSchedulerTemplate&) = delete;
+
+    /** Return the singleton CoroutineDeadlineScheduler. */
+    static CoroutineDeadlineSchedulerTemplate* getScheduler() {
+      static CoroutineDeadlineSchedulerTemplate singletonScheduler;
+      return &singletonScheduler;
+    }
+
+    /** Constructor. */
+    CoroutineDeadlineSchedulerTemplate() = default;
+
+    /**
+     * Set up the Scheduler. Any coroutines left in the heap by a previous
+     * setup() are returned to the linked list so that they are not lost.
+     */
+    void setupScheduler() {
+      T_COROUTINE** root = T_COROUTINE::getRoot();
+      while (! mSleepers.isEmpty()) {
+        T_COROUTINE* sleeper = mSleepers.pop();
+        sleeper->mNext = *root;
+        *root = sleeper;
+      }
+      mCurrent = root;
+    }
+
+    /** Setup each coroutine by calling its setupCoroutine() function. */
+    void setupCoroutinesInternal() {
+      for (T_COROUTINE** p = T_COROUTINE::getRoot();
+          (*p) != nullptr;
+          p = (*p)->getNext()) {
+
+        (*p)->setupCoroutine();
+      }
+    }
+
+    /** Run the current coroutine. */
+    void runCoroutine() {
+      T_COROUTINE::coroutineClockSnapshot();
+
+      // Splice every sleeper which has woken up into the linked list at the
+      // current position, so that they run next.
+      while (! mSleepers.isEmpty() && mSleepers.top()->isDelayExpired()) {
+        T_COROUTINE* expired = mSleepers.pop();
+        expired->mNext = *mCurrent;
+        *mCurrent = expired;
+      }
+
+      // If reached the end, start from the beginning again.
+      if (*mCurrent == nullptr) {
+        mCurrent = T_COROUTINE::getRoot();
+        if (*mCurrent == nullptr) {
+          return;
+        }
+      }
+
+      T_COROUTINE* current = *mCurrent;
+      switch (current->getStatus()) {
+        case T_COROUTINE::kStatusYielding:
+        case T_COROUTINE::kStatusDelaying:
+        case T_COROUTINE::kStatusWaiting:
+          current->runCoroutine();
+          break;
+
+        case T_COROUTINE::kStatusEnding:
+          // mark it terminated, and move it out of the linked list
+          current->setTerminated();
+          unlinkCoroutine(current);
+          current->insertInactive(T_COROUTINE::getTerminatedRoot());
+          current->recycleCoroutine();
+          return;
+
+        case T_COROUTINE::kStatusTerminated:
+          unlinkCoroutine(current);
+          current->insertInactive(T_COROUTINE::getTerminatedRoot());
+          return;
+
+        case T_COROUTINE::kStatusSuspended:
+          // Not visited again until resume() or reset() is called.
+          unlinkCoroutine(current);
+          current->insertInactive(T_COROUTINE::getSuspendedRoot());
+          return;
+
+        default:
+          break;
+      }
+
+      // Move a coroutine that is now sleeping from the linked list into the
+      // heap, and a coroutine in COROUTINE_AWAIT_ON() into its WaitQueue.
+      // Otherwise, go to the next coroutine.
+      if (current->getStatus() == T_COROUTINE::kStatusDelaying
+          && isDelayInMillis(current)
+          && ! mSleepers.isFull()) {
+        unlinkCoroutine(current);
+        current->mNext = nullptr;
+        mSleepers.push(current);
+      } else if (current->getStatus() == T_COROUTINE::kStatusWaiting) {
+        unlinkCoroutine(current);
+        (*T_COROUTINE::getParkingQueue())->park(current);
+      } else {
+        mCurrent = current->getNext();
+      }
+    }
+
+    /**
+     * Return true if the delay of the coroutine is measured by the millis
+     * clock, i.e. it was set by COROUTINE_DELAY(), COROUTINE_DELAY_UNTIL() or
+     * COROUTINE_PERIODIC().
+     */
+    static bool isDelayInMillis(const T_COROUTINE* coroutine) {
+      return coroutine->getDelayType() == T_COROUTINE::kDelayTypeMillis
+          || coroutine->getDelayType() == T_COROUTINE::kDelayTypeDeadline;
+    }
+
+    /**
+     * Remove the current coroutine from the linked list. Note that mCurrent
+     * does not advance, because it now points to the coroutine which followed
+     * the one that was removed.
+     */
+    void unlinkCoroutine(T_COROUTINE* current) {
+      // Skip over any coroutines inserted at the root by
+      // WaitQueue::notify() while the current coroutine was running.
+      while (*mCurrent != current) {
+        mCurrent = (*mCurrent)->getNext();
+      }
+      *mCurrent = current->mNext;
+    }
+
+    /** List all the routines in the linked list, then the heap. */
+    void listCoroutines(Print& printer) {
+      for (T_COROUTINE** p = T_COROUTINE::getRoot(); (*p) != nullptr;
+          p = (*p)->getNext()) {
+        printCoroutine(printer, *p);
+      }
+      for (uint16_t i = 0; i < mSleepers.size(); i++) {
+        printCoroutine(printer, mSleepers.at(i));
+      }
+    }
+
+    /** Print a single coroutine, in the same format as CoroutineScheduler. */
+    static void printCoroutine(Print& printer, T_COROUTINE* coroutine) {
+      printer.print(F("Coroutine "));
+      printer.print((uintptr_t) coroutine);
+      printer.print(':');
+      coroutine->printName(&printer);
+      printer.print('@');
+      printer.print(coroutine->getLineNumber());
+      printer.print(F("; status: "));
+      coroutine->statusPrintTo(printer);
+      printer.println();
+    }
+
+    // The current coroutine, using the same pointer to a pointer as
+    // CoroutineScheduler.
+    T_COROUTINE** mCurrent = nullptr;
+
+    // Sleeping coroutines, ordered by deadline.
+    DeadlineHeap<T_COROUTINE, N> mSleepers;
+};
+
+/**
+ * A CoroutineDeadlineScheduler which can hold up to 16 sleeping coroutines in
+ * its heap. Use CoroutineDeadlineSchedulerTemplate<Coroutine, N> directly for
+ * a different capacity.
+ */
+using CoroutineDeadlineScheduler =
+    CoroutineDeadlineSchedulerTemplate<Coroutine, 16>;
+
+}
+
+#endif
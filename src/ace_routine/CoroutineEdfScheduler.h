@@ -0,0 +1,374 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_COROUTINE_EDF_SCHEDULER_H
+#define ACE_ROUTINE_COROUTINE_EDF_SCHEDULER_H
+
+#include <stdint.h> // uint8_t, uint32_t
+#include "Coroutine.h"
+#include "CoroutineScheduler.h"
+
+namespace ace_routine {
+
+/**
+ * A scheduler which runs periodic coroutines in Earliest Deadline First
+ * order, and the other coroutines round-robin in the remaining time.
+ *
+ * A coroutine becomes periodic when it is admitted with admit(), which gives
+ * its period in milliseconds, and optionally its worst case execution time
+ * (WCET) in microseconds. The admission is rejected if the sum of WCET/period
+ * of all the periodic coroutines would exceed 100%, or if the table of N
+ * periodic coroutines is full. An admitted coroutine is removed from the
+ * linked list of T_COROUTINE.
+ *
+ * The scheduler keeps the release time of the pending job of each periodic
+ * coroutine in its mDelayStart, and the period in its mDelayDuration, so that
+ * the deadline of the job is the getDelayDeadline() of the coroutine. Each
+ * call to loop() runs the released job with the earliest deadline, or if no
+ * job is released, calls CoroutineSchedulerTemplate<T_COROUTINE>::loop() to
+ * run the next coroutine in the linked list.
+ *
+ * Each call to runCoroutine() of a periodic coroutine is one job, so the body
+ * is normally a COROUTINE_LOOP() which ends each job with COROUTINE_YIELD():
+ *
+ * @code
+ * COROUTINE(control) {
+ *   COROUTINE_LOOP() {
+ *     readSensorAndUpdateOutput();
+ *     COROUTINE_YIELD();
+ *   }
+ * }
+ *
+ * void setup() {
+ *   ...
+ *   CoroutineEdfScheduler::admit(&control, 10, 2000); // 10 ms, WCET 2 ms
+ *   CoroutineEdfScheduler::setup();
+ * }
+ * @endcode
+ *
+ * A job which finishes after its deadline is a deadline miss. It increments
+ * the counters returned by getNumDeadlineMisses(), and calls the MissHook if
+ * one was set. A periodic coroutine which falls more than a period behind
+ * skips the jobs that it missed, instead of running them back to back.
+ *
+ * Limitations:
+ *
+ * * The scheduler is not preemptive: a released job waits for the current
+ *   coroutine to yield. The 100% utilization test is exact for preemptive EDF
+ *   only, so the jobs should be short compared to the periods, and the
+ *   background coroutines should yield often.
+ * * The body of a periodic coroutine must not use COROUTINE_DELAY(), which
+ *   would overwrite the release time, or COROUTINE_AWAIT_ON() with a
+ *   WaitQueue. COROUTINE_AWAIT() is polled by each job.
+ * * The deadlines are compared using DelayValue arithmetic, so the period
+ *   must not exceed T_COROUTINE::kMaxDelay (32767 ms with 16-bit delays).
+ * * With the SnapshotClockInterface, the end of a job is seen at the time of
+ *   the snapshot, so only the jobs which start late are reported as missed.
+ *
+ * @tparam T_COROUTINE class of the coroutine, usually `Coroutine`
+ * @tparam N maximum number of periodic coroutines
+ */
+template <typename T_COROUTINE, uint8_t N>
+class CoroutineEdfSchedulerTemplate {
+  public:
+    /** Function called when a job finishes after its deadline. */
+    typedef void (*MissHook)(T_COROUTINE* coroutine);
+
+    /** Utilization of 100%, in parts per million. */
+    static const uint32_t kMaxUtilization = 1000000;
+
+    /**
+     * Set up the scheduler, and the CoroutineScheduler which runs the
+     * coroutines which are not periodic. Should be called from the global
+     * setup(), after admit().
+     */
+    static void setup() {
+      CoroutineSchedulerTemplate<T_COROUTINE>::setup();
+    }
+
+    /**
+     * Run the released job with the earliest deadline, or the next coroutine
+     * which is not periodic.
+     */
+    static void loop() { getScheduler()->runCoroutine(); }
+
+    /**
+     * Make the coroutine periodic, with its first job released now. A
+     * suspended or terminated coroutine is made ready. Return
+     * false and leave the coroutine unchanged if the period is 0 or longer
+     * than T_COROUTINE::kMaxDelay, if the WCET is longer than the period, if
+     * the total utilization would exceed 100%, or if the table of periodic
+     * coroutines is full.
+     *
+     * @param coroutine a coroutine of T_COROUTINE which is not already
+     *    periodic, and is not parked on a WaitQueue
+     * @param periodMillis period, which is also the relative deadline of each
+     *    job
+     * @param wcetMicros worst case execution time of each job. If 0, the
+     *    coroutine does not count against the utilization.
+     */
+    static bool admit(
+        T_COROUTINE* coroutine,
+        uint16_t periodMillis,
+        uint32_t wcetMicros = 0) {
+      return getScheduler()->admitCoroutine(
+          coroutine, periodMillis, wcetMicros);
+    }
+
+    /**
+     * Make a periodic coroutine a normal coroutine again, by inserting it back
+     * into the linked list of T_COROUTINE. Should not be called from the
+     * coroutine itself. Does nothing if the coroutine is not periodic.
+     */
+    static void remove(T_COROUTINE* coroutine) {
+      getScheduler()->removeCoroutine(coroutine);
+    }
+
+    /** Return the total utilization of the periodic coroutines, in ppm. */
+    static uint32_t getUtilization() { return getScheduler()->mUtilization; }
+
+    /** Return the total number of deadline misses. */
+    static uint32_t getNumDeadlineMisses() {
+      return getScheduler()->mNumMisses;
+    }
+
+    /**
+     * Return the number of deadline misses of the given periodic coroutine,
+     * or 0 if it is not periodic.
+     */
+    static uint16_t getNumDeadlineMisses(const T_COROUTINE* coroutine) {
+      CoroutineEdfSchedulerTemplate* scheduler = getScheduler();
+      int16_t i = scheduler->findEntry(coroutine);
+      return (i < 0) ? 0 : scheduler->mEntries[i].numMisses;
+    }
+
+    /** Set the function called on each deadline miss, or nullptr. */
+    static void setMissHook(MissHook hook) {
+      getScheduler()->mMissHook = hook;
+    }
+
+  private:
+    typedef typename T_COROUTINE::DelayValue DelayValue;
+    typedef typename T_COROUTINE::DelayDiff DelayDiff;
+
+    /** A periodic coroutine. */
+    struct Entry {
+      T_COROUTINE* coroutine;
+      uint32_t utilization;
+      uint16_t numMisses;
+      DelayValue period;
+    };
+
+    // Disable copy-constructor and assignment operator
+    CoroutineEdfSchedulerTemplate(const CoroutineEdfSchedulerTemplate&) =
+        delete;
+    CoroutineEdfSchedulerTemplate& operator=(
+        const CoroutineEdfSchedulerTemplate&) = delete;
+
+    /** Return the singleton CoroutineEdfScheduler. */
+    static CoroutineEdfSchedulerTemplate* getScheduler() {
+      static CoroutineEdfSchedulerTemplate singletonScheduler;
+      return &singletonScheduler;
+    }
+
+    /** Constructor. */
+    CoroutineEdfSchedulerTemplate() = default;
+
+    /** Return the index of the entry of the coroutine, or -1. */
+    int16_t findEntry(const T_COROUTINE* coroutine) const {
+      for (uint8_t i = 0; i < mNumEntries; i++) {
+        if (mEntries[i].coroutine == coroutine) return i;
+      }
+      return -1;
+    }
+
+    /**
+     * Return WCET/period in ppm. Split into quotient and remainder so that
+     * it does not overflow 32 bits. The caller checks that wcetMicros is not
+     * longer than the period.
+     */
+    static uint32_t utilizationOf(uint16_t periodMillis, uint32_t wcetMicros) {
+      uint32_t quotient = wcetMicros / periodMillis;
+      uint32_t remainder = wcetMicros % periodMillis;
+      return quotient * 1000 + remainder * 1000 / periodMillis;
+    }
+
+    bool admitCoroutine(
+        T_COROUTINE* coroutine, uint16_t periodMillis, uint32_t wcetMicros) {
+      if (periodMillis == 0 || periodMillis > T_COROUTINE::kMaxDelay) {
+        return false;
+      }
+      if (wcetMicros > (uint32_t) periodMillis * 1000) return false;
+      if (mNumEntries >= N || findEntry(coroutine) >= 0) return false;
+
+      uint32_t utilization = utilizationOf(periodMillis, wcetMicros);
+      if (mUtilization + utilization > kMaxUtilization) return false;
+
+      // Take the coroutine out of the list of suspended or terminated
+      // coroutines, or out of the linked list. If the CoroutineScheduler is
+      // positioned on it, it wraps around to the root on its next loop().
+      if (coroutine->mPrev != nullptr) {
+        coroutine->removeInactive();
+      } else {
+        for (T_COROUTINE** p = T_COROUTINE::getRoot(); *p != nullptr;
+            p = (*p)->getNext()) {
+          if (*p == coroutine) {
+            *p = coroutine->mNext;
+            break;
+          }
+        }
+      }
+      coroutine->mNext = nullptr;
+
+      Entry& entry = mEntries[mNumEntries++];
+      entry.coroutine = coroutine;
+      entry.utilization = utilization;
+      entry.numMisses = 0;
+      entry.period = periodMillis;
+      mUtilization += utilization;
+      release(entry, T_COROUTINE::coroutineMillis());
+      return true;
+    }
+
+    void removeCoroutine(T_COROUTINE* coroutine) {
+      int16_t i = findEntry(coroutine);
+      if (i < 0) return;
+      removeEntry(i);
+      if (! coroutine->isDone()) {
+        coroutine->mStatus = T_COROUTINE::kStatusYielding;
+      }
+      coroutine->insertAtRoot();
+    }
+
+    /** Remove the entry at index i, keeping the others in order. */
+    void removeEntry(uint8_t i) {
+      mUtilization -= mEntries[i].utilization;
+      mNumEntries--;
+      for (; i < mNumEntries; i++) {
+        mEntries[i] = mEntries[i + 1];
+      }
+    }
+
+    /**
+     * Set the release time of the next job of the entry. Its deadline is one
+     * period later.
+     */
+    static void release(Entry& entry, DelayValue releaseMillis) {
+      T_COROUTINE* coroutine = entry.coroutine;
+      coroutine->mDelayStart = releaseMillis;
+      coroutine->mDelayDuration = entry.period;
+      coroutine->mDelayType = T_COROUTINE::kDelayTypeMillis;
+      coroutine->mStatus = T_COROUTINE::kStatusDelaying;
+    }
+
+    /** Return true if the deadline of coroutine a is before coroutine b. */
+    static bool isEarlier(const T_COROUTINE* a, const T_COROUTINE* b) {
+      return (DelayDiff) (a->getDelayDeadline() - b->getDelayDeadline()) < 0;
+    }
+
+    /** Run the released job with the earliest deadline. */
+    void runCoroutine() {
+      T_COROUTINE::coroutineClockSnapshot();
+      DelayValue now = T_COROUTINE::coroutineMillis();
+
+      Entry* next = nullptr;
+      for (uint8_t i = 0; i < mNumEntries; i++) {
+        Entry& entry = mEntries[i];
+        T_COROUTINE* coroutine = entry.coroutine;
+
+        // A coroutine which was resumed or reset is released now.
+        if (coroutine->mStatus == T_COROUTINE::kStatusYielding) {
+          release(entry, now);
+        }
+        if (coroutine->mStatus != T_COROUTINE::kStatusDelaying) continue;
+        if ((DelayDiff) (now - coroutine->mDelayStart) < 0) continue;
+
+        if (next == nullptr || isEarlier(coroutine, next->coroutine)) {
+          next = &entry;
+        }
+      }
+
+      if (next == nullptr) {
+        CoroutineSchedulerTemplate<T_COROUTINE>::loop();
+      } else {
+        runJob(*next);
+      }
+    }
+
+    /** Run one job, then check its deadline and release the next one. */
+    void runJob(Entry& entry) {
+      T_COROUTINE* coroutine = entry.coroutine;
+      DelayValue deadline = coroutine->getDelayDeadline();
+      coroutine->runCoroutine();
+      DelayValue now = T_COROUTINE::coroutineMillis();
+      DelayDiff lateness = (DelayDiff) (now - deadline);
+
+      if (lateness > 0) {
+        entry.numMisses++;
+        mNumMisses++;
+        if (mMissHook != nullptr) mMissHook(coroutine);
+      }
+
+      if (coroutine->mStatus == T_COROUTINE::kStatusEnding) {
+        // Same as CoroutineScheduler: a reset() puts it back into the linked
+        // list, as a normal coroutine.
+        removeEntry(&entry - mEntries);
+        coroutine->setTerminated();
+        coroutine->insertInactive(T_COROUTINE::getTerminatedRoot());
+        coroutine->recycleCoroutine();
+        return;
+      }
+
+      // Release the next job at the deadline of this one, unless the
+      // coroutine is more than a period late, then skip the jobs it missed.
+      release(entry, (lateness > (DelayDiff) entry.period) ? now : deadline);
+    }
+
+    /** Periodic coroutines, in the order in which they were admitted. */
+    Entry mEntries[N];
+
+    /** Number of entries in mEntries. */
+    uint8_t mNumEntries = 0;
+
+    /** Sum of the utilization of the entries, in ppm. */
+    uint32_t mUtilization = 0;
+
+    /** Total number of deadline misses. */
+    uint32_t mNumMisses = 0;
+
+    /** Called on each deadline miss, if not nullptr. */
+    MissHook mMissHook = nullptr;
+};
+
+/**
+ * A CoroutineEdfScheduler which can hold up to 8 periodic coroutines. Use
+ * CoroutineEdfSchedulerTemplate<Coroutine, N> directly for a different
+ * capacity.
+ */
+using CoroutineEdfScheduler = CoroutineEdfSchedulerTemplate<Coroutine, 8>;
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_GROUP_H
+#define ACE_ROUTINE_COROUTINE_GROUP_H
+
+#include <stdint.h> // uint8_t
+#include "Coroutine.h"
+
+namespace ace_routine {
+
+/**
+ * A fixed group of coroutines which can be suspended, resumed or reset
+ * together, for example all the coroutines which serve a peripheral that is
+ * turned on only on demand. The group does not own the coroutines, it holds a
+ * pointer to an array of pointers to them:
+ *
+ * @code
+ * Coroutine* const sensorCoroutines[] = {&readTemperature, &readHumidity};
+ * CoroutineGroup sensors(sensorCoroutines);
+ * ...
+ * sensors.suspend();
+ * ...
+ * sensors.resume();
+ * @endcode
+ *
+ * Suspended coroutines are moved out of the CoroutineScheduler linked list
+ * when the scheduler reaches them, and resume() moves each one back in O(1)
+ * time, so the cost of a scheduler pass depends only on the number of active
+ * coroutines.
+ *
+ * @tparam T_COROUTINE class of the coroutine, usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class CoroutineGroupTemplate {
+  public:
+    /** Constructor from an array of pointers and its size. */
+    CoroutineGroupTemplate(T_COROUTINE* const* coroutines, uint8_t size) :
+        mCoroutines(coroutines),
+        mSize(size)
+    {}
+
+    /** Constructor from an array of pointers, inferring its size. */
+    template <uint8_t N>
+    explicit CoroutineGroupTemplate(T_COROUTINE* const (&coroutines)[N]) :
+        mCoroutines(coroutines),
+        mSize(N)
+    {}
+
+    /** Call suspend() on every coroutine of the group. */
+    void suspend() {
+      for (uint8_t i = 0; i < mSize; i++) mCoroutines[i]->suspend();
+    }
+
+    /** Call resume() on every coroutine of the group. */
+    void resume() {
+      for (uint8_t i = 0; i < mSize; i++) mCoroutines[i]->resume();
+    }
+
+    /** Call reset() on every coroutine of the group. */
+    void reset() {
+      for (uint8_t i = 0; i < mSize; i++) mCoroutines[i]->reset();
+    }
+
+    /** Return true if every coroutine of the group is done. */
+    bool isDone() const {
+      for (uint8_t i = 0; i < mSize; i++) {
+        if (! mCoroutines[i]->isDone()) return false;
+      }
+      return true;
+    }
+
+    /** Return the number of coroutines in the group. */
+    uint8_t size() const { return mSize; }
+
+  private:
+    T_COROUTINE* const* const mCoroutines;
+    uint8_t const mSize;
+};
+
+/** A CoroutineGroup for coroutines using the default ClockInterface. */
+using CoroutineGroup = CoroutineGroupTemplate<Coroutine>;
+
+}
+
+#endif
@@ -0,0 +1,211 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_COROUTINE_PARTITION_H
+#define ACE_ROUTINE_COROUTINE_PARTITION_H
+
+#include <stdint.h> // uint16_t, uint32_t
+#include "Coroutine.h"
+#include "CoroutineScheduler.h"
+
+class Print;
+
+namespace ace_routine {
+
+/**
+ * A coroutine which runs its own linked list of coroutines, using its own
+ * instance of `CoroutineSchedulerTemplate`. A partition groups the coroutines
+ * of a subsystem, so that the whole subsystem can be run at a lower rate, or
+ * given a time budget, without changing the code of its coroutines:
+ *
+ * @code
+ * CoroutinePartition housekeeping(10); // every 10 ms
+ *
+ * void setup() {
+ *   housekeeping.add(&logger);
+ *   housekeeping.add(&batteryMonitor);
+ *   CoroutineScheduler::setup();
+ * }
+ *
+ * void loop() {
+ *   CoroutineScheduler::loop(); // also runs 'housekeeping'
+ * }
+ * @endcode
+ *
+ * Since a partition is itself a coroutine, it is run by the
+ * `CoroutineScheduler` like any other coroutine, and can be added to another
+ * partition to build a hierarchy. Each time it runs, it runs one pass through
+ * its linked list, then waits for periodMillis using `COROUTINE_DELAY()`, or
+ * yields if periodMillis is 0. If budgetMicros is not 0, the pass stops as
+ * soon as budgetMicros has elapsed (after at least one coroutine), and the
+ * next run continues where it stopped, so that the coroutines of the
+ * partition still take turns.
+ *
+ * A partition can also be used without the `CoroutineScheduler`, by calling
+ * its loop(), loopFor() or runOnePass() methods, which mirror the static
+ * methods of the `CoroutineScheduler`.
+ *
+ * The coroutines of a partition stay in it when they are suspended and
+ * resumed, reset, or parked on a `WaitQueue` and notified. This needs the
+ * `Coroutine::mHome` pointer, so add() requires ACE_ROUTINE_PARTITIONS to be
+ * defined to 1 before the first `#include <AceRoutine.h>`. Suspended and
+ * terminated coroutines are kept in the same lists as the other coroutines,
+ * so they are printed by `CoroutineScheduler::list()`, not by list().
+ *
+ * @tparam T_COROUTINE class of the coroutine, usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class CoroutinePartitionTemplate: public T_COROUTINE {
+  public:
+    /** Producer/consumer pair given to setDependencies(). */
+    using Dependency =
+        typename CoroutineSchedulerTemplate<T_COROUTINE>::Dependency;
+
+    /**
+     * Constructor.
+     *
+     * @param periodMillis delay between the passes through the coroutines of
+     *    the partition, or 0 to run a pass every time the partition runs
+     * @param budgetMicros maximum duration of a pass, or 0 for no limit
+     */
+    explicit CoroutinePartitionTemplate(
+        uint16_t periodMillis = 0, uint32_t budgetMicros = 0) :
+        mScheduler(&mHead),
+        mPeriodMillis(periodMillis),
+        mBudgetMicros(budgetMicros)
+    {}
+
+    /**
+     * Move the coroutine from the linked list of its current scheduler into
+     * this partition. Should be called from the global setup(), before the
+     * scheduler which runs the coroutine is set up, because the coroutine is
+     * removed from a linked list that the scheduler could be walking.
+     */
+    void add(T_COROUTINE* coroutine) {
+      static_assert(ACE_ROUTINE_PARTITIONS || sizeof(T_COROUTINE) == 0,
+          "CoroutinePartition::add() requires ACE_ROUTINE_PARTITIONS=1");
+      coroutine->moveTo(&mHead);
+    }
+
+    /** Set the delay between the passes through the coroutines. */
+    void setPeriodMillis(uint16_t periodMillis) {
+      mPeriodMillis = periodMillis;
+    }
+
+    /** Return the delay between the passes through the coroutines. */
+    uint16_t getPeriodMillis() const { return mPeriodMillis; }
+
+    /** Set the maximum duration of a pass, or 0 for no limit. */
+    void setBudgetMicros(uint32_t budgetMicros) {
+      mBudgetMicros = budgetMicros;
+    }
+
+    /** Return the maximum duration of a pass. */
+    uint32_t getBudgetMicros() const { return mBudgetMicros; }
+
+    /** Run the current coroutine of the partition. */
+    void loop() { mScheduler.runCoroutine(); }
+
+    /** Run the coroutines of the partition until budgetMicros has elapsed. */
+    void loopFor(uint32_t budgetMicros) {
+      mScheduler.runCoroutinesFor(budgetMicros);
+    }
+
+    /**
+     * Run the coroutines of the partition from the current position to the end
+     * of its linked list.
+     */
+    void runOnePass() { mScheduler.runCoroutinesToEnd(); }
+
+    /**
+     * Dispatch the coroutines of the partition in the topological order of
+     * the given dependencies. Same as CoroutineScheduler::setDependencies().
+     */
+    bool setDependencies(
+        const Dependency* dependencies, uint8_t numDependencies) {
+      return mScheduler.sortDependencies(dependencies, numDependencies);
+    }
+
+    /** Print out the coroutines in the linked list of the partition. */
+    void list(Print& printer) {
+      mScheduler.listCoroutines(printer, &mHead);
+    }
+
+    /** Run a pass, then wait for the period. */
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        runPass();
+        if (mPeriodMillis == 0) {
+          COROUTINE_YIELD();
+        } else {
+          COROUTINE_DELAY(mPeriodMillis);
+        }
+      }
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    CoroutinePartitionTemplate(const CoroutinePartitionTemplate&) = delete;
+    CoroutinePartitionTemplate& operator=(const CoroutinePartitionTemplate&) =
+        delete;
+
+    /**
+     * Run the coroutines to the end of the linked list, stopping early if the
+     * budget has elapsed.
+     */
+    void runPass() {
+      if (mBudgetMicros == 0) {
+        mScheduler.runCoroutinesToEnd();
+        return;
+      }
+
+      T_COROUTINE::coroutineClockSnapshot();
+      uint32_t start = T_COROUTINE::coroutineMicros();
+      do {
+        mScheduler.runCoroutine();
+        T_COROUTINE::coroutineClockSnapshot();
+        if ((uint32_t) (T_COROUTINE::coroutineMicros() - start)
+            >= mBudgetMicros) {
+          break;
+        }
+      } while (*mScheduler.mCurrent != nullptr);
+    }
+
+    /** Root of the linked list of the coroutines of this partition. */
+    T_COROUTINE* mHead = nullptr;
+
+    /** Scheduler which runs the linked list starting at mHead. */
+    CoroutineSchedulerTemplate<T_COROUTINE> mScheduler;
+
+    uint16_t mPeriodMillis;
+    uint32_t mBudgetMicros;
+};
+
+/** A CoroutinePartition for coroutines using the default ClockInterface. */
+using CoroutinePartition = CoroutinePartitionTemplate<Coroutine>;
+
+}
+
+#endif
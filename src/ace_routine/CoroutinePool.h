@@ -0,0 +1,155 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_POOL_H
+#define ACE_ROUTINE_COROUTINE_POOL_H
+
+#include <stdint.h> // uint8_t
+#include <stddef.h> // size_t
+#if defined(ARDUINO_ARCH_AVR)
+  #include <new.h> // placement new
+#else
+  #include <new> // placement new
+#endif
+#include "Coroutine.h"
+
+namespace ace_routine {
+
+/**
+ * A fixed pool of N coroutines of class T, allocated statically, which allows
+ * short-lived coroutines to be spawned (e.g. one per incoming request) without
+ * using the heap. The storage for the coroutines is reserved inside the pool,
+ * but a coroutine is constructed only when spawn() is called, which also
+ * inserts it at the head of the CoroutineScheduler linked list.
+ *
+ * When the coroutine reaches COROUTINE_END(), the CoroutineScheduler removes
+ * it from its linked list and calls recycleCoroutine(), which destroys it and
+ * returns its slot to the free list of the pool. Both spawn() and the recycling
+ * take constant time.
+ *
+ * @code
+ * class RequestHandler: public Coroutine {
+ *   public:
+ *     RequestHandler(uint8_t id) : mId(id) {}
+ *     int runCoroutine() override { ... }
+ * };
+ *
+ * CoroutinePool<RequestHandler, 4> handlers;
+ *
+ * void loop() {
+ *   if (requestReady()) handlers.spawn(requestId);
+ *   CoroutineScheduler::loop();
+ * }
+ * @endcode
+ *
+ * Restrictions:
+ *
+ * * Coroutines are recycled only by the CoroutineScheduler. A coroutine which
+ *   is run directly, or by another scheduler, is never returned to the pool.
+ * * The pointer returned by spawn() becomes invalid after the coroutine
+ *   terminates. It must not be used after the coroutine is done, including
+ *   calling reset() on it.
+ * * T must not override recycleCoroutine().
+ *
+ * @tparam T class of the coroutine, a subclass of `Coroutine` (or
+ *    `CoroutineTemplate`)
+ * @tparam N number of coroutines in the pool, at most 255
+ */
+template <typename T, uint8_t N>
+class CoroutinePool {
+  public:
+    /** Constructor. All coroutines are free. */
+    CoroutinePool() {
+      for (uint8_t i = 0; i < N; i++) {
+        mFree[i] = N - 1 - i;
+      }
+    }
+
+    /**
+     * Construct a coroutine with the given constructor arguments in a free
+     * slot, and insert it at the head of the CoroutineScheduler linked list.
+     * Return nullptr if all coroutines of the pool are in use.
+     */
+    template <typename... Args>
+    T* spawn(const Args&... args) {
+      if (mNumFree == 0) return nullptr;
+      uint8_t index = mFree[--mNumFree];
+      return new (slotAt(index)) Slot(this, args...);
+    }
+
+    /** Return the number of free coroutines. */
+    uint8_t available() const { return mNumFree; }
+
+    /** Return the number of coroutines in the pool. */
+    static uint8_t capacity() { return N; }
+
+  private:
+    /** The coroutine T, which returns itself to the pool when terminated. */
+    class Slot: public T {
+      public:
+        template <typename... Args>
+        Slot(CoroutinePool* pool, const Args&... args) :
+            T(args...),
+            mPool(pool)
+        {}
+
+        void recycleCoroutine() override { mPool->release(this); }
+
+      private:
+        CoroutinePool* const mPool;
+    };
+
+    // Disable copy-constructor and assignment operator
+    CoroutinePool(const CoroutinePool&) = delete;
+    CoroutinePool& operator=(const CoroutinePool&) = delete;
+
+    /** Return the storage of the slot at index. */
+    void* slotAt(uint8_t index) {
+      return mStorage + (size_t) index * sizeof(Slot);
+    }
+
+    /**
+     * Remove the terminated coroutine from the list of terminated coroutines,
+     * destroy it, and put its slot back into the free list.
+     */
+    void release(Slot* slot) {
+      slot->removeInactive();
+      slot->~Slot();
+      mFree[mNumFree++] =
+          ((uint8_t*) slot - mStorage) / sizeof(Slot);
+    }
+
+    /** Storage for N coroutines, constructed by spawn(). */
+    alignas(Slot) uint8_t mStorage[N * sizeof(Slot)];
+
+    /** Stack of the indexes of the free slots. */
+    uint8_t mFree[N];
+
+    /** Number of free slots. */
+    uint8_t mNumFree = N;
+};
+
+}
+
+#endif
@@ -0,0 +1,466 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_PRIORITY_SCHEDULER_H
+#define ACE_ROUTINE_COROUTINE_PRIORITY_SCHEDULER_H
+
+#include <stdint.h> // uint8_t
+#include "Coroutine.h"
+#include "DeadlineHeap.h"
+#include "WaitQueue.h"
+
+class Print;
+
+namespace ace_routine {
+
+/**
+ * An alternative to `CoroutineSchedulerTemplate` which always runs a
+ * coroutine from the highest priority level which has a coroutine ready to
+ * run. The priority of a coroutine is set using `Coroutine::setPriority()`,
+ * from 0 (lowest, the default) to `kMaxPriority` (highest). The priority is
+ * stored in each Coroutine only if ACE_ROUTINE_PRIORITIES is defined to 1
+ * before the first `#include <AceRoutine.h>`, which this scheduler requires.
+ *
+ * The setup() method moves every coroutine from the linked list given by
+ * `T_COROUTINE::getRoot()` into one of 8 ready lists, one per priority level,
+ * preserving the order of the original list. A bit in an 8-bit ready bitmap is
+ * set for each level whose ready list is not empty, so that the highest ready
+ * level is found in constant time using count-leading-zeros. Within a level,
+ * the coroutines are run round-robin, in the same order as
+ * `CoroutineScheduler`.
+ *
+ * A coroutine which is not ready to run is moved out of the ready lists, so
+ * that it costs nothing on each call to loop():
+ *
+ * * A coroutine in `COROUTINE_DELAY()`, `COROUTINE_DELAY_UNTIL()` or
+ *   `COROUTINE_PERIODIC()` is placed into a min-heap of up to N coroutines
+ *   ordered by deadline (see DeadlineHeap), shared by all levels. Each call
+ *   to loop() moves every coroutine whose deadline has expired back to its
+ *   ready list, checking only the top of the heap otherwise.
+ * * A coroutine in `COROUTINE_DELAY_MICROS()`, `COROUTINE_DELAY_NANOS()` or
+ *   `COROUTINE_DELAY_SECONDS()`, or in `COROUTINE_DELAY()` when the heap is
+ *   full, is moved to the blocked list of its level, and is polled.
+ * * A suspended or terminated coroutine is moved to the same list of
+ *   suspended or terminated coroutines as `CoroutineScheduler`, and returns
+ *   to its ready list only after `resume()` or `reset()`. An ending coroutine
+ *   is recycled through `recycleCoroutine()`.
+ * * A coroutine in `COROUTINE_AWAIT_ON()` is parked on its `WaitQueue`, and
+ *   returns to its ready list after `WaitQueue::notify()`.
+ *
+ * Before choosing a level, loop() checks the blocked lists of the levels at or
+ * above the highest ready level, so a blocked high priority coroutine
+ * preempts the lower levels as soon as it becomes ready. The blocked
+ * coroutines at lower levels are not checked until no higher level is ready.
+ * The cost of loop() therefore depends only on the number of coroutines
+ * delaying in micros or seconds at those levels, and on the number of
+ * expired sleepers, not on the number of sleeping, suspended or terminated
+ * coroutines.
+ *
+ * A coroutine in the heap is not inspected until its deadline expires, so
+ * `suspend()`, `resume()` or `reset()` called on a sleeping coroutine takes
+ * effect only after its original delay has expired, as in
+ * `CoroutineDeadlineScheduler`.
+ *
+ * Strict priority means that a higher priority coroutine which never blocks,
+ * for example one which only uses `COROUTINE_YIELD()` or `COROUTINE_AWAIT()`,
+ * starves all coroutines at lower levels. High priority coroutines should
+ * wait using `COROUTINE_DELAY()` or `COROUTINE_AWAIT_ON()`.
+ *
+ * A change to the priority of a coroutine takes effect the next time the
+ * coroutine moves between its ready list and its blocked list. Coroutines
+ * created after setup() are picked up from `T_COROUTINE::getRoot()` on the
+ * next call to loop().
+ *
+ * Only one scheduler should be used for a given `T_COROUTINE` type, since all
+ * schedulers share the same linked list given by `T_COROUTINE::getRoot()`.
+ *
+ * @tparam T_COROUTINE class of the coroutine, usually `Coroutine`
+ * @tparam N maximum number of sleeping coroutines held in the heap
+ */
+template <typename T_COROUTINE, uint16_t N>
+class CoroutinePrioritySchedulerTemplate {
+    static_assert(ACE_ROUTINE_PRIORITIES || sizeof(T_COROUTINE) == 0,
+        "CoroutinePriorityScheduler requires ACE_ROUTINE_PRIORITIES=1");
+
+  public:
+    /** Number of priority levels. Must fit into the bits of uint8_t. */
+    static const uint8_t kNumPriorities = 8;
+
+    /** Highest priority level. */
+    static const uint8_t kMaxPriority = kNumPriorities - 1;
+
+    /** Set up the scheduler. Should be called from the global setup(). */
+    static void setup() { getScheduler()->setupScheduler(); }
+
+    /** Set up the coroutines by calling their setupCoroutine() methods. */
+    static void setupCoroutines() {
+      getScheduler()->setupCoroutinesInternal();
+    }
+
+    /** Run the next coroutine of the highest ready priority level. */
+    static void loop() { getScheduler()->runCoroutine(); }
+
+    /**
+     * Print out the known coroutines to the printer (usually Serial), from
+     * the highest priority level to the lowest.
+     */
+    static void list(Print& printer) {
+      getScheduler()->listCoroutines(printer);
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    CoroutinePrioritySchedulerTemplate(
+        const CoroutinePrioritySchedulerTemplate&) = delete;
+    CoroutinePrioritySchedulerTemplate& operator=(
+        const CoroutinePrioritySchedulerTemplate&) = delete;
+
+    /** Return the singleton CoroutinePriorityScheduler. */
+    static CoroutinePrioritySchedulerTemplate* getScheduler() {
+      static CoroutinePrioritySchedulerTemplate singletonScheduler;
+      return &singletonScheduler;
+    }
+
+    /**
+     * Return the index of the highest bit which is set, or -1 if no bits are
+     * set. Compiles into a single instruction on most 32-bit processors.
+     */
+    static int8_t highestBit(uint8_t bits) {
+      if (bits == 0) return -1;
+      return (int8_t) (sizeof(unsigned) * 8 - 1
+          - __builtin_clz((unsigned) bits));
+    }
+
+    /** Return the priority level of the coroutine, clamped to kMaxPriority. */
+    static uint8_t levelOf(const T_COROUTINE* coroutine) {
+      uint8_t priority = coroutine->getPriority();
+      if (priority > kMaxPriority) return kMaxPriority;
+      return priority;
+    }
+
+    /** Constructor. */
+    CoroutinePrioritySchedulerTemplate() = default;
+
+    /**
+     * Set up the Scheduler. The coroutines in the linked list are appended to
+     * the ready lists, so that the round-robin order within a level is the
+     * same as the order of the linked list. Suspended and terminated
+     * coroutines are moved to their inactive lists instead.
+     */
+    void setupScheduler() {
+      T_COROUTINE** tails[kNumPriorities];
+      for (uint8_t level = 0; level < kNumPriorities; level++) {
+        tails[level] = &mReady[level];
+        while (*tails[level] != nullptr) {
+          tails[level] = (*tails[level])->getNext();
+        }
+        mCursors[level] = &mReady[level];
+      }
+
+      T_COROUTINE** root = T_COROUTINE::getRoot();
+      while (*root != nullptr) {
+        T_COROUTINE* coroutine = *root;
+        *root = coroutine->mNext;
+        coroutine->mNext = nullptr;
+        if (coroutine->isSuspended() || coroutine->isTerminated()) {
+          deactivate(coroutine);
+          continue;
+        }
+
+        uint8_t level = levelOf(coroutine);
+        *tails[level] = coroutine;
+        tails[level] = coroutine->getNext();
+        mReadyBits |= (1 << level);
+      }
+    }
+
+    /** Setup each coroutine by calling its setupCoroutine() function. */
+    void setupCoroutinesInternal() {
+      for (T_COROUTINE** p = T_COROUTINE::getRoot(); (*p) != nullptr;
+          p = (*p)->getNext()) {
+        (*p)->setupCoroutine();
+      }
+      for (uint8_t level = 0; level < kNumPriorities; level++) {
+        for (T_COROUTINE* p = mReady[level]; p != nullptr; p = p->mNext) {
+          p->setupCoroutine();
+        }
+        for (T_COROUTINE* p = mBlocked[level]; p != nullptr; p = p->mNext) {
+          p->setupCoroutine();
+        }
+      }
+      for (uint16_t i = 0; i < mSleepers.size(); i++) {
+        mSleepers.at(i)->setupCoroutine();
+      }
+    }
+
+    /** Run the current coroutine of the highest ready level. */
+    void runCoroutine() {
+      T_COROUTINE::coroutineClockSnapshot();
+
+      // Pick up coroutines inserted at the root by WaitQueue::notify() or
+      // created after setup().
+      T_COROUTINE** root = T_COROUTINE::getRoot();
+      while (*root != nullptr) {
+        T_COROUTINE* coroutine = *root;
+        *root = coroutine->mNext;
+        insertReady(coroutine);
+      }
+
+      // Move every sleeper whose deadline has expired back to its level.
+      while (! mSleepers.isEmpty() && mSleepers.top()->isDelayExpired()) {
+        insertReady(mSleepers.pop());
+      }
+
+      // Wake up the polled blocked coroutines which could run ahead of, or
+      // round-robin with, the highest ready level.
+      int8_t top = highestBit(mReadyBits);
+      uint8_t candidates = (top < 0)
+          ? mBlockedBits
+          : (uint8_t) (mBlockedBits & ~((1 << top) - 1));
+      while (candidates) {
+        int8_t level = highestBit(candidates);
+        candidates &= ~(1 << level);
+        wakeBlocked(level);
+      }
+
+      top = highestBit(mReadyBits);
+      if (top < 0) return;
+
+      // If reached the end of the level, start from its beginning again.
+      T_COROUTINE** cursor = mCursors[top];
+      if (*cursor == nullptr) {
+        cursor = &mReady[top];
+      }
+
+      // Handle the coroutine's dispatch back to the last known internal status.
+      T_COROUTINE* current = *cursor;
+      bool ended = false;
+      switch (current->getStatus()) {
+        case T_COROUTINE::kStatusYielding:
+        case T_COROUTINE::kStatusDelaying:
+        case T_COROUTINE::kStatusWaiting:
+          current->runCoroutine();
+          break;
+
+        case T_COROUTINE::kStatusEnding:
+          current->setTerminated();
+          ended = true;
+          break;
+
+        default:
+          break;
+      }
+
+      // A coroutine which can run again stays in the ready list. Otherwise
+      // move it out, and the cursor then points to the following coroutine.
+      // WaitQueue::notify() inserts at the root, not into the ready lists, so
+      // the cursor is still valid.
+      if (isReady(current)) {
+        mCursors[top] = current->getNext();
+        return;
+      }
+
+      *cursor = current->mNext;
+      mCursors[top] = cursor;
+      if (mReady[top] == nullptr) {
+        mReadyBits &= ~(1 << top);
+      }
+
+      deactivate(current);
+      if (ended) current->recycleCoroutine();
+    }
+
+    /**
+     * Return true if the coroutine can be run without waiting for a delay, a
+     * resume(), a reset(), or a notify().
+     */
+    static bool isReady(const T_COROUTINE* coroutine) {
+      // A Delaying coroutine is not ready, even if its delay is 0, so that it
+      // yields to the other coroutines. Its delay is checked by wakeBlocked().
+      return coroutine->isYielding() || coroutine->isEnding();
+    }
+
+    /**
+     * Return true if the delay of the coroutine is measured by the millis
+     * clock, so that it can be placed into the heap.
+     */
+    static bool isDelayInMillis(const T_COROUTINE* coroutine) {
+      return coroutine->getDelayType() == T_COROUTINE::kDelayTypeMillis
+          || coroutine->getDelayType() == T_COROUTINE::kDelayTypeDeadline;
+    }
+
+    /** Return true if the delay of a Delaying coroutine has expired. */
+    static bool isDelayOver(const T_COROUTINE* coroutine) {
+      switch (coroutine->getDelayType()) {
+        case T_COROUTINE::kDelayTypeMicros:
+        case T_COROUTINE::kDelayTypeMicrosPrecise:
+          return coroutine->isDelayMicrosExpired();
+        case T_COROUTINE::kDelayTypeNanos:
+          return coroutine->isDelayNanosExpired();
+        case T_COROUTINE::kDelayTypeSeconds:
+          return coroutine->isDelaySecondsExpired();
+        default:
+          return coroutine->isDelayExpired();
+      }
+    }
+
+    /**
+     * Insert the coroutine at the cursor of its ready list, so that it runs
+     * next within its level. A suspended or terminated coroutine is moved to
+     * its inactive list instead.
+     */
+    void insertReady(T_COROUTINE* coroutine) {
+      if (coroutine->isSuspended() || coroutine->isTerminated()) {
+        deactivate(coroutine);
+        return;
+      }
+      uint8_t level = levelOf(coroutine);
+      coroutine->mNext = *mCursors[level];
+      *mCursors[level] = coroutine;
+      mReadyBits |= (1 << level);
+    }
+
+    /**
+     * Move a coroutine which has been removed from its ready list, and cannot
+     * run yet, to the place which wakes it up: its WaitQueue, the heap, the
+     * blocked list of its level, or the list of suspended or terminated
+     * coroutines.
+     */
+    void deactivate(T_COROUTINE* coroutine) {
+      switch (coroutine->getStatus()) {
+        case T_COROUTINE::kStatusWaiting:
+          (*T_COROUTINE::getParkingQueue())->park(coroutine);
+          break;
+
+        case T_COROUTINE::kStatusDelaying:
+          if (isDelayInMillis(coroutine) && ! mSleepers.isFull()) {
+            coroutine->mNext = nullptr;
+            mSleepers.push(coroutine);
+          } else {
+            uint8_t level = levelOf(coroutine);
+            coroutine->mNext = mBlocked[level];
+            mBlocked[level] = coroutine;
+            mBlockedBits |= (1 << level);
+          }
+          break;
+
+        case T_COROUTINE::kStatusSuspended:
+          coroutine->insertInactive(T_COROUTINE::getSuspendedRoot());
+          break;
+
+        default:
+          coroutine->insertInactive(T_COROUTINE::getTerminatedRoot());
+          break;
+      }
+    }
+
+    /**
+     * Move the coroutines of the given blocked list whose delays have expired
+     * back to their ready list. A coroutine whose status was changed by
+     * suspend() or reset() while it was delaying is moved as well, to its
+     * inactive list or its ready list.
+     */
+    void wakeBlocked(uint8_t level) {
+      T_COROUTINE** p = &mBlocked[level];
+      while (*p != nullptr) {
+        T_COROUTINE* coroutine = *p;
+        if (! coroutine->isDelaying() || isDelayOver(coroutine)) {
+          *p = coroutine->mNext;
+          insertReady(coroutine);
+        } else {
+          p = coroutine->getNext();
+        }
+      }
+      if (mBlocked[level] == nullptr) {
+        mBlockedBits &= ~(1 << level);
+      }
+    }
+
+    /** List the coroutines, from the highest priority level to the lowest. */
+    void listCoroutines(Print& printer) {
+      for (T_COROUTINE** p = T_COROUTINE::getRoot(); (*p) != nullptr;
+          p = (*p)->getNext()) {
+        printCoroutine(printer, *p);
+      }
+      for (int8_t level = kMaxPriority; level >= 0; level--) {
+        for (T_COROUTINE* p = mReady[level]; p != nullptr; p = p->mNext) {
+          printCoroutine(printer, p);
+        }
+        for (T_COROUTINE* p = mBlocked[level]; p != nullptr; p = p->mNext) {
+          printCoroutine(printer, p);
+        }
+      }
+      for (uint16_t i = 0; i < mSleepers.size(); i++) {
+        printCoroutine(printer, mSleepers.at(i));
+      }
+    }
+
+    /** Print a single coroutine, in the same format as CoroutineScheduler. */
+    static void printCoroutine(Print& printer, T_COROUTINE* coroutine) {
+      printer.print(F("Coroutine "));
+      printer.print((uintptr_t) coroutine);
+      printer.print(':');
+      coroutine->printName(&printer);
+      printer.print('@');
+      printer.print(coroutine->getLineNumber());
+      printer.print(F("; priority: "));
+      printer.print(coroutine->getPriority());
+      printer.print(F("; status: "));
+      coroutine->statusPrintTo(printer);
+      printer.println();
+    }
+
+    // Coroutines which can run, one list per priority level.
+    T_COROUTINE* mReady[kNumPriorities] = {};
+
+    // The round-robin position within each ready list, using the same
+    // pointer to a pointer as CoroutineScheduler.
+    T_COROUTINE** mCursors[kNumPriorities] = {};
+
+    // Coroutines delaying in micros or seconds, or in millis when the heap
+    // is full. Polled by wakeBlocked().
+    T_COROUTINE* mBlocked[kNumPriorities] = {};
+
+    // Coroutines delaying in millis, ordered by deadline.
+    DeadlineHeap<T_COROUTINE, N> mSleepers;
+
+    // Bit N is set if mReady[N] is not empty.
+    uint8_t mReadyBits = 0;
+
+    // Bit N is set if mBlocked[N] is not empty.
+    uint8_t mBlockedBits = 0;
+};
+
+/**
+ * A CoroutinePriorityScheduler for the default Coroutine, which can hold up
+ * to 16 sleeping coroutines in its heap. Use
+ * CoroutinePrioritySchedulerTemplate<Coroutine, N> directly for a different
+ * capacity.
+ */
+using CoroutinePriorityScheduler =
+    CoroutinePrioritySchedulerTemplate<Coroutine, 16>;
+
+}
+
+#endif
@@ -0,0 +1,300 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_REGISTRY_SCHEDULER_H
+#define ACE_ROUTINE_COROUTINE_REGISTRY_SCHEDULER_H
+
+#include <stdint.h> // uint16_t, uint32_t
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+  #include <arm_neon.h>
+#endif
+#include "Coroutine.h"
+
+namespace ace_routine {
+
+/**
+ * An alternative to `CoroutineSchedulerTemplate` for a large number of
+ * coroutines, mostly sleeping, on processors with a data cache (e.g. Linux or
+ * ESP32).
+ *
+ * The `CoroutineScheduler` follows the `mNext` pointers of coroutines which
+ * are scattered through memory, and reads the `mStatus` of each one, so that
+ * every coroutine visited costs at least one cache miss. This scheduler copies
+ * the linked list into a registry of N entries during setup(), and keeps the
+ * state needed to decide whether a coroutine is due in contiguous arrays,
+ * separate from the coroutines themselves: the wake-up time of each coroutine
+ * in milliseconds, and a flag for the coroutines which are suspended or
+ * terminated. The cold state (the jump pointer, the line number, the name)
+ * stays in the coroutine, which is touched only when it is run.
+ *
+ * Each pass scans the wake-up times 4 at a time, using SSE2 on x86 and NEON on
+ * ARM, or a plain loop elsewhere. A sleeping coroutine costs 4 bytes of the
+ * scan instead of a call to its runCoroutine().
+ *
+ * Limitations:
+ *
+ * * Coroutines created after setup() are not run until setup() is called
+ *   again. At most N coroutines are registered, the rest are ignored.
+ * * The wake-up time of a coroutine in `COROUTINE_DELAY_MICROS()` is rounded
+ *   down to the millisecond, so it is polled like in `CoroutineScheduler`.
+ *   A coroutine may be run slightly early, in which case its
+ *   `COROUTINE_DELAY()` simply waits again.
+ * * A sleeping coroutine is not inspected until it is due, so `suspend()`
+ *   takes effect only when its delay has expired. After `resume()` or
+ *   `reset()` of a suspended or terminated coroutine, refresh() must be
+ *   called to put it back into the rotation.
+ * * A coroutine in `COROUTINE_AWAIT_ON()` is polled on each pass instead of
+ *   being parked on its `WaitQueue`.
+ *
+ * Only one scheduler should be used for a given `T_COROUTINE` type, since all
+ * schedulers share the same linked list given by `T_COROUTINE::getRoot()`.
+ *
+ * @tparam T_COROUTINE class of the coroutine, usually `Coroutine`
+ * @tparam N maximum number of coroutines in the registry
+ */
+template <typename T_COROUTINE, uint16_t N>
+class CoroutineRegistrySchedulerTemplate {
+  public:
+    /**
+     * Copy the coroutines from the linked list into the registry, and start
+     * from the first one. Should be called from the global setup().
+     */
+    static void setup() { getScheduler()->setupScheduler(); }
+
+    /**
+     * Run the next coroutine which is due. If no coroutine is due until the
+     * end of the registry, return without running any, and start a new pass
+     * on the next call.
+     */
+    static void loop() { getScheduler()->runCoroutine(); }
+
+    /**
+     * Run the due coroutines from the current position to the end of the
+     * registry.
+     */
+    static void runOnePass() {
+      CoroutineRegistrySchedulerTemplate* scheduler = getScheduler();
+      do {
+        scheduler->runCoroutine();
+      } while (scheduler->mCurrent < scheduler->mNumCoroutines);
+    }
+
+    /**
+     * Re-read the status of the suspended and terminated coroutines, and put
+     * those which were resumed or reset back into the rotation.
+     */
+    static void refresh() { getScheduler()->refreshParked(); }
+
+    /** Return the number of coroutines in the registry. */
+    static uint16_t getNumCoroutines() {
+      return getScheduler()->mNumCoroutines;
+    }
+
+  private:
+    /** Size of the arrays, rounded up to a multiple of the 4-wide scan. */
+    static const uint16_t kCapacity = (N + 3) & ~3;
+
+    /**
+     * Offset of the wake-up time of a parked coroutine. A parked coroutine
+     * comes up in the scan every 12 days, when its wake-up time is pushed
+     * forward again.
+     */
+    static const uint32_t kParkMillis = 0x40000000;
+
+    // Disable copy-constructor and assignment operator
+    CoroutineRegistrySchedulerTemplate(
+        const CoroutineRegistrySchedulerTemplate&) = delete;
+    CoroutineRegistrySchedulerTemplate& operator=(
+        const CoroutineRegistrySchedulerTemplate&) = delete;
+
+    /** Return the singleton CoroutineRegistryScheduler. */
+    static CoroutineRegistrySchedulerTemplate* getScheduler() {
+      static CoroutineRegistrySchedulerTemplate singletonScheduler;
+      return &singletonScheduler;
+    }
+
+    /** Constructor. */
+    CoroutineRegistrySchedulerTemplate() = default;
+
+    /** Copy the linked list into the registry. */
+    void setupScheduler() {
+      T_COROUTINE::coroutineClockSnapshot();
+      mNow = T_COROUTINE::coroutineMillis();
+      mNumCoroutines = 0;
+      for (T_COROUTINE** p = T_COROUTINE::getRoot();
+          (*p) != nullptr && mNumCoroutines < N;
+          p = (*p)->getNext()) {
+        mCoroutines[mNumCoroutines] = *p;
+        mWakeMillis[mNumCoroutines] = mNow;
+        mParked[mNumCoroutines] = false;
+        mNumCoroutines++;
+      }
+      // The padding at the end of the last group of 4 is never due.
+      for (uint16_t i = mNumCoroutines; i < kCapacity; i++) {
+        mWakeMillis[i] = mNow + kParkMillis;
+        mParked[i] = true;
+      }
+      mCurrent = 0;
+    }
+
+    /** Run the next coroutine which is due. */
+    void runCoroutine() {
+      // If reached the end, start a new pass from the beginning.
+      if (mCurrent >= mNumCoroutines) {
+        if (mNumCoroutines == 0) return;
+        T_COROUTINE::coroutineClockSnapshot();
+        mNow = T_COROUTINE::coroutineMillis();
+        mCurrent = 0;
+      }
+
+      // Find the next due coroutine, starting with the group of 4 which
+      // contains mCurrent.
+      uint16_t group = mCurrent & ~3;
+      uint8_t mask = dueMask(&mWakeMillis[group], mNow)
+          & (0xF << (mCurrent & 3));
+      while (mask == 0) {
+        group += 4;
+        if (group >= mNumCoroutines) {
+          mCurrent = mNumCoroutines;
+          return;
+        }
+        mask = dueMask(&mWakeMillis[group], mNow);
+      }
+      uint16_t i = group;
+      while ((mask & 1) == 0) {
+        mask >>= 1;
+        i++;
+      }
+      mCurrent = i + 1;
+
+      if (mParked[i]) {
+        // Includes the padding after the last coroutine.
+        mWakeMillis[i] = mNow + kParkMillis;
+        return;
+      }
+
+      T_COROUTINE* current = mCoroutines[i];
+      switch (current->getStatus()) {
+        case T_COROUTINE::kStatusYielding:
+        case T_COROUTINE::kStatusDelaying:
+        case T_COROUTINE::kStatusWaiting:
+          current->runCoroutine();
+          break;
+
+        case T_COROUTINE::kStatusEnding:
+          current->setTerminated();
+          break;
+
+        default:
+          break;
+      }
+      updateEntry(i, current);
+    }
+
+    /** Update the hot state of entry i from the status of its coroutine. */
+    void updateEntry(uint16_t i, T_COROUTINE* coroutine) {
+      switch (coroutine->getStatus()) {
+        case T_COROUTINE::kStatusDelaying: {
+          uint32_t remaining = coroutine->getDelayRemainingMicros() / 1000;
+          if (remaining > kParkMillis) remaining = kParkMillis;
+          mWakeMillis[i] = mNow + remaining;
+          break;
+        }
+
+        case T_COROUTINE::kStatusSuspended:
+        case T_COROUTINE::kStatusTerminated:
+          mParked[i] = true;
+          mWakeMillis[i] = mNow + kParkMillis;
+          break;
+
+        default:
+          // Yielding, Waiting or Ending: due on the next pass.
+          mWakeMillis[i] = mNow;
+          break;
+      }
+    }
+
+    /** Put the resumed or reset coroutines back into the rotation. */
+    void refreshParked() {
+      for (uint16_t i = 0; i < mNumCoroutines; i++) {
+        if (mParked[i] && mCoroutines[i]->getStatus()
+            == T_COROUTINE::kStatusYielding) {
+          mParked[i] = false;
+          mWakeMillis[i] = mNow;
+        }
+      }
+    }
+
+    /**
+     * Return a 4-bit mask of the entries of wake[0..3] which are due at 'now',
+     * i.e. whose signed difference from 'now' is not positive, so that the
+     * rollover of the millis clock is handled.
+     */
+    static uint8_t dueMask(const uint32_t* wake, uint32_t now) {
+    #if defined(__SSE2__)
+      __m128i diff = _mm_sub_epi32(
+          _mm_loadu_si128((const __m128i*) wake), _mm_set1_epi32(now));
+      __m128i notDue = _mm_cmpgt_epi32(diff, _mm_setzero_si128());
+      return ~_mm_movemask_ps(_mm_castsi128_ps(notDue)) & 0xF;
+    #elif defined(__ARM_NEON)
+      int32x4_t diff = vreinterpretq_s32_u32(
+          vsubq_u32(vld1q_u32(wake), vdupq_n_u32(now)));
+      uint32x4_t due = vshrq_n_u32(vcleq_s32(diff, vdupq_n_s32(0)), 31);
+      return vgetq_lane_u32(due, 0)
+          | (vgetq_lane_u32(due, 1) << 1)
+          | (vgetq_lane_u32(due, 2) << 2)
+          | (vgetq_lane_u32(due, 3) << 3);
+    #else
+      uint8_t mask = 0;
+      for (uint8_t k = 0; k < 4; k++) {
+        if ((int32_t) (wake[k] - now) <= 0) mask |= (1 << k);
+      }
+      return mask;
+    #endif
+    }
+
+    /** Millis clock at the start of the current pass. */
+    uint32_t mNow = 0;
+
+    /** Index of the next entry to examine. */
+    uint16_t mCurrent = 0;
+
+    /** Number of coroutines in the registry. */
+    uint16_t mNumCoroutines = 0;
+
+    /** Wake-up time of each coroutine, in millis. Hot. */
+    uint32_t mWakeMillis[kCapacity];
+
+    /** True if the coroutine is suspended or terminated. */
+    bool mParked[kCapacity];
+
+    /** The coroutines, in the order of the linked list. Cold. */
+    T_COROUTINE* mCoroutines[kCapacity];
+};
+
+}
+
+#endif
@@ -28,12 +28,18 @@ SOFTWARE.
 #if ACE_ROUTINE_DEBUG == 1
   #include <Arduino.h> // Serial, Print
 #endif
+#if defined(EPOXY_DUINO)
+  #include <time.h> // nanosleep()
+#endif
 #include "Coroutine.h"
+#include "WaitQueue.h"
 
 class Print;
 
 namespace ace_routine {
 
+template <typename T> class CoroutinePartitionTemplate;
+
 /**
  * Class that manages instances of the `Coroutine` class, and executes them
  * in a round-robin fashion. This is expected to be used as a singleton.
@@ -76,9 +82,16 @@ namespace ace_routine {
  * remove this extra layer of indirection. Fortunately, the none of these
  * methods are virtual, so the extra level of indirection consumes very little
  * overhead, even on 8-bit AVR processors.
+ *
+ * The instance methods now run the linked list given by `mRoot`, so that a
+ * `CoroutinePartition` can contain its own instance of this class to run a
+ * separate linked list of coroutines. The singleton runs the global linked
+ * list given by `T_COROUTINE::getRoot()`.
  */
 template <typename T_COROUTINE>
 class CoroutineSchedulerTemplate {
+  friend class CoroutinePartitionTemplate<T_COROUTINE>;
+
   public:
     /** Set up the scheduler. Should be called from the global setup(). */
     static void setup() { getScheduler()->setupScheduler(); }
@@ -96,6 +109,172 @@ class CoroutineSchedulerTemplate {
      */
     static void loop() { getScheduler()->runCoroutine(); }
 
+    /**
+     * Run coroutines one after another until budgetMicros has elapsed, then
+     * return. At least one coroutine is run. Calling this from the global
+     * loop() amortizes the overhead of the Arduino loop() and yield() (e.g.
+     * WiFi processing on the ESP8266 and ESP32) over many coroutines, at the
+     * cost of one call to micros() per coroutine. The budget can be exceeded
+     * by the running time of the last coroutine.
+     */
+    static void loopFor(uint32_t budgetMicros) {
+      getScheduler()->runCoroutinesFor(budgetMicros);
+    }
+
+    /**
+     * Run the coroutines from the current position to the end of the linked
+     * list. If the previous call to loop() finished a pass, this runs every
+     * coroutine exactly once.
+     */
+    static void runOnePass() { getScheduler()->runCoroutinesToEnd(); }
+
+    /**
+     * Run coroutines until every coroutine is idle, i.e. all of them are
+     * delaying, suspended, terminated or parked on a WaitQueue (see
+     * nextWakeupMicros()), or until maxRuns coroutines have been run. Idleness
+     * is checked at the start of each pass through the linked list. Since
+     * coroutines in COROUTINE_YIELD() or COROUTINE_AWAIT() are never idle,
+     * maxRuns bounds the time spent in this method.
+     *
+     * @return the number of coroutines which were run
+     */
+    static uint16_t runUntilIdle(uint16_t maxRuns) {
+      return getScheduler()->runCoroutinesUntilIdle(maxRuns);
+    }
+
+    /**
+     * Value returned by nextWakeupMicros() when no coroutine in the scheduler
+     * will become ready by itself, because all of them are suspended,
+     * terminated, or parked on a WaitQueue.
+     */
+    static const uint32_t kNoWakeup = 0xFFFFFFFF;
+
+    /** Default upper limit of a single sleep in loopOrSleep(). */
+    static const uint32_t kMaxSleepMicros = 1000000;
+
+    /**
+     * A function which puts the processor to sleep for at most the given
+     * number of microseconds. It may return early, for example when an
+     * interrupt occurs.
+     */
+    typedef void (*SleepHook)(uint32_t micros);
+
+    /**
+     * Return the number of microseconds until the next coroutine becomes
+     * ready to run. Returns 0 if a coroutine is ready now (i.e. Yielding,
+     * Ending, or Delaying with an expired delay), the time until the earliest
+     * delay expires if all the ready coroutines are in COROUTINE_DELAY(),
+     * COROUTINE_DELAY_MICROS() or COROUTINE_DELAY_SECONDS(), or kNoWakeup if
+     * no coroutine will become ready by itself.
+     *
+     * This walks the entire linked list, so it is relatively expensive.
+     * Coroutines waiting in COROUTINE_AWAIT() are Yielding, so they prevent
+     * the scheduler from sleeping.
+     */
+    static uint32_t nextWakeupMicros() {
+      return getScheduler()->nextWakeupMicrosInternal();
+    }
+
+    /**
+     * Same as loop(), except that at the start of each pass through the
+     * linked list, the processor is put to sleep until the next coroutine
+     * becomes ready, using the sleep hook (see setSleepHook()). The sleep is
+     * limited to maxSleepMicros, so that the global loop() can continue to
+     * poll other things, such as a WaitQueue::notify() triggered from outside
+     * of the coroutines. Behaves like loop() if there is no sleep hook.
+     */
+    static void loopOrSleep(uint32_t maxSleepMicros = kMaxSleepMicros) {
+      getScheduler()->runCoroutineOrSleep(maxSleepMicros);
+    }
+
+    /**
+     * Set the function used by loopOrSleep() to sleep. Set to nullptr to
+     * disable sleeping. The default is nanosleep() on EpoxyDuino, and nullptr
+     * on microcontrollers, where the appropriate sleep mode depends on the
+     * board and the peripherals in use.
+     */
+    static void setSleepHook(SleepHook hook) {
+      getScheduler()->mSleepHook = hook;
+    }
+
+    /** Default guard window of COROUTINE_DELAY_MICROS_PRECISE(). */
+    static const uint16_t kDefaultSpinGuardMicros = 100;
+
+    /**
+     * Set the guard window of COROUTINE_DELAY_MICROS_PRECISE(). When the
+     * scheduler reaches a coroutine whose precise delay expires within
+     * guardMicros, it busy-waits until the delay expires, then resumes the
+     * coroutine. The window should be a little longer than one pass through
+     * the linked list, so that the scheduler does not reach the coroutine for
+     * the first time after its delay has already expired. A window of 0 turns
+     * off spinning.
+     */
+    static void setSpinGuardMicros(uint16_t guardMicros) {
+      getScheduler()->mSpinGuardMicros = guardMicros;
+    }
+
+    /**
+     * Return how late, in micros, the most recent
+     * COROUTINE_DELAY_MICROS_PRECISE() was resumed by the scheduler, i.e.
+     * the time from the end of the delay until the coroutine was resumed.
+     */
+    static uint32_t getLatenessMicros() {
+      return getScheduler()->mLatenessMicros;
+    }
+
+    /**
+     * Return the largest getLatenessMicros() since setup() or
+     * clearLateness().
+     */
+    static uint32_t getMaxLatenessMicros() {
+      return getScheduler()->mMaxLatenessMicros;
+    }
+
+    /** Reset getLatenessMicros() and getMaxLatenessMicros() to 0. */
+    static void clearLateness() {
+      getScheduler()->mLatenessMicros = 0;
+      getScheduler()->mMaxLatenessMicros = 0;
+    }
+
+    /**
+     * A producer/consumer dependency between two coroutines, for example a
+     * coroutine which writes into a Channel and the coroutine which reads
+     * from it.
+     */
+    struct Dependency {
+      T_COROUTINE* producer;
+      T_COROUTINE* consumer;
+    };
+
+    /** Largest rank. Also the longest chain of dependencies, plus one. */
+    static const uint8_t kMaxRank = 0xFF;
+
+    /**
+     * Dispatch the coroutines in the topological order of the given
+     * dependencies, so that a value passed along a chain of coroutines reaches
+     * the end of the chain in a single pass, instead of up to one pass per
+     * stage. Can be called before or after setup().
+     *
+     * Each coroutine named in the dependencies is given a rank (see
+     * Coroutine::getRank()) one higher than the highest rank of its
+     * producers. The linked list is sorted by rank, keeping the existing order
+     * within a rank. Afterwards, resume(), reset() and WaitQueue::notify()
+     * insert a ranked coroutine after the coroutines of the same or lower
+     * rank, instead of at the root. Coroutines which are not named in the
+     * dependencies have rank 0 and run first, as before.
+     *
+     * Requires ACE_ROUTINE_DEPENDENCIES to be defined to 1 before the first
+     * `#include <AceRoutine.h>`, which adds the rank to each Coroutine.
+     *
+     * @return false if the dependencies contain a cycle, or a chain longer
+     *    than kMaxRank, in which case all ranks are cleared and the order of
+     *    the linked list is unchanged
+     */
+    static bool setDependencies(
+        const Dependency* dependencies, uint8_t numDependencies) {
+      return getScheduler()->sortDependencies(dependencies, numDependencies);
+    }
+
     /**
      * Print out the known coroutines to the printer (usually Serial). Note that
      * if this method is never called, the linker will strip out the code. If
@@ -118,9 +297,18 @@ class CoroutineSchedulerTemplate {
       return &singletonScheduler;
     }
 
-    /** Constructor. */
+    /** Constructor of the singleton, which runs the global linked list. */
     CoroutineSchedulerTemplate() = default;
 
+    /**
+     * Constructor of the scheduler of a CoroutinePartition, which runs the
+     * linked list given by root.
+     */
+    explicit CoroutineSchedulerTemplate(T_COROUTINE** root) :
+        mRoot(root),
+        mCurrent(root)
+    {}
+
     /**
      * Set up the Scheduler.
      *
@@ -130,14 +318,25 @@ class CoroutineSchedulerTemplate {
      * onwards, we keep all coroutines in the linked list no matter the state,
      * which makes the state management and linked-list management a lot
      * simpler.
+     *
+     * Suspended and terminated coroutines are now moved out of the linked list
+     * by runCoroutine(), when the scheduler reaches them, into separate
+     * doubly-linked lists. The resume() and reset() methods move them back to
+     * the root of the linked list in O(1) time, or after the coroutines of
+     * lower rank if setDependencies() was used. A suspend() followed by a
+     * resume() before the scheduler reaches the coroutine only changes its
+     * status, so the cycle cannot happen.
      */
     void setupScheduler() {
-      mCurrent = T_COROUTINE::getRoot();
+      mCurrent = mRoot;
+      mLatenessMicros = 0;
+      mMaxLatenessMicros = 0;
+      T_COROUTINE::coroutineClockSnapshot();
     }
 
     /** Setup each coroutine by calling its setupCoroutine() function. */
     void setupCoroutinesInternal() {
-      for (T_COROUTINE** p = T_COROUTINE::getRoot();
+      for (T_COROUTINE** p = mRoot;
           (*p) != nullptr;
           p = (*p)->getNext()) {
 
@@ -145,17 +344,176 @@ class CoroutineSchedulerTemplate {
       }
     }
 
+    /** Assign the ranks of the dependencies, then sort the linked list. */
+    bool sortDependencies(
+        const Dependency* dependencies, uint8_t numDependencies) {
+      static_assert(ACE_ROUTINE_DEPENDENCIES || sizeof(T_COROUTINE) == 0,
+          "setDependencies() requires ACE_ROUTINE_DEPENDENCIES=1");
+      if (! rankDependencies(dependencies, numDependencies)) {
+        clearRanks(dependencies, numDependencies);
+        return false;
+      }
+
+      // Stable insertion sort of the linked list by rank. Only done at setup,
+      // so O(N^2) is good enough. Appending to the end is the common case,
+      // since most of the coroutines have rank 0.
+      T_COROUTINE** root = mRoot;
+      T_COROUTINE* unsorted = *root;
+      T_COROUTINE* last = nullptr;
+      *root = nullptr;
+      while (unsorted != nullptr) {
+        T_COROUTINE* coroutine = unsorted;
+        unsorted = coroutine->mNext;
+        if (last == nullptr || coroutine->mRank >= last->mRank) {
+          coroutine->mNext = nullptr;
+          *(last == nullptr ? root : last->getNext()) = coroutine;
+          last = coroutine;
+        } else {
+          // Terminates at 'last', whose rank is higher.
+          T_COROUTINE** p = root;
+          while ((*p)->mRank <= coroutine->mRank) p = (*p)->getNext();
+          coroutine->mNext = *p;
+          *p = coroutine;
+        }
+      }
+
+      mCurrent = mRoot;
+      return true;
+    }
+
+    /**
+     * Assign the rank of each coroutine in the dependencies, by relaxing
+     * every dependency until none of them changes a rank. A cycle keeps
+     * increasing the ranks until kMaxRank is reached.
+     */
+    static bool rankDependencies(
+        const Dependency* dependencies, uint8_t numDependencies) {
+      clearRanks(dependencies, numDependencies);
+      bool changed = true;
+      while (changed) {
+        changed = false;
+        for (uint8_t i = 0; i < numDependencies; i++) {
+          uint8_t producerRank = dependencies[i].producer->mRank;
+          T_COROUTINE* consumer = dependencies[i].consumer;
+          if (consumer->mRank > producerRank) continue;
+          if (producerRank == kMaxRank) return false;
+          consumer->mRank = producerRank + 1;
+          changed = true;
+        }
+      }
+      return true;
+    }
+
+    /** Reset the rank of each coroutine in the dependencies to 0. */
+    static void clearRanks(
+        const Dependency* dependencies, uint8_t numDependencies) {
+      for (uint8_t i = 0; i < numDependencies; i++) {
+        dependencies[i].producer->mRank = 0;
+        dependencies[i].consumer->mRank = 0;
+      }
+    }
+
+    /** Return the time until the next coroutine becomes ready. */
+    uint32_t nextWakeupMicrosInternal() {
+      T_COROUTINE::coroutineClockSnapshot();
+      uint32_t wakeup = kNoWakeup;
+      for (T_COROUTINE** p = mRoot;
+          (*p) != nullptr;
+          p = (*p)->getNext()) {
+
+        switch ((*p)->getStatus()) {
+          case T_COROUTINE::kStatusYielding:
+          case T_COROUTINE::kStatusRunning:
+          case T_COROUTINE::kStatusEnding:
+            return 0;
+
+          case T_COROUTINE::kStatusDelaying: {
+            uint32_t remaining = (*p)->getDelayRemainingMicros();
+            // Wake up in time to spin through the guard window.
+            if ((*p)->getDelayType() == T_COROUTINE::kDelayTypeMicrosPrecise) {
+              remaining = (remaining > mSpinGuardMicros)
+                  ? remaining - mSpinGuardMicros : 0;
+            }
+            if (remaining == 0) return 0;
+            if (remaining < wakeup) wakeup = remaining;
+            break;
+          }
+
+          default:
+            break;
+        }
+      }
+      return wakeup;
+    }
+
+    /** Run coroutines until budgetMicros has elapsed. */
+    void runCoroutinesFor(uint32_t budgetMicros) {
+      // The micros() read for the budget doubles as the clock snapshot of the
+      // next coroutine.
+      T_COROUTINE::coroutineClockSnapshot();
+      uint32_t start = T_COROUTINE::coroutineMicros();
+      do {
+        runCoroutine();
+        T_COROUTINE::coroutineClockSnapshot();
+      } while ((uint32_t) (T_COROUTINE::coroutineMicros() - start)
+          < budgetMicros);
+    }
+
+    /** Run coroutines until the end of the linked list is reached. */
+    void runCoroutinesToEnd() {
+      do {
+        runCoroutine();
+      } while (*mCurrent != nullptr);
+    }
+
+    /** Run coroutines until all of them are idle, or maxRuns is reached. */
+    uint16_t runCoroutinesUntilIdle(uint16_t maxRuns) {
+      uint16_t runs = 0;
+      while (runs < maxRuns) {
+        if (*mCurrent == nullptr && nextWakeupMicrosInternal() != 0) break;
+        runCoroutine();
+        runs++;
+      }
+      return runs;
+    }
+
+    /**
+     * Sleep until the next coroutine is ready if at the start of a pass, then
+     * run the current coroutine. Checking only once per pass keeps the cost
+     * of the walk through the linked list to about the same as one pass of
+     * loop().
+     */
+    void runCoroutineOrSleep(uint32_t maxSleepMicros) {
+      if (*mCurrent == nullptr && mSleepHook != nullptr) {
+        uint32_t sleepMicros = nextWakeupMicrosInternal();
+        if (sleepMicros > maxSleepMicros) sleepMicros = maxSleepMicros;
+        if (sleepMicros > 0) mSleepHook(sleepMicros);
+      }
+      runCoroutine();
+    }
+
+  #if defined(EPOXY_DUINO)
+    /** Sleep hook for EpoxyDuino, which releases the CPU to the host OS. */
+    static void sleepNative(uint32_t micros) {
+      struct timespec ts;
+      ts.tv_sec = micros / 1000000;
+      ts.tv_nsec = (long) (micros % 1000000) * 1000;
+      nanosleep(&ts, nullptr);
+    }
+  #endif
+
     /** Run the current coroutine. */
     void runCoroutine() {
       // If reached the end, start from the beginning again.
       if (*mCurrent == nullptr) {
-        mCurrent = T_COROUTINE::getRoot();
+        mCurrent = mRoot;
         // Return if the list is empty. Checking for a null getRoot() inside the
         // if-statement is deliberate, since it optimizes the common case where
         // the linked list is not empty.
         if (*mCurrent == nullptr) {
           return;
         }
+        T_COROUTINE::coroutineClockSnapshot();
       }
 
     #if ACE_ROUTINE_DEBUG == 1
@@ -165,35 +523,125 @@ class CoroutineSchedulerTemplate {
     #endif
 
       // Handle the coroutine's dispatch back to the last known internal status.
-      switch ((*mCurrent)->getStatus()) {
+      T_COROUTINE* current = *mCurrent;
+      switch (current->getStatus()) {
         case T_COROUTINE::kStatusYielding:
+        #if ACE_ROUTINE_AWAIT_PREDICATE
+          // A coroutine blocked in COROUTINE_AWAIT_PREDICATE() is resumed only
+          // after its predicate returns true.
+          if (! current->checkAwaitPredicate()) break;
+        #endif
+          current->runCoroutine();
+          break;
+
         case T_COROUTINE::kStatusDelaying:
+          if (current->getDelayType() == T_COROUTINE::kDelayTypeMicrosPrecise) {
+            spinDelayMicros(current);
+          }
+          // fall through
+
+        case T_COROUTINE::kStatusWaiting:
           // The coroutine itself knows whether it is yielding or delaying, and
           // its continuation context determines whether to call
           // Coroutine::isDelayExpired(), Coroutine::isDelayMicrosExpired(), or
-          // Coroutine::isDelaySecondsExpired().
-          (*mCurrent)->runCoroutine();
+          // Coroutine::isDelaySecondsExpired(). A Waiting coroutine is
+          // normally parked on its WaitQueue, but one which was run directly
+          // is still in the list, so re-evaluate its condition.
+          current->runCoroutine();
           break;
 
         case T_COROUTINE::kStatusEnding:
-          // mark it terminated
-          (*mCurrent)->setTerminated();
-          break;
+          // mark it terminated, and move it out of the linked list
+          current->setTerminated();
+          unlinkCurrent(current);
+          current->insertInactive(T_COROUTINE::getTerminatedRoot());
+          current->recycleCoroutine();
+          return;
+
+        case T_COROUTINE::kStatusTerminated:
+          unlinkCurrent(current);
+          current->insertInactive(T_COROUTINE::getTerminatedRoot());
+          return;
+
+        case T_COROUTINE::kStatusSuspended:
+          // Not visited again until resume() or reset() is called.
+          unlinkCurrent(current);
+          current->insertInactive(T_COROUTINE::getSuspendedRoot());
+          return;
 
         default:
           // For all other cases, just skip to the next coroutine.
           break;
       }
 
-      // Go to the next coroutine
-      mCurrent = (*mCurrent)->getNext();
+      // Park a coroutine which is waiting in COROUTINE_AWAIT_ON(), otherwise
+      // go to the next coroutine. Use 'current' instead of '*mCurrent' because
+      // WaitQueue::notify() may have inserted coroutines at the root.
+      if (current->getStatus() == T_COROUTINE::kStatusWaiting) {
+        parkCoroutine(current);
+      } else {
+        mCurrent = current->getNext();
+      }
     }
 
+    /**
+     * If the COROUTINE_DELAY_MICROS_PRECISE() of the current coroutine
+     * expires within the guard window, busy-wait until it expires, then
+     * record how late the coroutine is resumed. The clock is re-read on each
+     * iteration, bypassing the snapshot of the pass.
+     */
+    void spinDelayMicros(T_COROUTINE* current) {
+      T_COROUTINE::coroutineClockSnapshot();
+      if (current->getDelayRemainingMicros() > mSpinGuardMicros) return;
+      while (! current->isDelayMicrosExpired()) {
+        T_COROUTINE::coroutineClockSnapshot();
+      }
 
-    /** List all the routines in the linked list to the printer. */
+      typename T_COROUTINE::DelayValue lateness =
+          T_COROUTINE::coroutineMicros() - current->getDelayDeadline();
+      mLatenessMicros = lateness;
+      if (mLatenessMicros > mMaxLatenessMicros) {
+        mMaxLatenessMicros = mLatenessMicros;
+      }
+    }
+
+    /**
+     * Move the current coroutine from the linked list to the WaitQueue given
+     * to its COROUTINE_AWAIT_ON().
+     */
+    void parkCoroutine(T_COROUTINE* current) {
+      unlinkCurrent(current);
+      (*T_COROUTINE::getParkingQueue())->park(current);
+    }
+
+    /**
+     * Remove the current coroutine from the linked list. The mCurrent pointer
+     * does not advance, because it now points to the coroutine which followed
+     * the removed one.
+     */
+    void unlinkCurrent(T_COROUTINE* current) {
+      // Skip over any coroutines inserted at the root by
+      // WaitQueue::notify() while the current coroutine was running.
+      while (*mCurrent != current) {
+        mCurrent = (*mCurrent)->getNext();
+      }
+      *mCurrent = current->mNext;
+    }
+
+
+    /**
+     * List all the routines in the linked list to the printer, followed by
+     * the suspended and terminated coroutines which were moved out of it.
+     */
     void listCoroutines(Print& printer) {
-      for (T_COROUTINE** p = T_COROUTINE::getRoot(); (*p) != nullptr;
-          p = (*p)->getNext()) {
+      listCoroutines(printer, mRoot);
+      listCoroutines(printer, T_COROUTINE::getSuspendedRoot());
+      listCoroutines(printer, T_COROUTINE::getTerminatedRoot());
+    }
+
+    /** List the routines in the list starting at root. */
+    void listCoroutines(Print& printer, T_COROUTINE** root) {
+      for (T_COROUTINE** p = root; (*p) != nullptr; p = (*p)->getNext()) {
         printer.print(F("Coroutine "));
         printer.print((uintptr_t) *p);
         printer.print(':');
@@ -206,10 +654,27 @@ class CoroutineSchedulerTemplate {
       }
     }
 
+    // The root of the linked list of coroutines run by this scheduler.
+    T_COROUTINE** const mRoot = T_COROUTINE::getRoot();
+
     // The current coroutine is represented by a pointer to a pointer. This
     // allows the root node to be treated the same as all the other nodes, and
     // simplifies the code that traverses the singly-linked list.
     T_COROUTINE** mCurrent = nullptr;
+
+    // Function used by loopOrSleep() to sleep, or nullptr to never sleep.
+  #if defined(EPOXY_DUINO)
+    SleepHook mSleepHook = sleepNative;
+  #else
+    SleepHook mSleepHook = nullptr;
+  #endif
+
+    // Guard window of COROUTINE_DELAY_MICROS_PRECISE().
+    uint16_t mSpinGuardMicros = kDefaultSpinGuardMicros;
+
+    // Most recent and largest lateness of COROUTINE_DELAY_MICROS_PRECISE().
+    uint32_t mLatenessMicros = 0;
+    uint32_t mMaxLatenessMicros = 0;
 };
 
 using CoroutineScheduler = CoroutineSchedulerTemplate<Coroutine>;
@@ -0,0 +1,466 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_WORK_STEALING_SCHEDULER_H
+#define ACE_ROUTINE_COROUTINE_WORK_STEALING_SCHEDULER_H
+
+/**
+ * @file CoroutineWorkStealingScheduler.h
+ *
+ * A multi-threaded scheduler, available only on EpoxyDuino (Linux, MacOS) and
+ * the dual-core ESP32, where std::thread is supported. This header is not
+ * included by <AceRoutine.h>, so that single-threaded programs do not pull in
+ * <thread> and <mutex>. It must be included explicitly:
+ *
+ * @code
+ * #include <AceRoutine.h>
+ * #include <ace_routine/CoroutineWorkStealingScheduler.h>
+ * @endcode
+ */
+
+#if defined(EPOXY_DUINO) || defined(ESP32)
+
+#include <stdint.h> // uint8_t
+#include <atomic>
+#include <mutex>
+#include <thread>
+#if defined(ESP32)
+  #include <esp_pthread.h> // esp_pthread_set_cfg()
+#endif
+#include "Coroutine.h"
+
+class Print;
+
+namespace ace_routine {
+
+/**
+ * A scheduler which runs coroutines on up to N_MAX_WORKERS threads. Each
+ * worker thread owns a run queue of coroutines, implemented as an intrusive
+ * FIFO through `Coroutine::mNext` and protected by a mutex. A worker runs each
+ * coroutine in its queue once per pass, in round-robin order. When its queue
+ * becomes empty (e.g. because all of its coroutines have terminated), the
+ * worker steals a coroutine from the front of the queue of one of its peers.
+ *
+ * A coroutine can be pinned to a worker using pin(), for example to keep
+ * coroutines which share data on the same thread, or to keep a coroutine on a
+ * given core of the ESP32. Pinned coroutines are kept in a separate list
+ * which is only accessed by its worker thread, so they are never stolen.
+ *
+ * Usage:
+ *
+ * @code
+ * CoroutineWorkStealingScheduler::pin(&uiCoroutine, 0); // optional
+ * CoroutineWorkStealingScheduler::setup(2);
+ * CoroutineWorkStealingScheduler::start();
+ * ...
+ * CoroutineWorkStealingScheduler::stop();
+ * @endcode
+ *
+ * Restrictions:
+ *
+ * * Coroutines running on different workers run in parallel. Any data shared
+ *   between them, including a Channel, must be protected by the application,
+ *   or the coroutines must be pinned to the same worker.
+ * * COROUTINE_AWAIT_ON() does not park the coroutine. It behaves like
+ *   COROUTINE_AWAIT(), because WaitQueue::notify() is not thread-safe.
+ *   setWaiting() leaves the coroutine in the Yielding state while the workers
+ *   are running, so workers do not race on the parking queue.
+ * * suspend(), resume() and reset() must be called only while the workers
+ *   are stopped, or from a coroutine pinned to the same worker.
+ * * Coroutines in COROUTINE_DELAY() are polled, like the CoroutineScheduler.
+ * * Terminated coroutines are moved to a separate list of their worker, and
+ *   are returned to the global list by the next setup(). Pinned coroutines
+ *   stay in the pinned list.
+ *
+ * Each thread of the ESP32 is pinned to core (worker % portNUM_PROCESSORS),
+ * so pinning a coroutine to worker 0 or 1 pins it to that core.
+ *
+ * The single-threaded CoroutineScheduler is not affected by this class. The
+ * only additions to Coroutine are a friend declaration and the flag which
+ * disables parking while the workers are running.
+ *
+ * @tparam T_COROUTINE class of the coroutine, usually `Coroutine`
+ * @tparam N_MAX_WORKERS maximum number of worker threads
+ */
+template <typename T_COROUTINE, uint8_t N_MAX_WORKERS>
+class CoroutineWorkStealingSchedulerTemplate {
+  public:
+    /**
+     * Pin the coroutine to the given worker, before setup() is called. The
+     * coroutine is moved from the global linked list into the pinned list of
+     * the worker, and stays there across subsequent calls to setup(). The
+     * worker is clamped to N_MAX_WORKERS - 1.
+     */
+    static void pin(T_COROUTINE* coroutine, uint8_t worker) {
+      getScheduler()->pinCoroutine(coroutine, worker);
+    }
+
+    /**
+     * Distribute the coroutines in the global linked list round-robin over
+     * numWorkers run queues. Terminated coroutines and the coroutines left in
+     * the run queues by a previous setup() are collected first, so setup()
+     * can be called again, after stop() and reset() of the coroutines, to run
+     * the same coroutines with a different number of workers. The numWorkers
+     * is clamped to [1, N_MAX_WORKERS].
+     */
+    static void setup(uint8_t numWorkers) {
+      getScheduler()->setupScheduler(numWorkers);
+    }
+
+    /** Set up the coroutines by calling their setupCoroutine() methods. */
+    static void setupCoroutines() {
+      getScheduler()->setupCoroutinesInternal();
+    }
+
+    /** Start the worker threads. */
+    static void start() { getScheduler()->startWorkers(); }
+
+    /** Ask the worker threads to stop, and wait for them to finish. */
+    static void stop() { getScheduler()->stopWorkers(); }
+
+    /**
+     * Return the number of coroutines which are not yet terminated. Becomes
+     * 0 when every coroutine has run through COROUTINE_END().
+     */
+    static uint32_t getNumActive() {
+      return getScheduler()->mNumActive.load();
+    }
+
+    /**
+     * Return the index of the worker running the current thread, or -1 if
+     * called from a thread which is not a worker.
+     */
+    static int8_t currentWorker() { return *getCurrentWorker(); }
+
+    /**
+     * Print out the known coroutines to the printer (usually Serial). Should be
+     * called only while the workers are stopped.
+     */
+    static void list(Print& printer) {
+      getScheduler()->listCoroutines(printer);
+    }
+
+  private:
+    /** State owned by each worker thread. */
+    struct Worker {
+      /** Protects the run queue (mHead, mTail, mSize). */
+      std::mutex mMutex;
+
+      /** Front of the run queue. Popped by the worker and by thieves. */
+      T_COROUTINE* mHead = nullptr;
+
+      /** Back of the run queue. */
+      T_COROUTINE* mTail = nullptr;
+
+      /** Number of coroutines in the run queue. */
+      uint32_t mSize = 0;
+
+      /** Coroutines pinned to this worker. Accessed only by its thread. */
+      T_COROUTINE* mPinned = nullptr;
+
+      /** Terminated coroutines. Accessed only by its thread. */
+      T_COROUTINE* mDone = nullptr;
+
+      /** The thread running this worker. */
+      std::thread mThread;
+    };
+
+    // Disable copy-constructor and assignment operator
+    CoroutineWorkStealingSchedulerTemplate(
+        const CoroutineWorkStealingSchedulerTemplate&) = delete;
+    CoroutineWorkStealingSchedulerTemplate& operator=(
+        const CoroutineWorkStealingSchedulerTemplate&) = delete;
+
+    /** Return the singleton CoroutineWorkStealingScheduler. */
+    static CoroutineWorkStealingSchedulerTemplate* getScheduler() {
+      static CoroutineWorkStealingSchedulerTemplate singletonScheduler;
+      return &singletonScheduler;
+    }
+
+    /** Return the pointer to the index of the worker of the current thread. */
+    static int8_t* getCurrentWorker() {
+      static thread_local int8_t currentWorker = -1;
+      return &currentWorker;
+    }
+
+    /** Constructor. */
+    CoroutineWorkStealingSchedulerTemplate() = default;
+
+    /** Move the coroutine from the global list to the pinned list. */
+    void pinCoroutine(T_COROUTINE* coroutine, uint8_t worker) {
+      if (worker >= N_MAX_WORKERS) worker = N_MAX_WORKERS - 1;
+      for (T_COROUTINE** p = T_COROUTINE::getRoot(); (*p) != nullptr;
+          p = (*p)->getNext()) {
+        if (*p == coroutine) {
+          *p = coroutine->mNext;
+          coroutine->mNext = mWorkers[worker].mPinned;
+          mWorkers[worker].mPinned = coroutine;
+          return;
+        }
+      }
+    }
+
+    /** Set up the run queues. */
+    void setupScheduler(uint8_t numWorkers) {
+      if (numWorkers < 1) numWorkers = 1;
+      if (numWorkers > N_MAX_WORKERS) numWorkers = N_MAX_WORKERS;
+      mNumWorkers = numWorkers;
+
+      // Return the coroutines of the previous run to the global list.
+      T_COROUTINE** root = T_COROUTINE::getRoot();
+      for (uint8_t i = 0; i < N_MAX_WORKERS; i++) {
+        Worker& worker = mWorkers[i];
+        while (T_COROUTINE* coroutine = popFront(worker)) {
+          coroutine->mNext = *root;
+          *root = coroutine;
+        }
+        while (worker.mDone != nullptr) {
+          T_COROUTINE* coroutine = worker.mDone;
+          worker.mDone = coroutine->mNext;
+          coroutine->mNext = *root;
+          *root = coroutine;
+        }
+      }
+
+      // Distribute them round-robin, and count the active coroutines.
+      uint32_t numActive = 0;
+      uint8_t i = 0;
+      while (*root != nullptr) {
+        T_COROUTINE* coroutine = *root;
+        *root = coroutine->mNext;
+        pushBack(mWorkers[i], coroutine);
+        if (! coroutine->isTerminated()) numActive++;
+        if (++i >= mNumWorkers) i = 0;
+      }
+      for (uint8_t w = 0; w < N_MAX_WORKERS; w++) {
+        for (T_COROUTINE* p = mWorkers[w].mPinned; p != nullptr;
+            p = p->mNext) {
+          if (! p->isTerminated()) numActive++;
+        }
+      }
+      mNumActive.store(numActive);
+    }
+
+    /** Setup each coroutine by calling its setupCoroutine() function. */
+    void setupCoroutinesInternal() {
+      for (T_COROUTINE** p = T_COROUTINE::getRoot(); (*p) != nullptr;
+          p = (*p)->getNext()) {
+        (*p)->setupCoroutine();
+      }
+      for (uint8_t i = 0; i < N_MAX_WORKERS; i++) {
+        for (T_COROUTINE* p = mWorkers[i].mHead; p != nullptr; p = p->mNext) {
+          p->setupCoroutine();
+        }
+        for (T_COROUTINE* p = mWorkers[i].mPinned; p != nullptr;
+            p = p->mNext) {
+          p->setupCoroutine();
+        }
+      }
+    }
+
+    /** Start one thread per worker. */
+    void startWorkers() {
+      if (mRunning.load()) return;
+      mRunning.store(true);
+      *T_COROUTINE::getParkingDisabled() = true;
+      for (uint8_t i = 0; i < mNumWorkers; i++) {
+      #if defined(ESP32)
+        esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+        cfg.pin_to_core = i % portNUM_PROCESSORS;
+        esp_pthread_set_cfg(&cfg);
+      #endif
+        mWorkers[i].mThread = std::thread(runWorker, this, i);
+      }
+    }
+
+    /** Stop and join the worker threads. */
+    void stopWorkers() {
+      if (! mRunning.load()) return;
+      mRunning.store(false);
+      for (uint8_t i = 0; i < mNumWorkers; i++) {
+        if (mWorkers[i].mThread.joinable()) mWorkers[i].mThread.join();
+      }
+      *T_COROUTINE::getParkingDisabled() = false;
+    }
+
+    /** The body of each worker thread. */
+    static void runWorker(
+        CoroutineWorkStealingSchedulerTemplate* scheduler, uint8_t index) {
+      *getCurrentWorker() = index;
+      Worker& self = scheduler->mWorkers[index];
+
+      while (scheduler->mRunning.load(std::memory_order_relaxed)) {
+        // Run each pinned coroutine once. Terminated coroutines stay in the
+        // pinned list, so that they remain pinned after the next setup().
+        bool hasPinned = false;
+        for (T_COROUTINE* p = self.mPinned; p != nullptr; p = p->mNext) {
+          if (! p->isTerminated()) hasPinned = true;
+          scheduler->runOne(p);
+        }
+
+        // Run each coroutine in the run queue once. A coroutine popped from
+        // the queue is owned exclusively by this thread until it is pushed
+        // back.
+        uint32_t size;
+        {
+          std::lock_guard<std::mutex> lock(self.mMutex);
+          size = self.mSize;
+        }
+        for (uint32_t i = 0; i < size; i++) {
+          T_COROUTINE* coroutine = popFront(self);
+          if (coroutine == nullptr) break;
+          scheduler->runOne(coroutine);
+          if (coroutine->isTerminated()) {
+            coroutine->mNext = self.mDone;
+            self.mDone = coroutine;
+          } else {
+            pushBack(self, coroutine);
+          }
+        }
+
+        // Nothing left to do, so try to steal from the peers.
+        if (size == 0 && ! scheduler->steal(index) && ! hasPinned) {
+          std::this_thread::yield();
+        }
+      }
+
+      *getCurrentWorker() = -1;
+    }
+
+    /** Run a single coroutine, in the same way as CoroutineScheduler. */
+    void runOne(T_COROUTINE* coroutine) {
+      switch (coroutine->getStatus()) {
+        case T_COROUTINE::kStatusYielding:
+        case T_COROUTINE::kStatusDelaying:
+        case T_COROUTINE::kStatusWaiting:
+          coroutine->runCoroutine();
+          break;
+
+        case T_COROUTINE::kStatusEnding:
+          coroutine->setTerminated();
+          mNumActive.fetch_sub(1);
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    /**
+     * Steal one coroutine from the front of the queue of the first peer which
+     * has one, starting from the next worker. Return true if successful.
+     */
+    bool steal(uint8_t index) {
+      for (uint8_t k = 1; k < mNumWorkers; k++) {
+        uint8_t victim = (index + k) % mNumWorkers;
+        T_COROUTINE* coroutine = popFront(mWorkers[victim]);
+        if (coroutine != nullptr) {
+          pushBack(mWorkers[index], coroutine);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /** Remove the coroutine at the front of the run queue of the worker. */
+    static T_COROUTINE* popFront(Worker& worker) {
+      std::lock_guard<std::mutex> lock(worker.mMutex);
+      T_COROUTINE* coroutine = worker.mHead;
+      if (coroutine != nullptr) {
+        worker.mHead = coroutine->mNext;
+        if (worker.mHead == nullptr) worker.mTail = nullptr;
+        coroutine->mNext = nullptr;
+        worker.mSize--;
+      }
+      return coroutine;
+    }
+
+    /** Append the coroutine to the back of the run queue of the worker. */
+    static void pushBack(Worker& worker, T_COROUTINE* coroutine) {
+      std::lock_guard<std::mutex> lock(worker.mMutex);
+      coroutine->mNext = nullptr;
+      if (worker.mTail == nullptr) {
+        worker.mHead = coroutine;
+      } else {
+        worker.mTail->mNext = coroutine;
+      }
+      worker.mTail = coroutine;
+      worker.mSize++;
+    }
+
+    /** List the coroutines of each worker. */
+    void listCoroutines(Print& printer) {
+      for (uint8_t i = 0; i < N_MAX_WORKERS; i++) {
+        for (T_COROUTINE* p = mWorkers[i].mPinned; p != nullptr;
+            p = p->mNext) {
+          printCoroutine(printer, i, p);
+        }
+        for (T_COROUTINE* p = mWorkers[i].mHead; p != nullptr; p = p->mNext) {
+          printCoroutine(printer, i, p);
+        }
+        for (T_COROUTINE* p = mWorkers[i].mDone; p != nullptr; p = p->mNext) {
+          printCoroutine(printer, i, p);
+        }
+      }
+    }
+
+    /** Print a single coroutine, in the same format as CoroutineScheduler. */
+    static void printCoroutine(
+        Print& printer, uint8_t worker, T_COROUTINE* coroutine) {
+      printer.print(F("Coroutine "));
+      printer.print((uintptr_t) coroutine);
+      printer.print(':');
+      coroutine->printName(&printer);
+      printer.print('@');
+      printer.print(coroutine->getLineNumber());
+      printer.print(F("; worker: "));
+      printer.print(worker);
+      printer.print(F("; status: "));
+      coroutine->statusPrintTo(printer);
+      printer.println();
+    }
+
+    Worker mWorkers[N_MAX_WORKERS];
+    uint8_t mNumWorkers = 1;
+    std::atomic<bool> mRunning{false};
+    std::atomic<uint32_t> mNumActive{0};
+};
+
+/**
+ * A CoroutineWorkStealingScheduler with up to 8 worker threads on EpoxyDuino,
+ * or 2 on the ESP32.
+ */
+#if defined(ESP32)
+using CoroutineWorkStealingScheduler =
+    CoroutineWorkStealingSchedulerTemplate<Coroutine, 2>;
+#else
+using CoroutineWorkStealingScheduler =
+    CoroutineWorkStealingSchedulerTemplate<Coroutine, 8>;
+#endif
+
+}
+
+#endif // defined(EPOXY_DUINO) || defined(ESP32)
+
+#endif
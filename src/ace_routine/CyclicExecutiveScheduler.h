@@ -0,0 +1,396 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_CYCLIC_EXECUTIVE_SCHEDULER_H
+#define ACE_ROUTINE_CYCLIC_EXECUTIVE_SCHEDULER_H
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t
+#if defined(__AVR__)
+  #include <avr/pgmspace.h> // PROGMEM, pgm_read_byte()
+#endif
+#include "ClockInterface.h"
+#include "StaticCoroutineScheduler.h"
+
+namespace ace_routine {
+
+/**
+ * A periodic coroutine of a CyclicExecutiveScheduler. The coroutine of class
+ * T_COROUTINE, a subclass of StaticCoroutineTemplate, is run once every
+ * PERIOD_MILLIS, starting OFFSET_MILLIS after the start of the hyperperiod.
+ * Both must be multiples of the minor frame of the scheduler. Different
+ * offsets spread the coroutines with the same period over different frames.
+ */
+template <
+    typename T_COROUTINE,
+    uint16_t PERIOD_MILLIS,
+    uint16_t OFFSET_MILLIS = 0>
+struct CyclicTask {
+  /** Class of the coroutine. */
+  typedef T_COROUTINE CoroutineType;
+
+  /** Period of the coroutine. */
+  static const uint16_t kPeriodMillis = PERIOD_MILLIS;
+
+  /** Start of the first period. */
+  static const uint16_t kOffsetMillis = OFFSET_MILLIS;
+
+  static_assert(PERIOD_MILLIS > 0, "Period must not be 0");
+  static_assert(OFFSET_MILLIS < PERIOD_MILLIS,
+      "Offset must be less than the period");
+};
+
+/** A compile-time sequence of frame indexes, 0 to N-1. */
+template <uint16_t... Is>
+struct CyclicIndexes {};
+
+/** Concatenate 2 halves of a sequence of frame indexes. */
+template <typename T_FIRST, typename T_SECOND>
+struct CyclicConcatIndexes;
+
+template <uint16_t... Is, uint16_t... Js>
+struct CyclicConcatIndexes<CyclicIndexes<Is...>, CyclicIndexes<Js...>> {
+  typedef CyclicIndexes<Is..., (uint16_t) (sizeof...(Is) + Js)...> Type;
+};
+
+/**
+ * Create CyclicIndexes<0, ..., N-1>. Built by halves, so that the depth of
+ * the template recursion is log2(N) instead of N.
+ */
+template <uint16_t N>
+struct CyclicMakeIndexes {
+  typedef typename CyclicConcatIndexes<
+      typename CyclicMakeIndexes<N / 2>::Type,
+      typename CyclicMakeIndexes<N - N / 2>::Type>::Type Type;
+};
+
+template <>
+struct CyclicMakeIndexes<0> {
+  typedef CyclicIndexes<> Type;
+};
+
+template <>
+struct CyclicMakeIndexes<1> {
+  typedef CyclicIndexes<0> Type;
+};
+
+/** The smallest unsigned type with at least N bits. */
+template <bool FITS_8, bool FITS_16>
+struct CyclicMaskSelector {
+  typedef uint32_t Type;
+};
+
+template <>
+struct CyclicMaskSelector<false, true> {
+  typedef uint16_t Type;
+};
+
+template <>
+struct CyclicMaskSelector<true, true> {
+  typedef uint8_t Type;
+};
+
+/**
+ * A time-triggered scheduler which runs a fixed set of periodic coroutines
+ * from a schedule table computed at compile time.
+ *
+ * The hyperperiod (the least common multiple of the periods of the
+ * T_TASKS) is divided into minor frames of MINOR_FRAME_MILLIS. For each
+ * frame, the table holds a bitmask of the coroutines whose period starts in
+ * that frame. The table is a constexpr array of one byte per frame for up to
+ * 8 coroutines (2 bytes for 16, 4 bytes for 32). On AVR, it is placed in
+ * PROGMEM, so that it does not take any static RAM. On each minor frame
+ * boundary, loop() runs the coroutines of the current frame in the order of
+ * T_TASKS, then advances to the next entry of the table. Nothing is decided
+ * at run time except for the comparison of the clock with the start of the
+ * next frame.
+ *
+ * @code
+ * class Blink: public StaticCoroutine { ... };
+ * class Sound: public StaticCoroutine { ... };
+ *
+ * // 10 ms frames. Blink every 100 ms, Sound every 20 ms in odd frames.
+ * using Scheduler = CyclicExecutiveScheduler<10,
+ *     CyclicTask<Blink, 100>,
+ *     CyclicTask<Sound, 20, 10>>;
+ *
+ * void loop() {
+ *   Scheduler::loop();
+ * }
+ * @endcode
+ *
+ * Each run of a coroutine should end with COROUTINE_YIELD(). A
+ * COROUTINE_DELAY() works, but is checked only when the table runs the
+ * coroutine. Suspended or terminated coroutines are skipped.
+ *
+ * If loop() is called more than one minor frame late, for example because
+ * the coroutines of a frame ran for too long, the overrun is counted by
+ * getNumOverruns(), and the frames which were missed are skipped. loop() runs
+ * the frame which matches the current time instead, so that the coroutines
+ * keep their phase relative to the start of the hyperperiod.
+ *
+ * @tparam T_CLOCK class that provides millis() as a static method, used to
+ *    time the frames
+ * @tparam MINOR_FRAME_MILLIS duration of the minor frame
+ * @tparam T_TASKS the CyclicTask of each coroutine
+ */
+template <typename T_CLOCK, uint16_t MINOR_FRAME_MILLIS, typename... T_TASKS>
+class CyclicExecutiveSchedulerTemplate {
+  private:
+    /** Least common multiple of the periods of the tasks. */
+    template <typename... T>
+    struct Hyperperiod {
+      static constexpr uint32_t value() { return 1; }
+    };
+
+    template <typename T, typename... T_REST>
+    struct Hyperperiod<T, T_REST...> {
+      static constexpr uint32_t gcd(uint32_t a, uint32_t b) {
+        return (b == 0) ? a : gcd(b, a % b);
+      }
+
+      static constexpr uint32_t value() {
+        return T::kPeriodMillis / gcd(T::kPeriodMillis,
+            Hyperperiod<T_REST...>::value())
+            * Hyperperiod<T_REST...>::value();
+      }
+    };
+
+    /** True if the periods and offsets of the tasks are whole frames. */
+    template <typename... T>
+    struct Aligned {
+      static constexpr bool value() { return true; }
+    };
+
+    template <typename T, typename... T_REST>
+    struct Aligned<T, T_REST...> {
+      static constexpr bool value() {
+        return T::kPeriodMillis % MINOR_FRAME_MILLIS == 0
+            && T::kOffsetMillis % MINOR_FRAME_MILLIS == 0
+            && Aligned<T_REST...>::value();
+      }
+    };
+
+  public:
+    /** Number of coroutines. */
+    static const uint8_t kNumTasks = sizeof...(T_TASKS);
+
+    /** Duration of the hyperperiod, the major frame. */
+    static constexpr uint32_t kHyperperiodMillis =
+        Hyperperiod<T_TASKS...>::value();
+
+    /** Number of minor frames in the hyperperiod. */
+    static constexpr uint32_t kNumFrames =
+        kHyperperiodMillis / MINOR_FRAME_MILLIS;
+
+    static_assert(MINOR_FRAME_MILLIS > 0, "Minor frame must not be 0");
+    static_assert(kNumTasks > 0 && kNumTasks <= 32,
+        "Number of tasks must be 1 to 32");
+    static_assert(Aligned<T_TASKS...>::value(),
+        "Periods and offsets must be multiples of the minor frame");
+    static_assert(kNumFrames <= 0xFFFF, "Too many frames in the hyperperiod");
+
+    /** Type of the bitmask of the coroutines of a frame. */
+    typedef typename CyclicMaskSelector<
+        (kNumTasks <= 8), (kNumTasks <= 16)>::Type Mask;
+
+    /** Return the instance of the coroutine of class T. */
+    template <typename T>
+    static T& get() { return Instance<T>::sInstance; }
+
+    /** Start at the first frame, on the next call to loop(). */
+    static void setup() {
+      sFrame = 0;
+      sFrameStartMillis = T_CLOCK::millis();
+      sNumOverruns = 0;
+    }
+
+    /**
+     * If the start of the next minor frame has been reached, run the
+     * coroutines of that frame, and advance to the following frame.
+     */
+    static void loop() {
+      unsigned long lateMillis = T_CLOCK::millis() - sFrameStartMillis;
+      if ((long) lateMillis < 0) return;
+      if (lateMillis >= MINOR_FRAME_MILLIS) {
+        // Skip the missed frames. The division by a constant is cheap, and
+        // happens only on an overrun.
+        sNumOverruns++;
+        uint32_t skipped = lateMillis / MINOR_FRAME_MILLIS;
+        sFrameStartMillis += skipped * MINOR_FRAME_MILLIS;
+        sFrame = (uint16_t) ((sFrame + skipped % kNumFrames) % kNumFrames);
+      }
+
+      clockSnapshot();
+      Runner<0, T_TASKS...>::run(
+          frameMask(sFrame, typename CyclicMakeIndexes<kNumFrames>::Type()));
+
+      sFrameStartMillis += MINOR_FRAME_MILLIS;
+      if (++sFrame >= kNumFrames) sFrame = 0;
+    }
+
+    /** Return the index of the next frame to run by loop(). */
+    static uint16_t getFrame() { return sFrame; }
+
+    /** Return the number of frames which were started late. */
+    static uint16_t getNumOverruns() { return sNumOverruns; }
+
+    /** Return the bitmask of the coroutines of the given frame. */
+    static Mask getFrameMask(uint16_t frame) {
+      return frameMask(frame, typename CyclicMakeIndexes<kNumFrames>::Type());
+    }
+
+  private:
+    /** Holder of the static instance of a coroutine of class T. */
+    template <typename T>
+    struct Instance {
+      static T sInstance;
+    };
+
+    /** Bitmask of the tasks T whose period starts at the given time. */
+    template <uint8_t I, typename... T>
+    struct FrameMask {
+      static constexpr Mask at(uint32_t /*millis*/) { return 0; }
+    };
+
+    template <uint8_t I, typename T, typename... T_REST>
+    struct FrameMask<I, T, T_REST...> {
+      static constexpr Mask at(uint32_t millis) {
+        return (millis % T::kPeriodMillis == T::kOffsetMillis
+                ? (Mask) ((Mask) 1 << I) : (Mask) 0)
+            | FrameMask<I + 1, T_REST...>::at(millis);
+      }
+    };
+
+    /**
+     * Look up the frame in the schedule table, built at compile time. On AVR,
+     * the table is read from flash memory.
+     */
+    template <uint16_t... Is>
+    static Mask frameMask(uint16_t frame, CyclicIndexes<Is...>) {
+    #if defined(__AVR__)
+      static const Mask kTable[] PROGMEM = {
+        FrameMask<0, T_TASKS...>::at((uint32_t) Is * MINOR_FRAME_MILLIS)...
+      };
+      return readMask(&kTable[frame]);
+    #else
+      static constexpr Mask kTable[] = {
+        FrameMask<0, T_TASKS...>::at((uint32_t) Is * MINOR_FRAME_MILLIS)...
+      };
+      return kTable[frame];
+    #endif
+    }
+
+  #if defined(__AVR__)
+    /** Read an 8-bit mask from flash memory. */
+    static uint8_t readMask(const uint8_t* p) { return pgm_read_byte(p); }
+
+    /** Read a 16-bit mask from flash memory. */
+    static uint16_t readMask(const uint16_t* p) { return pgm_read_word(p); }
+
+    /** Read a 32-bit mask from flash memory. */
+    static uint32_t readMask(const uint32_t* p) { return pgm_read_dword(p); }
+  #endif
+
+    /** Run the coroutines of the tasks whose bit is set in the mask. */
+    template <uint8_t I, typename... T>
+    struct Runner {
+      static void run(Mask /*mask*/) {}
+    };
+
+    template <uint8_t I, typename T, typename... T_REST>
+    struct Runner<I, T, T_REST...> {
+      static void run(Mask mask) {
+        if (mask & ((Mask) 1 << I)) {
+          runCoroutine(get<typename T::CoroutineType>());
+        }
+        Runner<I + 1, T_REST...>::run(mask);
+      }
+    };
+
+    /**
+     * Run the given coroutine, using a qualified call to runCoroutine() so
+     * that it is not dispatched through the vtable.
+     */
+    template <typename T>
+    static void runCoroutine(T& coroutine) {
+      switch (coroutine.getStatus()) {
+        case T::kStatusYielding:
+        case T::kStatusDelaying:
+        case T::kStatusWaiting:
+          coroutine.T::runCoroutine();
+          break;
+
+        case T::kStatusEnding:
+          coroutine.setTerminated();
+          break;
+
+        default:
+          // Suspended or Terminated.
+          break;
+      }
+    }
+
+    /** Call snapshot() on the clock of each coroutine. */
+    static void clockSnapshot() {
+      int dummy[] = {0,
+          (T_TASKS::CoroutineType::coroutineClockSnapshot(), 0)...};
+      (void) dummy;
+    }
+
+    /** Index of the next frame to run. */
+    static uint16_t sFrame;
+
+    /** Time when the next frame should start. */
+    static unsigned long sFrameStartMillis;
+
+    /** Number of frames which started late. */
+    static uint16_t sNumOverruns;
+};
+
+template <typename T_CLOCK, uint16_t MINOR_FRAME_MILLIS, typename... T_TASKS>
+template <typename T>
+T CyclicExecutiveSchedulerTemplate<T_CLOCK, MINOR_FRAME_MILLIS, T_TASKS...>
+    ::Instance<T>::sInstance;
+
+template <typename T_CLOCK, uint16_t MINOR_FRAME_MILLIS, typename... T_TASKS>
+uint16_t CyclicExecutiveSchedulerTemplate<
+    T_CLOCK, MINOR_FRAME_MILLIS, T_TASKS...>::sFrame;
+
+template <typename T_CLOCK, uint16_t MINOR_FRAME_MILLIS, typename... T_TASKS>
+unsigned long CyclicExecutiveSchedulerTemplate<
+    T_CLOCK, MINOR_FRAME_MILLIS, T_TASKS...>::sFrameStartMillis;
+
+template <typename T_CLOCK, uint16_t MINOR_FRAME_MILLIS, typename... T_TASKS>
+uint16_t CyclicExecutiveSchedulerTemplate<
+    T_CLOCK, MINOR_FRAME_MILLIS, T_TASKS...>::sNumOverruns;
+
+/** A CyclicExecutiveSchedulerTemplate timed by the ClockInterface. */
+template <uint16_t MINOR_FRAME_MILLIS, typename... T_TASKS>
+using CyclicExecutiveScheduler = CyclicExecutiveSchedulerTemplate<
+    ClockInterface, MINOR_FRAME_MILLIS, T_TASKS...>;
+
+}
+
+#endif
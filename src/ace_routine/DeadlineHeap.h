@@ -0,0 +1,124 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_DEADLINE_HEAP_H
+#define ACE_ROUTINE_DEADLINE_HEAP_H
+
+#include <stdint.h> // uint16_t
+
+namespace ace_routine {
+
+/**
+ * A binary min-heap of at most N sleeping coroutines, ordered by the deadline
+ * of their delay (`mDelayStart + mDelayDuration`), so that a scheduler checks
+ * only top() to find the coroutines whose delays have expired, instead of
+ * resuming each one. Used by CoroutineDeadlineScheduler and
+ * CoroutinePriorityScheduler.
+ *
+ * Only coroutines delaying in the same unit can be compared, so the schedulers
+ * put only delays in milliseconds into the heap. The deadlines are compared
+ * using the signed difference of DelayValue, so they must all lie within half
+ * of the range of DelayValue from each other, which is the same requirement
+ * imposed by `Coroutine::setDelayMillis()`.
+ *
+ * @tparam T_COROUTINE class of the coroutine, usually `Coroutine`
+ * @tparam N maximum number of coroutines in the heap
+ */
+template <typename T_COROUTINE, uint16_t N>
+class DeadlineHeap {
+  public:
+    /** Constructor. */
+    DeadlineHeap() = default;
+
+    /** Return the number of coroutines in the heap. */
+    uint16_t size() const { return mSize; }
+
+    /** Return true if the heap is empty. */
+    bool isEmpty() const { return mSize == 0; }
+
+    /** Return true if no more coroutines can be pushed. */
+    bool isFull() const { return mSize >= N; }
+
+    /** Return the coroutine with the earliest deadline. Must not be empty. */
+    T_COROUTINE* top() const { return mCoroutines[0]; }
+
+    /** Return the i-th coroutine, in heap order, for listing. */
+    T_COROUTINE* at(uint16_t i) const { return mCoroutines[i]; }
+
+    /** Insert the coroutine into the heap. Caller checks isFull(). */
+    void push(T_COROUTINE* coroutine) {
+      uint16_t i = mSize++;
+      while (i > 0) {
+        uint16_t parent = (i - 1) / 2;
+        if (! isEarlier(coroutine, mCoroutines[parent])) break;
+        mCoroutines[i] = mCoroutines[parent];
+        i = parent;
+      }
+      mCoroutines[i] = coroutine;
+    }
+
+    /** Remove the coroutine with the earliest deadline. Must not be empty. */
+    T_COROUTINE* pop() {
+      T_COROUTINE* top = mCoroutines[0];
+      T_COROUTINE* last = mCoroutines[--mSize];
+      uint16_t i = 0;
+      while (true) {
+        uint16_t child = 2 * i + 1;
+        if (child >= mSize) break;
+        if (child + 1 < mSize
+            && isEarlier(mCoroutines[child + 1], mCoroutines[child])) {
+          child++;
+        }
+        if (! isEarlier(mCoroutines[child], last)) break;
+        mCoroutines[i] = mCoroutines[child];
+        i = child;
+      }
+      mCoroutines[i] = last;
+      return top;
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    DeadlineHeap(const DeadlineHeap&) = delete;
+    DeadlineHeap& operator=(const DeadlineHeap&) = delete;
+
+    /**
+     * Return true if the deadline of coroutine a is before coroutine b. The
+     * signed difference handles the rollover of the 16-bit (or 32-bit) clock.
+     */
+    static bool isEarlier(const T_COROUTINE* a, const T_COROUTINE* b) {
+      return (typename T_COROUTINE::DelayDiff)
+          (a->getDelayDeadline() - b->getDelayDeadline()) < 0;
+    }
+
+    // The coroutines, in heap order.
+    T_COROUTINE* mCoroutines[N];
+
+    // Number of coroutines in mCoroutines.
+    uint16_t mSize = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,229 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_HIGH_RES_CLOCK_INTERFACE_H
+#define ACE_ROUTINE_HIGH_RES_CLOCK_INTERFACE_H
+
+/**
+ * @file HighResClockInterface.h
+ *
+ * Clock policies with a higher resolution than ClockInterface, for use as the
+ * T_CLOCK of CoroutineTemplate and the schedulers. Their millis(), micros() and
+ * seconds() return uint64_t, so they are normally paired with a T_DELAY of
+ * uint64_t, which never rolls over:
+ *
+ * @code
+ * using MonotonicCoroutine =
+ *     CoroutineTemplate<MonotonicClockInterface, uint64_t>;
+ * using MonotonicScheduler = CoroutineSchedulerTemplate<MonotonicCoroutine>;
+ * @endcode
+ *
+ * A smaller T_DELAY also works, since the delays are truncated to T_DELAY
+ * like the `unsigned long` of ClockInterface. This header is not included by
+ * <AceRoutine.h>, because the clocks are available only on some platforms.
+ */
+
+#include <stdint.h>
+#include <Arduino.h>
+#if defined(EPOXY_DUINO) || defined(__linux__)
+  #include <time.h> // clock_gettime()
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h> // __rdtsc()
+#endif
+
+/**
+ * Defined to 1 if CycleClockInterface is available: on x86 (rdtsc), ESP8266
+ * and ESP32 (CCOUNT), and ARM Cortex-M3/M4/M7 (DWT CYCCNT).
+ */
+#if defined(__x86_64__) || defined(__i386__) \
+    || defined(ESP8266) || defined(ESP32) \
+    || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+  #define ACE_ROUTINE_HAS_CYCLE_CLOCK 1
+#else
+  #define ACE_ROUTINE_HAS_CYCLE_CLOCK 0
+#endif
+
+namespace ace_routine {
+
+#if defined(EPOXY_DUINO) || defined(__linux__)
+
+/**
+ * A clock policy which reads `clock_gettime(CLOCK_MONOTONIC)` directly,
+ * instead of going through the Arduino millis() and micros() emulated by
+ * EpoxyDuino. It has nanosecond resolution, is not affected by changes to the
+ * wall clock, and returns 64-bit values which do not roll over. Available on
+ * Linux and EpoxyDuino.
+ *
+ * The clock starts at an arbitrary point (usually the boot of the host), not
+ * at 0 when the program starts.
+ */
+class MonotonicClockInterface {
+  public:
+    /** Get the current nanos. */
+    static uint64_t nanos() {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    /** Get the current micros. */
+    static uint64_t micros() { return nanos() / 1000; }
+
+    /** Get the current millis. */
+    static uint64_t millis() { return nanos() / 1000000; }
+
+    /** Get the current seconds. */
+    static uint64_t seconds() {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec;
+    }
+};
+
+#endif
+
+#if ACE_ROUTINE_HAS_CYCLE_CLOCK
+
+/**
+ * A clock policy which counts the cycles of the processor, using the time
+ * stamp counter (rdtsc) on x86, the CCOUNT register on the ESP8266 and ESP32,
+ * and the DWT CYCCNT register on ARM Cortex-M3/M4/M7. Its micros() has a
+ * resolution of one cycle, instead of the 4 micros of the AVR micros(), or the
+ * cost of a libc call on EpoxyDuino. Its nanos() allows benchmarks to time
+ * code which runs in less than a microsecond.
+ *
+ * Call begin() once before using the clock. It enables the DWT cycle counter
+ * on ARM, and determines the number of cycles per micro, from the CPU
+ * frequency on the ESP8266 and ESP32, from F_CPU on ARM, and by timing the
+ * counter against ::micros() for 10 millis on x86. The number of cycles per
+ * micro is an integer, so the clock runs fast or slow by up to 1 part in the
+ * CPU frequency in MHz, e.g. 0.4% at 240 MHz, which can be corrected with
+ * setCyclesPerMicro() if needed.
+ *
+ * The 32-bit counters of the ESP and ARM processors are extended to 64 bits
+ * in software, which requires the clock to be read at least once per rollover
+ * of the counter, e.g. every 17.9 seconds at 240 MHz. Any scheduler which
+ * runs a coroutine delaying with this clock does that. The extension is not
+ * thread-safe, so this clock should not be shared by the 2 cores of the ESP32.
+ */
+class CycleClockInterface {
+  public:
+    /** Enable the cycle counter, and determine the cycles per micro. */
+    static void begin() {
+    #if defined(ESP8266) || defined(ESP32)
+      setCyclesPerMicro(ESP.getCpuFreqMHz());
+    #elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+      demcr() |= kDemcrTrcena;
+      dwtCyccnt() = 0;
+      dwtCtrl() |= kDwtCtrlCyccntena;
+      setCyclesPerMicro(F_CPU / 1000000);
+    #else
+      unsigned long startMicros = ::micros();
+      uint64_t startCycles = readCycles();
+      while ((unsigned long) (::micros() - startMicros) < 10000) {}
+      uint64_t cycles = readCycles() - startCycles;
+      unsigned long elapsed = ::micros() - startMicros;
+      setCyclesPerMicro((cycles + elapsed / 2) / elapsed);
+    #endif
+    }
+
+    /** Set the number of cycles per micro. */
+    static void setCyclesPerMicro(uint32_t cyclesPerMicro) {
+      state().cyclesPerMicro = (cyclesPerMicro > 0) ? cyclesPerMicro : 1;
+    }
+
+    /** Return the number of cycles per micro. */
+    static uint32_t getCyclesPerMicro() { return state().cyclesPerMicro; }
+
+    /** Get the current cycles, extended to 64 bits. */
+    static uint64_t cycles() {
+    #if defined(__x86_64__) || defined(__i386__)
+      return readCycles();
+    #else
+      State& s = state();
+      uint32_t now = readCycles();
+      if (now < s.lastCycles) s.rollovers++;
+      s.lastCycles = now;
+      return ((uint64_t) s.rollovers << 32) | now;
+    #endif
+    }
+
+    /** Get the current nanos. */
+    static uint64_t nanos() {
+      uint64_t c = cycles();
+      uint32_t perMicro = getCyclesPerMicro();
+      return (c / perMicro) * 1000 + (c % perMicro) * 1000 / perMicro;
+    }
+
+    /** Get the current micros. */
+    static uint64_t micros() { return cycles() / getCyclesPerMicro(); }
+
+    /** Get the current millis. */
+    static uint64_t millis() { return micros() / 1000; }
+
+    /** Get the current seconds. */
+    static uint64_t seconds() { return micros() / 1000000; }
+
+  private:
+    /** Mutable state, in a function-local static to allow header-only use. */
+    struct State {
+      uint32_t cyclesPerMicro = 1;
+      uint32_t lastCycles = 0;
+      uint32_t rollovers = 0;
+    };
+
+    static State& state() {
+      static State s;
+      return s;
+    }
+
+  #if defined(__x86_64__) || defined(__i386__)
+    static uint64_t readCycles() { return __rdtsc(); }
+  #elif defined(ESP8266) || defined(ESP32)
+    static uint32_t readCycles() { return ESP.getCycleCount(); }
+  #else
+    // Registers of the Data Watchpoint and Trace unit of the Cortex-M.
+    static volatile uint32_t& demcr() {
+      return *(volatile uint32_t*) 0xE000EDFC;
+    }
+    static volatile uint32_t& dwtCtrl() {
+      return *(volatile uint32_t*) 0xE0001000;
+    }
+    static volatile uint32_t& dwtCyccnt() {
+      return *(volatile uint32_t*) 0xE0001004;
+    }
+    static const uint32_t kDemcrTrcena = 0x01000000;
+    static const uint32_t kDwtCtrlCyccntena = 0x00000001;
+
+    static uint32_t readCycles() { return dwtCyccnt(); }
+  #endif
+};
+
+#endif
+
+}
+
+#endif
@@ -0,0 +1,380 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_SECTION_COROUTINE_H
+#define ACE_ROUTINE_SECTION_COROUTINE_H
+
+#include <stdint.h> // uint16_t
+#include <Print.h> // Print
+#include "ClockInterface.h"
+#include "Coroutine.h"
+
+/**
+ * @file SectionCoroutine.h
+ *
+ * Coroutines which are registered at link time instead of at boot. Each
+ * COROUTINE_SECTION() places a constant descriptor of the coroutine into the
+ * 'ace_routine_coroutines' section, and the linker concatenates the
+ * descriptors of all translation units into a single array, bounded by the
+ * `__start_ace_routine_coroutines` and `__stop_ace_routine_coroutines` symbols
+ * which GNU ld defines for every section whose name is a valid C identifier.
+ * The SectionCoroutineScheduler walks that array, so the coroutines need no
+ * linked list pointer and no constructor runs at boot. The order of the
+ * coroutines is the order of the descriptors in the section, which is chosen
+ * by the compiler and the linker, and should not be relied upon.
+ *
+ * The section is placed by the default linker script of the target, which is
+ * correct for the ELF targets whose read-only data is readable through a
+ * normal pointer (Linux, ARM, ESP8266, ESP32). On AVR, read-only data must be
+ * copied into RAM by the startup code or read with pgm_read_word(), neither of
+ * which happens to an orphan section, so ACE_ROUTINE_HAS_SECTION_REGISTRY is 0
+ * and this file defines nothing.
+ */
+
+#if defined(__GNUC__) && defined(__ELF__) && ! defined(ARDUINO_ARCH_AVR)
+  #define ACE_ROUTINE_HAS_SECTION_REGISTRY 1
+#else
+  #define ACE_ROUTINE_HAS_SECTION_REGISTRY 0
+#endif
+
+#if ACE_ROUTINE_HAS_SECTION_REGISTRY
+
+/**
+ * Create a SectionCoroutine instance named 'name', and register it in the
+ * 'ace_routine_coroutines' section. Two forms are supported:
+ *
+ *   - COROUTINE_SECTION(name) {...}
+ *   - COROUTINE_SECTION(className, name) {...}
+ *
+ * The 2-argument form uses the user-provided className which must be a
+ * subclass of SectionCoroutineTemplate. The code in {} following this macro
+ * becomes the body of the runCoroutine() method.
+ */
+#define COROUTINE_SECTION(...) \
+    GET_COROUTINE_SECTION(\
+        __VA_ARGS__, COROUTINE_SECTION2, COROUTINE_SECTION1)(__VA_ARGS__)
+
+/**
+ * Internal helper macro to allow overloading of the COROUTINE_SECTION() macro.
+ */
+#define GET_COROUTINE_SECTION(_1, _2, NAME, ...) NAME
+
+/** Implement the 1-argument COROUTINE_SECTION() macro. */
+#define COROUTINE_SECTION1(name) \
+struct SectionCoroutine_##name : ace_routine::SectionCoroutine { \
+  ACE_ROUTINE_NAME_DECL() \
+  int runCoroutine(); \
+} name; \
+ACE_ROUTINE_SECTION_DESCRIPTOR(SectionCoroutine_##name, name) \
+ACE_ROUTINE_NAME_DEF(SectionCoroutine_##name, "SectionCoroutine_" #name) \
+int SectionCoroutine_##name :: runCoroutine()
+
+/** Implement the 2-argument COROUTINE_SECTION() macro. */
+#define COROUTINE_SECTION2(className, name) \
+struct className##_##name : className { \
+  ACE_ROUTINE_NAME_DECL() \
+  int runCoroutine(); \
+} name; \
+ACE_ROUTINE_SECTION_DESCRIPTOR(className##_##name, name) \
+ACE_ROUTINE_NAME_DEF(className##_##name, #className "_" #name) \
+int className##_##name :: runCoroutine()
+
+/**
+ * Create an extern reference to a coroutine that is defined in another .cpp
+ * file using COROUTINE_SECTION(). Two forms are supported:
+ *
+ *    - EXTERN_COROUTINE_SECTION(name);
+ *    - EXTERN_COROUTINE_SECTION(className, name);
+ */
+#define EXTERN_COROUTINE_SECTION(...) \
+    GET_COROUTINE_SECTION(__VA_ARGS__, \
+        EXTERN_COROUTINE_SECTION2, EXTERN_COROUTINE_SECTION1)(__VA_ARGS__)
+
+/** Implement the 1-argument EXTERN_COROUTINE_SECTION() macro. */
+#define EXTERN_COROUTINE_SECTION1(name) \
+struct SectionCoroutine_##name : ace_routine::SectionCoroutine { \
+  ACE_ROUTINE_NAME_DECL() \
+  int runCoroutine(); \
+}; \
+extern SectionCoroutine_##name name
+
+/** Implement the 2-argument EXTERN_COROUTINE_SECTION() macro. */
+#define EXTERN_COROUTINE_SECTION2(className, name) \
+struct className##_##name : className { \
+  ACE_ROUTINE_NAME_DECL() \
+  int runCoroutine(); \
+}; \
+extern className##_##name name
+
+/**
+ * Internal helper macro which places the descriptor of the coroutine 'name' of
+ * class 'className' into the 'ace_routine_coroutines' section. The 'used'
+ * attribute keeps the otherwise unreferenced descriptor from being discarded
+ * by the compiler.
+ */
+#define ACE_ROUTINE_SECTION_DESCRIPTOR(className, name) \
+static const ace_routine::SectionCoroutineDescriptor \
+    kSectionCoroutineDescriptor_##name \
+    __attribute__((section("ace_routine_coroutines"), used)) = { \
+      &name, &className::dispatchCoroutine<className> \
+    };
+
+namespace ace_routine {
+
+/**
+ * An entry of the 'ace_routine_coroutines' section. It does not depend on the
+ * class of the coroutine, so that the coroutines of every class and every
+ * clock can share the same section. Both fields are address constants, so the
+ * descriptor is constant initialized.
+ */
+struct SectionCoroutineDescriptor {
+  /** The coroutine. */
+  void* coroutine;
+
+  /**
+   * Function which runs one step of the coroutine, casting it back to its
+   * class and calling its runCoroutine() directly.
+   */
+  void (*dispatch)(void* coroutine);
+};
+
+}
+
+/**
+ * Bounds of the 'ace_routine_coroutines' section, defined by the linker. They
+ * are weak, so that a program without a COROUTINE_SECTION() still links, with
+ * both symbols resolving to null.
+ */
+extern "C" {
+extern const ace_routine::SectionCoroutineDescriptor
+    __start_ace_routine_coroutines[] __attribute__((weak));
+extern const ace_routine::SectionCoroutineDescriptor
+    __stop_ace_routine_coroutines[] __attribute__((weak));
+}
+
+namespace ace_routine {
+
+/**
+ * Base class of a coroutine which is registered at link time by the
+ * COROUTINE_SECTION() macro. It has no virtual methods and no linked list
+ * pointers, and its constructor is a constexpr, so a global instance is
+ * constant initialized: it is placed in the .data section with its initial
+ * state, instead of being initialized by a constructor before setup().
+ *
+ * The derived class provides a non-virtual `int runCoroutine()`, which is
+ * called through the dispatchCoroutine() function stored in its descriptor.
+ *
+ * @tparam T_CLOCK class that provides micros(), millis(), and seconds() as
+ *    static methods
+ * @tparam T_DELAY type of the delay fields, uint8_t, uint16_t or uint32_t
+ */
+template <typename T_CLOCK, typename T_DELAY = DefaultDelayValue>
+class SectionCoroutineTemplate:
+    public CoroutineCoreTemplate<T_CLOCK, T_DELAY> {
+  public:
+    /**
+     * Suspend the coroutine. The SectionCoroutineScheduler skips a suspended
+     * coroutine. If the coroutine is ending or terminated, this method does
+     * nothing.
+     */
+    void suspend() {
+      if (this->isDone()) return;
+      this->mStatus = this->kStatusSuspended;
+    }
+
+    /**
+     * Change a Suspended coroutine to the Yielding state. If the coroutine is
+     * in any other state, this method does nothing.
+     */
+    void resume() {
+      if (this->mStatus != this->kStatusSuspended) return;
+      this->mStatus = this->kStatusYielding;
+    }
+
+    /** Reset the coroutine to its initial state. */
+    void reset() {
+      this->mStatus = this->kStatusYielding;
+      this->mJumpPoint = nullptr;
+      // Make the next COROUTINE_PERIODIC() start from the current time.
+      this->mDelayType = this->kDelayTypeMillis;
+    }
+
+    /** Print the name of the coroutine. Hidden by the derived class. */
+    void printName(Print* pPrinter) { pPrinter->print('?'); }
+
+    /**
+     * Run one step of the coroutine of class T_DERIVED, or retire it if it
+     * is ending. Stored in its SectionCoroutineDescriptor by
+     * COROUTINE_SECTION(), and not intended to be called directly.
+     */
+    template <typename T_DERIVED>
+    static void dispatchCoroutine(void* coroutine) {
+      T_DERIVED* derived = static_cast<T_DERIVED*>(coroutine);
+      switch (derived->mStatus) {
+        case SectionCoroutineTemplate::kStatusYielding:
+        case SectionCoroutineTemplate::kStatusDelaying:
+          derived->runCoroutine();
+          break;
+
+        case SectionCoroutineTemplate::kStatusEnding:
+          derived->setTerminated();
+          break;
+
+        default:
+          // Suspended or Terminated, skip.
+          break;
+      }
+    }
+
+  protected:
+    /** Constructor. Constant initialized, does not register anything. */
+    constexpr SectionCoroutineTemplate() = default;
+
+    /** Destructor. Non-virtual. */
+    ~SectionCoroutineTemplate() = default;
+
+    /**
+     * Used by COROUTINE_AWAIT_ON(). A SectionCoroutine is never parked on a
+     * WaitQueue, so it stays in the Yielding state and its condition is
+     * polled on every pass.
+     */
+    template <typename T_QUEUE>
+    void setWaiting(T_QUEUE* /*queue*/) {
+      this->mStatus = this->kStatusYielding;
+    }
+
+    /**
+     * Used by COROUTINE_AWAIT_PREDICATE(). A SectionCoroutine is not run by the
+     * CoroutineScheduler, so it stays in the Yielding state and evaluates its
+     * own predicate on every pass.
+     */
+    void setAwaitPredicate(AwaitPredicate /*predicate*/, void* /*context*/) {
+      this->mStatus = this->kStatusYielding;
+    }
+
+    /** Used by COROUTINE_AWAIT_PREDICATE() to evaluate the predicate. */
+    bool isAwaitPredicateDone(AwaitPredicate predicate, void* context) {
+      return predicate(context);
+    }
+};
+
+/** A SectionCoroutineTemplate using the ClockInterface. */
+using SectionCoroutine = SectionCoroutineTemplate<ClockInterface>;
+
+/**
+ * A round-robin scheduler of the coroutines in the 'ace_routine_coroutines'
+ * section. The section is a single array for the whole program, so this
+ * scheduler runs every COROUTINE_SECTION() regardless of its clock. T_CLOCK
+ * is only used to take the snapshot at the start of each pass, and should be
+ * the clock of the coroutines.
+ *
+ * The number of coroutines is fixed at link time, and setup() only resets the
+ * index of the current coroutine, so the first coroutine is dispatched
+ * without any registration or list walk at boot.
+ *
+ * @tparam T_CLOCK class that provides micros(), millis(), and seconds() as
+ *    static methods, and optionally snapshot() (see ClockTraits)
+ */
+template <typename T_CLOCK>
+class SectionCoroutineSchedulerTemplate {
+  public:
+    /** Set up the scheduler. Should be called from the global setup(). */
+    static void setup() { getScheduler()->setupScheduler(); }
+
+    /** Run the current coroutine, then advance to the next one. */
+    static void loop() { getScheduler()->runCoroutine(); }
+
+    /** Run every coroutine once, starting from the first one. */
+    static void runOnePass() {
+      ClockTraits<T_CLOCK>::snapshot();
+      for (const SectionCoroutineDescriptor* d = begin(); d != end(); d++) {
+        d->dispatch(d->coroutine);
+      }
+      getScheduler()->mIndex = 0;
+    }
+
+    /** Return the number of coroutines in the section. */
+    static uint16_t getNumCoroutines() { return end() - begin(); }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    SectionCoroutineSchedulerTemplate(
+        const SectionCoroutineSchedulerTemplate&) = delete;
+    SectionCoroutineSchedulerTemplate& operator=(
+        const SectionCoroutineSchedulerTemplate&) = delete;
+
+    /** Return the singleton instance of the scheduler. */
+    static SectionCoroutineSchedulerTemplate* getScheduler() {
+      static SectionCoroutineSchedulerTemplate singletonScheduler;
+      return &singletonScheduler;
+    }
+
+    /** First descriptor of the section. */
+    static const SectionCoroutineDescriptor* begin() {
+      return __start_ace_routine_coroutines;
+    }
+
+    /** One past the last descriptor of the section. */
+    static const SectionCoroutineDescriptor* end() {
+      return __stop_ace_routine_coroutines;
+    }
+
+    /** Constructor. */
+    SectionCoroutineSchedulerTemplate() = default;
+
+    /** Start at the first coroutine. */
+    void setupScheduler() {
+      mIndex = 0;
+      ClockTraits<T_CLOCK>::snapshot();
+    }
+
+    /** Run the current coroutine, then advance to the next one. */
+    void runCoroutine() {
+      uint16_t numCoroutines = getNumCoroutines();
+      if (numCoroutines == 0) return;
+
+      const SectionCoroutineDescriptor* d = begin() + mIndex;
+      d->dispatch(d->coroutine);
+
+      // If reached the end, start from the beginning again.
+      if (++mIndex >= numCoroutines) {
+        mIndex = 0;
+        ClockTraits<T_CLOCK>::snapshot();
+      }
+    }
+
+    /** Index of the coroutine to run on the next loop(). */
+    uint16_t mIndex = 0;
+};
+
+/** A SectionCoroutineSchedulerTemplate using the ClockInterface. */
+using SectionCoroutineScheduler =
+    SectionCoroutineSchedulerTemplate<ClockInterface>;
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,199 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_SPSC_CHANNEL_H
+#define ACE_ROUTINE_SPSC_CHANNEL_H
+
+#include <stdint.h> // uint16_t
+#include "Coroutine.h"
+
+/**
+ * The alignment of the read and write indexes of SpscChannel, which places
+ * them on separate cache lines so that the producer and the consumer do not
+ * invalidate each other's cache line on every message (false sharing).
+ * Defaults to 64 bytes on EpoxyDuino (Linux, MacOS), and to no padding on
+ * microcontrollers, where the extra RAM is not worth it. Can be overridden
+ * using a compiler flag.
+ */
+#if ! defined(ACE_ROUTINE_CACHE_LINE_SIZE)
+  #if defined(EPOXY_DUINO)
+    #define ACE_ROUTINE_CACHE_LINE_SIZE 64
+  #else
+    #define ACE_ROUTINE_CACHE_LINE_SIZE 4
+  #endif
+#endif
+
+namespace ace_routine {
+
+/**
+ * A bounded, lock-free, single-producer single-consumer channel, implemented
+ * as a ring buffer of N elements. Unlike Channel, the writer and the reader
+ * can run in different schedulers on different threads (e.g. the 2 cores of
+ * an ESP32, or 2 threads on Linux using EpoxyDuino). Exactly one coroutine
+ * (or thread) may write, and exactly one may read.
+ *
+ * The write index is published by the writer with release ordering and loaded
+ * by the reader with acquire ordering, and vice versa for the read index, so
+ * that the element in the slot is visible before the index which covers it.
+ * Each side keeps a private copy of the other side's index, and reloads it
+ * only when the buffer appears full (writer) or empty (reader).
+ *
+ * The same COROUTINE_CHANNEL_WRITE() and COROUTINE_CHANNEL_READ() macros used
+ * by Channel can be used with an SpscChannel:
+ *
+ * @code
+ * SpscChannel<int, 16> channel;
+ *
+ * COROUTINE(writer) {
+ *   COROUTINE_LOOP() {
+ *     COROUTINE_CHANNEL_WRITE(channel, value);
+ *     ...
+ *   }
+ * }
+ * @endcode
+ *
+ * A coroutine waiting for the channel cannot be parked on a WaitQueue,
+ * because the WaitQueue::notify() would be called from the other thread and
+ * would modify the linked list of a scheduler running concurrently. Instead,
+ * the waiting coroutine stays in the Yielding state, and its scheduler polls
+ * the channel once per pass, i.e. the waiter spins. The channel does not wake
+ * a coroutine on the other scheduler: that would require a thread-safe
+ * mailbox in each scheduler, which none of the schedulers have. A scheduler
+ * using CoroutineScheduler::loopOrSleep() does not sleep while one of its
+ * coroutines waits on an SpscChannel.
+ *
+ * @tparam T type of the value sent through the channel
+ * @tparam N number of elements in the ring buffer, must be a power of 2, at
+ *    most 32768
+ */
+template <typename T, uint16_t N>
+class SpscChannel {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of 2");
+  static_assert(N <= 32768, "N must be at most 32768");
+
+  public:
+    /** Constructor. */
+    SpscChannel() {}
+
+    /**
+     * Used by COROUTINE_CHANNEL_WRITE() to preserve the value of the write
+     * across multiple COROUTINE_YIELD() calls. Not designed to be used
+     * directly by the user.
+     */
+    void setValue(const T& value) {
+      mValueToWrite = value;
+    }
+
+    /**
+     * Return the object given to COROUTINE_AWAIT_ON() by
+     * COROUTINE_CHANNEL_WRITE() and COROUTINE_CHANNEL_READ(). It is not a
+     * WaitQueue, so the waiting coroutine is polled instead of parked. Not
+     * designed to be used directly by the user.
+     */
+    SpscChannel& getWaitQueue() { return *this; }
+
+    /**
+     * Same as write(const T& value) except use the value of setValue(). Used
+     * by COROUTINE_CHANNEL_WRITE() macro. Not designed to be used directly by
+     * the user.
+     */
+    bool write() {
+      return write(mValueToWrite);
+    }
+
+    /**
+     * Write the value into the channel. Return false if the channel is full.
+     * Must be called only by the writer.
+     */
+    bool write(const T& value) {
+      uint16_t tail = mTail;
+      if ((uint16_t) (tail - mCachedHead) == N) {
+        mCachedHead = __atomic_load_n(&mHead, __ATOMIC_ACQUIRE);
+        if ((uint16_t) (tail - mCachedHead) == N) return false;
+      }
+      mBuffer[tail & kMask] = value;
+      __atomic_store_n(&mTail, (uint16_t) (tail + 1), __ATOMIC_RELEASE);
+      return true;
+    }
+
+    /**
+     * Read a value from the channel. Return false if the channel is empty.
+     * Must be called only by the reader.
+     */
+    bool read(T& value) {
+      uint16_t head = mHead;
+      if (head == mCachedTail) {
+        mCachedTail = __atomic_load_n(&mTail, __ATOMIC_ACQUIRE);
+        if (head == mCachedTail) return false;
+      }
+      value = mBuffer[head & kMask];
+      __atomic_store_n(&mHead, (uint16_t) (head + 1), __ATOMIC_RELEASE);
+      return true;
+    }
+
+    /**
+     * Return the number of elements in the channel. The value is only a
+     * snapshot if the other side is running concurrently.
+     */
+    uint16_t size() const {
+      uint16_t tail = __atomic_load_n(&mTail, __ATOMIC_ACQUIRE);
+      uint16_t head = __atomic_load_n(&mHead, __ATOMIC_ACQUIRE);
+      return tail - head;
+    }
+
+    /** Return the capacity of the channel. */
+    static uint16_t capacity() { return N; }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    SpscChannel(const SpscChannel&) = delete;
+    SpscChannel& operator=(const SpscChannel&) = delete;
+
+    static const uint16_t kMask = N - 1;
+
+    // The indexes run freely from 0 to 65535, and are reduced modulo N when
+    // accessing mBuffer. (tail - head) is the number of elements, from 0 to N.
+
+    /** Index of the next element to read. Written only by the reader. */
+    alignas(ACE_ROUTINE_CACHE_LINE_SIZE) uint16_t mHead = 0;
+
+    /** Reader's copy of mTail. */
+    uint16_t mCachedTail = 0;
+
+    /** Index of the next element to write. Written only by the writer. */
+    alignas(ACE_ROUTINE_CACHE_LINE_SIZE) uint16_t mTail = 0;
+
+    /** Writer's copy of mHead. */
+    uint16_t mCachedHead = 0;
+
+    /** Value saved by setValue(), used only by the writer. */
+    T mValueToWrite;
+
+    /** The ring buffer. */
+    alignas(ACE_ROUTINE_CACHE_LINE_SIZE) T mBuffer[N];
+};
+
+}
+
+#endif
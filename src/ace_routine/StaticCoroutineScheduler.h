@@ -0,0 +1,212 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_STATIC_COROUTINE_SCHEDULER_H
+#define ACE_ROUTINE_STATIC_COROUTINE_SCHEDULER_H
+
+#include <stdint.h> // uint8_t
+#include "ClockInterface.h"
+#include "Coroutine.h"
+
+namespace ace_routine {
+
+/**
+ * Base class of a coroutine run by a StaticCoroutineScheduler. It is identical
+ * to CoroutineTemplate, except that the constructor does not insert the
+ * coroutine into the linked list used by the CoroutineScheduler.
+ *
+ * @tparam T_CLOCK class that provides micros(), millis(), and seconds() as
+ *    static methods
+ * @tparam T_DELAY type of the delay fields, uint8_t, uint16_t or uint32_t
+ */
+template <typename T_CLOCK, typename T_DELAY = DefaultDelayValue>
+class StaticCoroutineTemplate: public CoroutineTemplate<T_CLOCK, T_DELAY> {
+  public:
+    /** Constructor. Not inserted into the linked list. */
+    StaticCoroutineTemplate() :
+        CoroutineTemplate<T_CLOCK, T_DELAY>(
+            typename CoroutineTemplate<T_CLOCK, T_DELAY>::NotLinked()) {}
+};
+
+/**
+ * A StaticCoroutineTemplate using the ClockInterface. The base class of
+ * the coroutines given to a StaticCoroutineScheduler.
+ */
+using StaticCoroutine = StaticCoroutineTemplate<ClockInterface>;
+
+/**
+ * A scheduler for a set of coroutines which is fixed at compile time. Each
+ * type in T_COROUTINES is a distinct subclass of StaticCoroutine, and the
+ * scheduler owns one statically allocated instance of each, which is retrieved
+ * using get<T>().
+ *
+ * The CoroutineScheduler walks a linked list through the mNext pointers and
+ * calls the virtual runCoroutine() of each coroutine. This scheduler knows the
+ * concrete type of every coroutine at compile time, so runOnePass() unrolls
+ * into a sequence of direct, non-virtual calls to each runCoroutine(), which
+ * the compiler can inline. Its cost is close to calling runCoroutine() on each
+ * coroutine manually (see "Direct Scheduling" in the USER_GUIDE.md).
+ *
+ * @code
+ * class Blink: public StaticCoroutine {
+ *   public:
+ *     int runCoroutine() override { ... }
+ * };
+ *
+ * class Reporter: public StaticCoroutine {
+ *   public:
+ *     int runCoroutine() override { ... }
+ * };
+ *
+ * using Scheduler = StaticCoroutineScheduler<Blink, Reporter>;
+ *
+ * void setup() {
+ *   Scheduler::setup();
+ * }
+ *
+ * void loop() {
+ *   Scheduler::loop();
+ * }
+ * @endcode
+ *
+ * Coroutines which are suspended, or which have terminated, are skipped on
+ * each pass, since they cannot be removed from the compile-time list. A
+ * COROUTINE_AWAIT_ON() is polled on every pass, because the coroutine is never
+ * parked on its WaitQueue.
+ *
+ * @tparam T_COROUTINES the classes of the coroutines, in the order that they
+ *    are run
+ */
+template <typename... T_COROUTINES>
+class StaticCoroutineScheduler {
+  public:
+    /** Number of coroutines managed by this scheduler. */
+    static const uint8_t kNumCoroutines = sizeof...(T_COROUTINES);
+
+    /** Return the instance of the coroutine of class T. */
+    template <typename T>
+    static T& get() { return Instance<T>::sInstance; }
+
+    /** Restart the round-robin of loop() from the first coroutine. */
+    static void setup() { sCurrent = 0; }
+
+    /**
+     * Call the setupCoroutine() method of every coroutine, for the
+     * coroutines which override it.
+     */
+    static void setupCoroutines() {
+      int dummy[] = {0, (get<T_COROUTINES>().T_COROUTINES::setupCoroutine(),
+          0)...};
+      (void) dummy;
+    }
+
+    /**
+     * Run the current coroutine, then advance to the next one. Similar to
+     * CoroutineScheduler::loop(), the selection of the coroutine compiles to a
+     * chain of comparisons on the index instead of a pointer-chasing walk.
+     */
+    static void loop() {
+      if (sCurrent == 0) clockSnapshot();
+      Dispatcher<0, T_COROUTINES...>::run(sCurrent);
+      if (++sCurrent >= kNumCoroutines) sCurrent = 0;
+    }
+
+    /**
+     * Run every coroutine once, in the order given by T_COROUTINES, without
+     * using the cursor of loop(). Unrolls into a sequence of direct calls.
+     */
+    static void runOnePass() {
+      clockSnapshot();
+      int dummy[] = {0, (runCoroutine(get<T_COROUTINES>()), 0)...};
+      (void) dummy;
+    }
+
+  private:
+    /** Holder of the static instance of a coroutine of class T. */
+    template <typename T>
+    struct Instance {
+      static T sInstance;
+    };
+
+    /** Run coroutine number 'index', found by recursion over the types. */
+    template <uint8_t I, typename... T_REST>
+    struct Dispatcher {
+      static void run(uint8_t /*index*/) {}
+    };
+
+    template <uint8_t I, typename T, typename... T_REST>
+    struct Dispatcher<I, T, T_REST...> {
+      static void run(uint8_t index) {
+        if (index == I) {
+          runCoroutine(get<T>());
+        } else {
+          Dispatcher<I + 1, T_REST...>::run(index);
+        }
+      }
+    };
+
+    /**
+     * Run the given coroutine, using a qualified call to runCoroutine() so
+     * that it is not dispatched through the vtable.
+     */
+    template <typename T>
+    static void runCoroutine(T& coroutine) {
+      switch (coroutine.getStatus()) {
+        case T::kStatusYielding:
+        case T::kStatusDelaying:
+        case T::kStatusWaiting:
+          coroutine.T::runCoroutine();
+          break;
+
+        case T::kStatusEnding:
+          coroutine.setTerminated();
+          break;
+
+        default:
+          // Suspended or Terminated.
+          break;
+      }
+    }
+
+    /** Call snapshot() on the clock of each coroutine. */
+    static void clockSnapshot() {
+      int dummy[] = {0, (T_COROUTINES::coroutineClockSnapshot(), 0)...};
+      (void) dummy;
+    }
+
+    /** Index of the coroutine to be run by the next loop(). */
+    static uint8_t sCurrent;
+};
+
+template <typename... T_COROUTINES>
+template <typename T>
+T StaticCoroutineScheduler<T_COROUTINES...>::Instance<T>::sInstance;
+
+template <typename... T_COROUTINES>
+uint8_t StaticCoroutineScheduler<T_COROUTINES...>::sCurrent;
+
+}
+
+#endif
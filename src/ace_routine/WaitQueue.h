@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2021 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_WAIT_QUEUE_H
+#define ACE_ROUTINE_WAIT_QUEUE_H
+
+#include <stdint.h> // uint16_t
+#include "Coroutine.h"
+
+namespace ace_routine {
+
+/**
+ * A list of coroutines which are parked by COROUTINE_AWAIT_ON(), waiting for
+ * some event. When the CoroutineScheduler sees that a coroutine returned in
+ * the Waiting state, it moves the coroutine from its linked list into the
+ * WaitQueue, reusing the `Coroutine::mNext` and `Coroutine::mPrev` pointers.
+ * The scheduler no longer visits the coroutine until notify() puts it back
+ * into the linked list, or until Coroutine::reset() unparks it.
+ *
+ * The object which owns the WaitQueue (e.g. a Channel) must call notify()
+ * whenever something happens which could make the condition of
+ * COROUTINE_AWAIT_ON() true. Parked coroutines are not printed by
+ * CoroutineScheduler::list().
+ *
+ * The notify() method must not be called from an interrupt service routine.
+ *
+ * @tparam T_COROUTINE class of the coroutine, usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class WaitQueueTemplate {
+  friend class CoroutineSchedulerTemplate<T_COROUTINE>;
+  template <typename T, uint16_t N>
+  friend class CoroutineDeadlineSchedulerTemplate;
+  template <typename T, uint16_t N>
+  friend class CoroutinePrioritySchedulerTemplate;
+
+  public:
+    /** Constructor. */
+    WaitQueueTemplate() = default;
+
+    /**
+     * Wake up all coroutines parked on this queue, by inserting them back
+     * into the linked list of the scheduler. Each coroutine re-evaluates the
+     * condition of its COROUTINE_AWAIT_ON() when it runs again, and parks
+     * itself again if the condition is still false.
+     *
+     * A coroutine ranked by CoroutineScheduler::setDependencies() is inserted
+     * after its producers instead of at the root, so that a consumer woken up
+     * by its producer runs in the same pass of the scheduler.
+     */
+    void notify() {
+      T_COROUTINE* waiter = mHead;
+      mHead = nullptr;
+      while (waiter != nullptr) {
+        T_COROUTINE* next = waiter->mNext;
+        waiter->mPrev = nullptr;
+
+        // A parked coroutine may have been suspended while it waited, so
+        // change only the Waiting state.
+        if (waiter->isWaiting()) waiter->setYielding();
+        waiter->insertByRank();
+        waiter = next;
+      }
+    }
+
+    /** Return true if there are no coroutines parked on this queue. */
+    bool isEmpty() const { return mHead == nullptr; }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    WaitQueueTemplate(const WaitQueueTemplate&) = delete;
+    WaitQueueTemplate& operator=(const WaitQueueTemplate&) = delete;
+
+    /**
+     * Park the coroutine which has already been removed from the linked list
+     * of the scheduler. The list is doubly-linked, in the same way as the
+     * list of suspended coroutines, so that Coroutine::reset() can remove the
+     * coroutine in constant time.
+     */
+    void park(T_COROUTINE* coroutine) {
+      coroutine->insertInactive(&mHead);
+    }
+
+    /** Head of the singly-linked list of parked coroutines. */
+    T_COROUTINE* mHead = nullptr;
+};
+
+/** A WaitQueue for coroutines using the default ClockInterface. */
+using WaitQueue = WaitQueueTemplate<Coroutine>;
+
+}
+
+#endif
@@ -0,0 +1,128 @@
+#line 2 "AwaitBackoffTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+
+// ---------------------------------------------------------------------------
+
+bool ready = false;
+int numChecks = 0;
+
+// An expensive condition, which counts how often it is evaluated.
+bool isReady() {
+  numChecks++;
+  return ready;
+}
+
+class Waiter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT_BACKOFF(isReady(), 100, 1000);
+        count++;
+        ready = false;
+      }
+    }
+
+    int count = 0;
+};
+
+Waiter waiter;
+
+// Run the waiter at the given micros.
+void runAt(unsigned long micros) {
+  TestableClockInterface::setMicros(micros);
+  waiter.runCoroutine();
+}
+
+void resetAll() {
+  TestableClockInterface::setMicros(0);
+  ready = false;
+  numChecks = 0;
+  waiter.reset();
+  waiter.count = 0;
+}
+
+test(AwaitBackoffTest, backoff) {
+  resetAll();
+
+  runAt(0);
+  assertEqual(1, numChecks);
+  assertTrue(waiter.isDelaying());
+
+  // Not checked again until the interval has passed.
+  runAt(50);
+  assertEqual(1, numChecks);
+
+  // The interval doubles after each check: 100, 200, 400, 800, then it is
+  // limited to 1000.
+  runAt(100);
+  assertEqual(2, numChecks);
+  runAt(299);
+  assertEqual(2, numChecks);
+  runAt(300);
+  assertEqual(3, numChecks);
+  runAt(700);
+  assertEqual(4, numChecks);
+  runAt(1500);
+  assertEqual(5, numChecks);
+  runAt(2499);
+  assertEqual(5, numChecks);
+  runAt(2500);
+  assertEqual(6, numChecks);
+  runAt(3500);
+  assertEqual(7, numChecks);
+  assertEqual(0, waiter.count);
+
+  // Becomes true.
+  ready = true;
+  runAt(4000);
+  assertEqual(7, numChecks);
+  runAt(4500);
+  assertEqual(1, waiter.count);
+
+  // The next await checks immediately, then starts again from 100 micros.
+  assertEqual(9, numChecks);
+  runAt(4599);
+  assertEqual(9, numChecks);
+  runAt(4600);
+  assertEqual(10, numChecks);
+  runAt(4799);
+  assertEqual(10, numChecks);
+  runAt(4800);
+  assertEqual(11, numChecks);
+}
+
+test(AwaitBackoffTest, alreadyTrue) {
+  resetAll();
+
+  // A true condition does not yield, so the await of the next iteration is
+  // reached in the same run.
+  ready = true;
+  runAt(0);
+  assertEqual(1, waiter.count);
+  assertEqual(2, numChecks);
+  assertTrue(waiter.isDelaying());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
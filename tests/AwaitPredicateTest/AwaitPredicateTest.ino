@@ -0,0 +1,132 @@
+#line 2 "AwaitPredicateTest.ino"
+
+// Store the predicate in the Coroutine. Must be defined before AceRoutine.h.
+#define ACE_ROUTINE_AWAIT_PREDICATE 1
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+bool ready = false;
+int numChecks = 0;
+
+// Predicate which counts how often it is evaluated.
+bool isReady(void* context) {
+  numChecks++;
+  return *(bool*) context;
+}
+
+class Waiter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      numResumes++;
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT_PREDICATE(isReady, &ready);
+        count++;
+        ready = false;
+      }
+    }
+
+    int numResumes = 0;
+    int count = 0;
+};
+
+Waiter waiter;
+
+void resetAll() {
+  ready = false;
+  numChecks = 0;
+  waiter.reset();
+  waiter.numResumes = 0;
+  waiter.count = 0;
+  TestableCoroutineScheduler::setup();
+}
+
+test(AwaitPredicateTest, schedulerEvaluatesPredicate) {
+  resetAll();
+
+  // The first run blocks on the predicate.
+  TestableCoroutineScheduler::loop();
+  assertEqual(1, waiter.numResumes);
+  assertEqual(1, numChecks);
+  assertTrue(waiter.isYielding());
+
+  // The scheduler evaluates the predicate without resuming the coroutine.
+  TestableCoroutineScheduler::loop();
+  TestableCoroutineScheduler::loop();
+  assertEqual(1, waiter.numResumes);
+  assertEqual(3, numChecks);
+  assertEqual(0, waiter.count);
+
+  // The coroutine is resumed once the predicate is true, without evaluating
+  // it again, then blocks on the next iteration of the loop.
+  ready = true;
+  TestableCoroutineScheduler::loop();
+  assertEqual(2, waiter.numResumes);
+  assertEqual(5, numChecks);
+  assertEqual(1, waiter.count);
+}
+
+test(AwaitPredicateTest, doesNotYieldIfTrue) {
+  resetAll();
+
+  ready = true;
+  TestableCoroutineScheduler::loop();
+  assertEqual(1, waiter.numResumes);
+  assertEqual(2, numChecks);
+  assertEqual(1, waiter.count);
+}
+
+test(AwaitPredicateTest, runCoroutineDirectly) {
+  resetAll();
+
+  // Without the scheduler, the coroutine evaluates its own predicate.
+  waiter.runCoroutine();
+  waiter.runCoroutine();
+  assertEqual(2, waiter.numResumes);
+  assertEqual(2, numChecks);
+  assertEqual(0, waiter.count);
+
+  ready = true;
+  waiter.runCoroutine();
+  assertEqual(3, waiter.numResumes);
+  assertEqual(4, numChecks);
+  assertEqual(1, waiter.count);
+}
+
+test(AwaitPredicateTest, resetForgetsPredicate) {
+  resetAll();
+
+  TestableCoroutineScheduler::loop();
+  assertEqual(1, waiter.numResumes);
+
+  // The coroutine starts again from the beginning, even though the predicate
+  // is still false.
+  waiter.reset();
+  TestableCoroutineScheduler::loop();
+  assertEqual(2, waiter.numResumes);
+  assertEqual(2, numChecks);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
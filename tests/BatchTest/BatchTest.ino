@@ -0,0 +1,126 @@
+#line 2 "BatchTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Create the coroutines in the reverse order to the order desired, because each
+// coroutine is inserted at the head of the singly-linked list.
+
+class CoroutineB : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY(10);
+      }
+    }
+
+    int count = 0;
+};
+
+CoroutineB b;
+
+// Never idle. Advances the micros clock by 10 on each iteration.
+class CoroutineA : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        TestableClockInterface::setMicros(TestableClockInterface::micros() + 10);
+        COROUTINE_YIELD();
+      }
+    }
+
+    int count = 0;
+};
+
+CoroutineA a;
+
+void resetAll() {
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setMicros(0);
+  a.reset();
+  b.reset();
+  a.count = 0;
+  b.count = 0;
+  TestableCoroutineScheduler::setup();
+}
+
+test(BatchTest, runOnePass) {
+  resetAll();
+
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(1, a.count);
+  assertEqual(1, b.count);
+
+  // 'b' is resumed, but is still delaying.
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(2, a.count);
+  assertEqual(1, b.count);
+
+  // Finish the pass started by loop().
+  TestableCoroutineScheduler::loop();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(3, a.count);
+  assertEqual(1, b.count);
+}
+
+test(BatchTest, runUntilIdle) {
+  resetAll();
+
+  // 'a' is never idle, so maxRuns is reached.
+  assertEqual(10, TestableCoroutineScheduler::runUntilIdle(10));
+  assertEqual(5, a.count);
+  assertEqual(1, b.count);
+
+  // 'b' is delaying, so the scheduler is idle at the start of the next pass.
+  a.suspend();
+  assertEqual(0, TestableCoroutineScheduler::runUntilIdle(10));
+
+  // 'b' runs once after its delay expires.
+  TestableClockInterface::setMillis(10);
+  assertEqual(2, TestableCoroutineScheduler::runUntilIdle(10));
+  assertEqual(2, b.count);
+  assertEqual(5, a.count);
+}
+
+test(BatchTest, loopFor) {
+  resetAll();
+
+  // Each run of 'a' takes 10 micros.
+  TestableCoroutineScheduler::loopFor(100);
+  assertEqual(10, a.count);
+  assertEqual(1, b.count);
+
+  // At least one coroutine is run.
+  TestableCoroutineScheduler::loopFor(0);
+  assertEqual(10, a.count);
+  TestableCoroutineScheduler::loopFor(0);
+  assertEqual(11, a.count);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
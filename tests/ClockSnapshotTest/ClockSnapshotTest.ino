@@ -0,0 +1,207 @@
+#line 2 "ClockSnapshotTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+
+// ---------------------------------------------------------------------------
+
+// A TestableClockInterface which counts the number of times it is read.
+class CountingClock: public TestableClockInterface {
+  public:
+    static unsigned long millis() {
+      numMillis++;
+      return TestableClockInterface::millis();
+    }
+
+    static unsigned long micros() {
+      numMicros++;
+      return TestableClockInterface::micros();
+    }
+
+    static int numMillis;
+    static int numMicros;
+};
+
+int CountingClock::numMillis = 0;
+int CountingClock::numMicros = 0;
+
+using SnapshotClock = SnapshotClockInterface<CountingClock>;
+using SnapshotCoroutine = CoroutineTemplate<SnapshotClock>;
+using SnapshotScheduler = CoroutineSchedulerTemplate<SnapshotCoroutine>;
+
+// Create the coroutines in the reverse order to the order desired, because each
+// coroutine is inserted at the head of the singly-linked list.
+
+// Records the millis seen at the start of each run.
+class Recorder : public SnapshotCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        seen = SnapshotClock::millis();
+        COROUTINE_YIELD();
+      }
+    }
+
+    unsigned long seen = 0;
+};
+
+Recorder recorder;
+
+// Records the shortest delay measured by the underlying clock.
+class Sleeper : public SnapshotCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        start = TestableClockInterface::millis();
+        COROUTINE_DELAY(10);
+        elapsed = TestableClockInterface::millis() - start;
+        if (elapsed < minElapsed) minElapsed = elapsed;
+      }
+    }
+
+    int count = 0;
+    unsigned long start = 0;
+    unsigned long elapsed = 0;
+    unsigned long minElapsed = (unsigned long) -1;
+};
+
+Sleeper sleepers[4];
+
+bool uneven = false;
+
+// Advances the underlying clock by 5 millis on each run, or by a pseudo-random
+// 0 to 9 millis if 'uneven', after taking the snapshot of the current pass.
+class Ticker : public SnapshotCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        seed = seed * 1103515245 + 12345;
+        step = uneven ? (seed >> 16) % 10 : 5;
+        TestableClockInterface::setMillis(SnapshotClock::millis() + step);
+        COROUTINE_YIELD();
+      }
+    }
+
+    uint32_t seed = 1;
+    uint8_t step = 0;
+};
+
+Ticker ticker;
+
+void resetAll() {
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setMicros(0);
+  uneven = false;
+  ticker.reset();
+  ticker.seed = 1;
+  recorder.reset();
+  for (Sleeper& sleeper : sleepers) {
+    sleeper.reset();
+    sleeper.count = 0;
+    sleeper.minElapsed = (unsigned long) -1;
+  }
+  SnapshotScheduler::setup();
+  CountingClock::numMillis = 0;
+  CountingClock::numMicros = 0;
+}
+
+test(ClockSnapshotTest, readsClockOncePerPass) {
+  resetAll();
+
+  // In the first pass, the underlying clock is read by the ticker, and by
+  // each of the 4 sleepers to start its delay.
+  SnapshotScheduler::runOnePass();
+  assertEqual(5, CountingClock::numMillis);
+  assertEqual(0, CountingClock::numMicros);
+
+  // The ticker, 4 sleepers and the recorder all read millis() in the second
+  // pass, but the underlying clock is read only once.
+  SnapshotScheduler::runOnePass();
+  assertEqual(6, CountingClock::numMillis);
+}
+
+test(ClockSnapshotTest, frozenWithinPass) {
+  resetAll();
+
+  // The sleepers start their delays in the first pass, which reads the
+  // underlying clock.
+  SnapshotScheduler::runOnePass();
+  assertEqual(5UL, TestableClockInterface::millis());
+
+  // The ticker advances the clock before the recorder runs, but the recorder
+  // sees the value at the start of the pass.
+  SnapshotScheduler::runOnePass();
+  assertEqual(10UL, TestableClockInterface::millis());
+  assertEqual(5UL, recorder.seen);
+
+  SnapshotScheduler::runOnePass();
+  assertEqual(15UL, TestableClockInterface::millis());
+  assertEqual(10UL, recorder.seen);
+}
+
+test(ClockSnapshotTest, delayStartsFromLiveClock) {
+  resetAll();
+
+  // The ticker advances the clock from 0 to 5 millis before the sleepers run,
+  // so their 10 millis delay starts at 5, not at the snapshot of 0.
+  SnapshotScheduler::runOnePass();
+  assertEqual(1, sleepers[0].count);
+  assertEqual(5UL, sleepers[0].start);
+
+  // Snapshots at 5 and 10 millis.
+  SnapshotScheduler::runOnePass();
+  SnapshotScheduler::runOnePass();
+  assertEqual(1, sleepers[0].count);
+
+  // Snapshot at 15 millis, so the delay has expired.
+  SnapshotScheduler::runOnePass();
+  assertEqual(2, sleepers[0].count);
+}
+
+test(ClockSnapshotTest, delayNeverEarlyWithUnevenPasses) {
+  resetAll();
+  uneven = true;
+
+  for (int i = 0; i < 100; i++) {
+    SnapshotScheduler::runOnePass();
+  }
+
+  // Each sleeper resumed many times, and each delay measured by the
+  // underlying clock was at least 10 millis.
+  for (Sleeper& sleeper : sleepers) {
+    assertMoreOrEqual(sleeper.count, 10);
+    assertMoreOrEqual(sleeper.minElapsed, 10UL);
+  }
+}
+
+test(ClockSnapshotTest, loopForReadsMicrosPerCoroutine) {
+  resetAll();
+
+  // The budget is checked against a fresh micros() after each coroutine, so
+  // each call reads it once at the start and once after the coroutine.
+  SnapshotScheduler::loopFor(0);
+  assertEqual(2, CountingClock::numMicros);
+  SnapshotScheduler::loopFor(0);
+  assertEqual(4, CountingClock::numMicros);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
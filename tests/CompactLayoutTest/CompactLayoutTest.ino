@@ -0,0 +1,113 @@
+#line 2 "CompactLayoutTest.ino"
+
+// Use the compact layout. Must be defined before AceRoutine.h.
+#define ACE_ROUTINE_COMPACT 1
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Coroutine with 8-bit delay fields.
+using ShortDelayCoroutine = CoroutineTemplate<TestableClockInterface, uint8_t>;
+
+class ShortDelay : public ShortDelayCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY(100);
+        count++;
+        COROUTINE_DELAY(1000); // saturates at 127
+      }
+    }
+
+    int count = 0;
+};
+
+ShortDelay shortDelay;
+
+// Coroutine with the default 16-bit delay fields.
+class OneShot : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      COROUTINE_YIELD();
+      COROUTINE_DELAY(1000);
+      COROUTINE_END();
+    }
+};
+
+OneShot oneShot;
+
+test(CompactLayoutTest, states) {
+  TestableClockInterface::setMillis(0);
+  oneShot.reset();
+  assertTrue(oneShot.isYielding());
+
+  oneShot.runCoroutine();
+  assertTrue(oneShot.isYielding());
+  oneShot.runCoroutine();
+  assertTrue(oneShot.isDelaying());
+  assertEqual((uint32_t) 1000000, oneShot.getDelayRemainingMicros());
+
+  TestableClockInterface::setMillis(1000);
+  oneShot.runCoroutine();
+  assertTrue(oneShot.isEnding());
+  assertTrue(oneShot.isDone());
+
+  oneShot.suspend();
+  assertTrue(oneShot.isEnding());
+}
+
+test(CompactLayoutTest, shortDelay) {
+  TestableClockInterface::setMillis(0);
+  shortDelay.reset();
+  shortDelay.count = 0;
+
+  shortDelay.runCoroutine();
+  assertEqual(1, shortDelay.count);
+  assertEqual((uint32_t) 100000, shortDelay.getDelayRemainingMicros());
+
+  TestableClockInterface::setMillis(99);
+  shortDelay.runCoroutine();
+  assertEqual(1, shortDelay.count);
+
+  TestableClockInterface::setMillis(100);
+  shortDelay.runCoroutine();
+  assertEqual(2, shortDelay.count);
+  assertEqual((uint32_t) 127000, shortDelay.getDelayRemainingMicros());
+
+  // The 8-bit clock rolls over during the delay.
+  TestableClockInterface::setMillis(226);
+  shortDelay.runCoroutine();
+  assertEqual(2, shortDelay.count);
+
+  TestableClockInterface::setMillis(227);
+  shortDelay.runCoroutine();
+  assertEqual(3, shortDelay.count);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,128 @@
+#line 2 "CoroutinePoolTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Sum of the ids of the handlers which have finished.
+int finishedSum = 0;
+int numLive = 0;
+
+// Yields 'steps' times, then ends.
+class Handler : public TestableCoroutine {
+  public:
+    Handler(int id, int steps) : mId(id), mSteps(steps) { numLive++; }
+
+    ~Handler() { numLive--; }
+
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (mCount = 0; mCount < mSteps; mCount++) {
+        COROUTINE_YIELD();
+      }
+      finishedSum += mId;
+      COROUTINE_END();
+    }
+
+    int id() const { return mId; }
+
+  private:
+    int mId;
+    int mSteps;
+    int mCount = 0;
+};
+
+CoroutinePool<Handler, 3> pool;
+
+// Run the scheduler until the pool is full again, up to maxLoops.
+void runUntilFree(int maxLoops) {
+  for (int i = 0; i < maxLoops && pool.available() < pool.capacity(); i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+test(CoroutinePoolTest, spawnAndRecycle) {
+  assertEqual(3, pool.available());
+
+  Handler* h1 = pool.spawn(1, 1);
+  Handler* h2 = pool.spawn(2, 2);
+  Handler* h3 = pool.spawn(3, 3);
+  assertTrue(h1 != nullptr);
+  assertTrue(h2 != nullptr);
+  assertTrue(h3 != nullptr);
+  assertEqual(1, h1->id());
+  assertEqual(0, pool.available());
+  assertEqual(3, numLive);
+
+  // The pool is exhausted.
+  assertTrue(pool.spawn(4, 1) == nullptr);
+
+  runUntilFree(100);
+  assertEqual(3, pool.available());
+  assertEqual(6, finishedSum);
+  assertEqual(0, numLive);
+
+  // The slots are reused.
+  Handler* h4 = pool.spawn(4, 0);
+  assertTrue(h4 == h3 || h4 == h2 || h4 == h1);
+  runUntilFree(100);
+  assertEqual(10, finishedSum);
+  assertEqual(3, pool.available());
+}
+
+// Spawns a handler from inside a coroutine.
+class Spawner : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT(enabled && pool.available() > 0);
+        pool.spawn(100, 1);
+        spawned++;
+      }
+    }
+
+    bool enabled = false;
+    int spawned = 0;
+};
+
+Spawner spawner;
+
+test(CoroutinePoolTest, spawnFromCoroutine) {
+  finishedSum = 0;
+  spawner.enabled = true;
+  for (int i = 0; i < 100; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+  spawner.enabled = false;
+  runUntilFree(100);
+
+  assertMore(spawner.spawned, 3);
+  assertEqual(spawner.spawned * 100, finishedSum);
+  assertEqual(3, pool.available());
+  assertEqual(0, numLive);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,128 @@
+#line 2 "CrtpTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+
+using TestScheduler = CoroutineCrtpSchedulerTemplate<TestableClockInterface>;
+
+// ---------------------------------------------------------------------------
+
+// Create the coroutines in the reverse order to the order desired, because each
+// coroutine is inserted at the head of the singly-linked list.
+
+// Counts to 3, then terminates.
+class Finite : public CoroutineCrtp<Finite, TestableClockInterface> {
+  public:
+    int runCoroutine() {
+      COROUTINE_BEGIN();
+      for (count = 0; count < 3; count++) {
+        COROUTINE_YIELD();
+      }
+      COROUTINE_END();
+    }
+
+    int count = 0;
+};
+
+Finite finiteCoroutine;
+
+class Blinker : public CoroutineCrtp<Blinker, TestableClockInterface> {
+  public:
+    int runCoroutine() {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY(10);
+      }
+    }
+
+    int count = 0;
+};
+
+Blinker blinker;
+
+void resetAll() {
+  TestableClockInterface::setMillis(0);
+  blinker.reset();
+  finiteCoroutine.reset();
+  blinker.count = 0;
+  TestScheduler::setup();
+}
+
+test(CrtpTest, size) {
+  // The thunk pointer replaces the vtable pointer of a Coroutine, and there is
+  // no mPrev pointer or mPriority.
+  assertTrue(sizeof(CoroutineCrtpBaseTemplate<ClockInterface>)
+      < sizeof(Coroutine));
+}
+
+test(CrtpTest, delay) {
+  resetAll();
+
+  TestScheduler::runOnePass();
+  assertEqual(1, blinker.count);
+  assertTrue(blinker.isDelaying());
+
+  TestableClockInterface::setMillis(9);
+  TestScheduler::runOnePass();
+  assertEqual(1, blinker.count);
+
+  TestableClockInterface::setMillis(10);
+  TestScheduler::runOnePass();
+  assertEqual(2, blinker.count);
+}
+
+test(CrtpTest, endAndReset) {
+  resetAll();
+
+  for (int i = 0; i < 4; i++) {
+    TestScheduler::runOnePass();
+  }
+  assertTrue(finiteCoroutine.isEnding());
+
+  // Terminated and removed from the list.
+  TestScheduler::runOnePass();
+  assertTrue(finiteCoroutine.isTerminated());
+  TestScheduler::runOnePass();
+  assertTrue(finiteCoroutine.isTerminated());
+
+  // Inserted back into the list, and run from the beginning.
+  finiteCoroutine.reset();
+  finiteCoroutine.count = 10;
+  TestScheduler::setup();
+  TestScheduler::runOnePass();
+  assertEqual(0, finiteCoroutine.count);
+  assertTrue(finiteCoroutine.isYielding());
+}
+
+test(CrtpTest, suspendAndResume) {
+  resetAll();
+
+  blinker.suspend();
+  TestScheduler::runOnePass();
+  assertEqual(0, blinker.count);
+  assertTrue(blinker.isSuspended());
+
+  blinker.resume();
+  TestScheduler::runOnePass();
+  assertEqual(1, blinker.count);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,174 @@
+#line 2 "CyclicExecutiveTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+
+// ---------------------------------------------------------------------------
+
+using TestableStaticCoroutine = StaticCoroutineTemplate<TestableClockInterface>;
+
+// Records the order in which the coroutines run.
+char trace[32];
+uint8_t traceLength = 0;
+
+void record(char c) {
+  if (traceLength < sizeof(trace) - 1) {
+    trace[traceLength++] = c;
+    trace[traceLength] = '\0';
+  }
+}
+
+void clearTrace() {
+  traceLength = 0;
+  trace[0] = '\0';
+}
+
+template <char NAME>
+class Recorder : public TestableStaticCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        record(NAME);
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+using A = Recorder<'a'>;
+using B = Recorder<'b'>;
+using C = Recorder<'c'>;
+
+// Frames of 10 ms. 'a' every 10 ms, 'b' every 20 ms, 'c' every 40 ms in the
+// second frame. The hyperperiod is 40 ms, in 4 frames: ab, ac, ab, a.
+using TestScheduler = CyclicExecutiveSchedulerTemplate<
+    TestableClockInterface, 10,
+    CyclicTask<A, 10>,
+    CyclicTask<B, 20>,
+    CyclicTask<C, 40, 10>>;
+
+void resetAll() {
+  TestableClockInterface::setMillis(0);
+  TestScheduler::get<A>().reset();
+  TestScheduler::get<B>().reset();
+  TestScheduler::get<C>().reset();
+  TestScheduler::setup();
+  clearTrace();
+}
+
+test(CyclicExecutiveTest, table) {
+  assertEqual((uint32_t) 40, (uint32_t) TestScheduler::kHyperperiodMillis);
+  assertEqual((uint32_t) 4, (uint32_t) TestScheduler::kNumFrames);
+  assertEqual((size_t) 1, sizeof(TestScheduler::Mask));
+
+  assertEqual(0x3, TestScheduler::getFrameMask(0));
+  assertEqual(0x5, TestScheduler::getFrameMask(1));
+  assertEqual(0x3, TestScheduler::getFrameMask(2));
+  assertEqual(0x1, TestScheduler::getFrameMask(3));
+}
+
+test(CyclicExecutiveTest, frameTiming) {
+  resetAll();
+
+  // The first frame runs immediately.
+  TestScheduler::loop();
+  assertEqual("ab", trace);
+  assertEqual(1, TestScheduler::getFrame());
+
+  // Nothing runs until the start of the next frame.
+  TestableClockInterface::setMillis(9);
+  TestScheduler::loop();
+  assertEqual("ab", trace);
+
+  TestableClockInterface::setMillis(10);
+  TestScheduler::loop();
+  TestScheduler::loop();
+  assertEqual("abac", trace);
+
+  // A frame started a few millis late keeps the frame boundaries.
+  TestableClockInterface::setMillis(23);
+  TestScheduler::loop();
+  TestableClockInterface::setMillis(29);
+  TestScheduler::loop();
+  assertEqual("abacab", trace);
+
+  // The hyperperiod wraps around to the first frame.
+  TestableClockInterface::setMillis(30);
+  TestScheduler::loop();
+  TestableClockInterface::setMillis(40);
+  TestScheduler::loop();
+  assertEqual("abacabaab", trace);
+  assertEqual(1, TestScheduler::getFrame());
+  assertEqual(0, TestScheduler::getNumOverruns());
+}
+
+test(CyclicExecutiveTest, overrun) {
+  resetAll();
+
+  TestScheduler::loop();
+  assertEqual("ab", trace);
+
+  // The second frame is 15 ms late, so it is skipped, and the third frame,
+  // which started at 20 ms, runs instead.
+  TestableClockInterface::setMillis(25);
+  TestScheduler::loop();
+  assertEqual("abab", trace);
+  assertEqual(1, TestScheduler::getNumOverruns());
+  assertEqual(3, TestScheduler::getFrame());
+
+  // The fourth frame keeps its phase at 30 ms.
+  TestableClockInterface::setMillis(29);
+  TestScheduler::loop();
+  assertEqual("abab", trace);
+  TestableClockInterface::setMillis(30);
+  TestScheduler::loop();
+  assertEqual("ababa", trace);
+  assertEqual(1, TestScheduler::getNumOverruns());
+
+  // A gap of several hyperperiods lands on the frame of the current time,
+  // 170 ms = 4 * 40 ms + 10 ms, which is the second frame.
+  clearTrace();
+  TestableClockInterface::setMillis(175);
+  TestScheduler::loop();
+  assertEqual("ac", trace);
+  assertEqual(2, TestScheduler::getNumOverruns());
+  assertEqual(2, TestScheduler::getFrame());
+  TestableClockInterface::setMillis(180);
+  TestScheduler::loop();
+  assertEqual("acab", trace);
+}
+
+test(CyclicExecutiveTest, suspend) {
+  resetAll();
+
+  TestScheduler::get<B>().suspend();
+  TestScheduler::loop();
+  assertEqual("a", trace);
+
+  TestScheduler::get<B>().resume();
+  TestableClockInterface::setMillis(10);
+  TestScheduler::loop(); // frame 1
+  TestScheduler::loop(); // frame 2 is not due yet
+  TestableClockInterface::setMillis(20);
+  TestScheduler::loop();
+  assertEqual("aacab", trace);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
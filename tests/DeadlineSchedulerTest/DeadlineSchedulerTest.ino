@@ -0,0 +1,173 @@
+#line 2 "DeadlineSchedulerTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+
+using TestableDeadlineScheduler =
+    CoroutineDeadlineSchedulerTemplate<TestableCoroutine, 2>;
+
+// ---------------------------------------------------------------------------
+
+// Create the coroutines in the reverse order to the order desired, because each
+// coroutine is inserted at the head of the singly-linked list.
+
+// Polled because its delay is in micros.
+class CoroutineD : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY_MICROS(10);
+      }
+    }
+
+    int count = 0;
+};
+
+CoroutineD d;
+
+// Never delays, so it always stays in the linked list.
+class CoroutineC : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_YIELD();
+      }
+    }
+
+    int count = 0;
+};
+
+CoroutineC c;
+
+class CoroutineB : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY(5);
+      }
+    }
+
+    int count = 0;
+};
+
+CoroutineB b;
+
+class CoroutineA : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      count++;
+      COROUTINE_DELAY(20);
+      count++;
+      COROUTINE_END();
+    }
+
+    void recycleCoroutine() override { recycled++; }
+
+    int count = 0;
+    int recycled = 0;
+};
+
+CoroutineA a;
+
+test(DeadlineSchedulerTest, sleepersAreNotResumed) {
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setMicros(0);
+
+  // First pass: a and b go to sleep and leave the linked list.
+  TestableDeadlineScheduler::loop(); // a
+  assertTrue(a.isDelaying());
+  assertEqual(1, a.count);
+  TestableDeadlineScheduler::loop(); // b
+  assertTrue(b.isDelaying());
+  assertEqual(1, b.count);
+  TestableDeadlineScheduler::loop(); // c
+  assertEqual(1, c.count);
+  TestableDeadlineScheduler::loop(); // d
+  assertEqual(1, d.count);
+
+  // Only c and d remain in the linked list, and d is polled.
+  TestableDeadlineScheduler::loop(); // c
+  TestableDeadlineScheduler::loop(); // d
+  TestableDeadlineScheduler::loop(); // c
+  TestableDeadlineScheduler::loop(); // d
+  assertEqual(3, c.count);
+  assertEqual(1, d.count);
+  assertEqual(1, a.count);
+  assertEqual(1, b.count);
+
+  // b wakes up first and runs immediately, ahead of c.
+  TestableClockInterface::setMillis(5);
+  TestableDeadlineScheduler::loop();
+  assertEqual(2, b.count);
+  assertEqual(3, c.count);
+  assertTrue(b.isDelaying());
+
+  // b is back in the heap, the linked list continues with c.
+  TestableDeadlineScheduler::loop();
+  assertEqual(4, c.count);
+  assertEqual(2, b.count);
+
+  // a wakes up at 20, b is due at 10 and 20 as well.
+  TestableClockInterface::setMillis(20);
+  TestableDeadlineScheduler::loop();
+  TestableDeadlineScheduler::loop();
+  assertEqual(3, b.count);
+  assertEqual(2, a.count);
+  assertTrue(a.isEnding());
+
+  // a is terminated and recycled on the next pass, and leaves the list.
+  for (int i = 0; i < 4; i++) {
+    TestableDeadlineScheduler::loop();
+  }
+  assertTrue(a.isTerminated());
+  assertEqual(1, a.recycled);
+  for (int i = 0; i < 4; i++) {
+    TestableDeadlineScheduler::loop();
+  }
+  assertEqual(1, a.recycled);
+}
+
+test(DeadlineSchedulerTest, suspendedLeavesList) {
+  // c is moved out of the linked list when the scheduler reaches it.
+  c.suspend();
+  int count = c.count;
+  for (int i = 0; i < 4; i++) {
+    TestableDeadlineScheduler::loop();
+  }
+  assertEqual(count, c.count);
+
+  // resume() inserts it back at the root.
+  c.resume();
+  for (int i = 0; i < 4; i++) {
+    TestableDeadlineScheduler::loop();
+  }
+  assertMore(c.count, count);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableDeadlineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,224 @@
+#line 2 "DependencyTest.ino"
+
+// Required by setDependencies(). Must be defined before AceRoutine.h.
+#define ACE_ROUTINE_DEPENDENCIES 1
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+using Dependency = TestableCoroutineScheduler::Dependency;
+using TestChannel = Channel<int, TestableCoroutine>;
+
+// ---------------------------------------------------------------------------
+// A chain of 3 stages connected by Channels. The stages are created from the
+// source to the sink, so that the linked list visits the sink first.
+// ---------------------------------------------------------------------------
+
+class Source : public TestableCoroutine {
+  public:
+    explicit Source(TestChannel& out) : mOut(out) {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_CHANNEL_WRITE(mOut, next);
+        next++;
+      }
+    }
+
+    int next = 1;
+
+  private:
+    TestChannel& mOut;
+};
+
+class Filter : public TestableCoroutine {
+  public:
+    Filter(TestChannel& in, TestChannel& out) : mIn(in), mOut(out) {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_CHANNEL_READ(mIn, mValue);
+        mValue *= 10;
+        COROUTINE_CHANNEL_WRITE(mOut, mValue);
+      }
+    }
+
+  private:
+    TestChannel& mIn;
+    TestChannel& mOut;
+    int mValue = 0;
+};
+
+class Sink : public TestableCoroutine {
+  public:
+    explicit Sink(TestChannel& in) : mIn(in) {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_CHANNEL_READ(mIn, value);
+        count++;
+      }
+    }
+
+    int value = 0;
+    int count = 0;
+
+  private:
+    TestChannel& mIn;
+};
+
+struct Pipeline {
+  TestChannel sourceToFilter;
+  TestChannel filterToSink;
+  Source source{sourceToFilter};
+  Filter filter{sourceToFilter, filterToSink};
+  Sink sink{filterToSink};
+};
+
+Pipeline unranked;
+Pipeline ranked;
+
+// ---------------------------------------------------------------------------
+// Coroutines which record the order in which they run.
+// ---------------------------------------------------------------------------
+
+char trace[16];
+uint8_t traceLength = 0;
+
+void resetTrace() {
+  traceLength = 0;
+  trace[0] = '\0';
+}
+
+class Tracer : public TestableCoroutine {
+  public:
+    explicit Tracer(char id) : mId(id) {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        if (traceLength < sizeof(trace) - 1) {
+          trace[traceLength++] = mId;
+          trace[traceLength] = '\0';
+        }
+        COROUTINE_YIELD();
+      }
+    }
+
+  private:
+    char mId;
+};
+
+Tracer a('a');
+Tracer b('b');
+Tracer c('c');
+Tracer d('d');
+
+// ---------------------------------------------------------------------------
+
+test(DependencyTest, channelPipeline) {
+  TestableCoroutineScheduler::setup();
+  const Dependency dependencies[] = {
+    {&ranked.source, &ranked.filter},
+    {&ranked.filter, &ranked.sink},
+  };
+  assertTrue(TestableCoroutineScheduler::setDependencies(dependencies, 2));
+  assertEqual(0, ranked.source.getRank());
+  assertEqual(1, ranked.filter.getRank());
+  assertEqual(2, ranked.sink.getRank());
+  assertEqual(0, unranked.sink.getRank());
+
+  // The Channel handshake takes 2 passes per value, but once the source
+  // writes a value, the ranked filter and sink are woken up later in the
+  // same pass. The unranked sink runs before its producers, so each stage
+  // adds another pass.
+  for (int pass = 1; pass <= 20; pass++) {
+    TestableCoroutineScheduler::runOnePass();
+    assertEqual(pass / 2, ranked.sink.count);
+    assertEqual((pass + 1) / 4, unranked.sink.count);
+  }
+  assertEqual(100, ranked.sink.value);
+  assertEqual(50, unranked.sink.value);
+}
+
+test(DependencyTest, cycle) {
+  const Dependency dependencies[] = {
+    {&a, &b},
+    {&b, &c},
+    {&c, &a},
+  };
+  assertFalse(TestableCoroutineScheduler::setDependencies(dependencies, 3));
+  assertEqual(0, a.getRank());
+  assertEqual(0, b.getRank());
+  assertEqual(0, c.getRank());
+}
+
+test(DependencyTest, order) {
+  // The linked list starts as 'd', 'c', 'b', 'a'.
+  const Dependency dependencies[] = {
+    {&b, &c},
+    {&a, &b},
+  };
+  assertTrue(TestableCoroutineScheduler::setDependencies(dependencies, 2));
+  assertEqual(0, a.getRank());
+  assertEqual(1, b.getRank());
+  assertEqual(2, c.getRank());
+  assertEqual(0, d.getRank());
+
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual("dabc", trace);
+}
+
+test(DependencyTest, resume) {
+  const Dependency dependencies[] = {
+    {&a, &b},
+    {&b, &c},
+  };
+  assertTrue(TestableCoroutineScheduler::setDependencies(dependencies, 2));
+
+  // The scheduler moves 'b' out of the linked list.
+  b.suspend();
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual("dac", trace);
+
+  // 'b' goes back after 'a', instead of at the root.
+  b.resume();
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual("dabc", trace);
+
+  // 'c' goes back at the end of the linked list, after the end of the
+  // previous pass, so it runs once before the next pass starts.
+  c.suspend();
+  TestableCoroutineScheduler::runOnePass();
+  c.reset();
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual("c", trace);
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual("dabc", trace);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
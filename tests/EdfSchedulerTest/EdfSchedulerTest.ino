@@ -0,0 +1,222 @@
+#line 2 "EdfSchedulerTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+using TestScheduler = CoroutineEdfSchedulerTemplate<TestableCoroutine, 4>;
+
+// ---------------------------------------------------------------------------
+
+// Record of the coroutines which ran, one letter per run.
+char runs[16];
+uint8_t numRuns = 0;
+
+void record(char name) {
+  if (numRuns < sizeof(runs) - 1) {
+    runs[numRuns++] = name;
+    runs[numRuns] = '\0';
+  }
+}
+
+// Runs one job per call. Each job takes 'cost' millis of the testable clock.
+// If 'last' is set, the job ends the coroutine.
+class Job : public TestableCoroutine {
+  public:
+    Job(char name) : name(name) {}
+
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      while (true) {
+        record(name);
+        TestableClockInterface::setMillis(
+            TestableClockInterface::millis() + cost);
+        if (last) break;
+        COROUTINE_YIELD();
+      }
+      COROUTINE_END();
+    }
+
+    char name;
+    uint16_t cost = 0;
+    bool last = false;
+};
+
+Job a('a');
+Job b('b');
+Job c('c');
+
+// Runs only when no periodic job is released.
+class Background : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        record('-');
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+Background background;
+
+TestableCoroutine* missed = nullptr;
+
+void missHook(TestableCoroutine* coroutine) {
+  missed = coroutine;
+}
+
+void resetAll() {
+  TestableClockInterface::setMillis(0);
+  TestScheduler::remove(&a);
+  TestScheduler::remove(&b);
+  TestScheduler::remove(&c);
+  a.reset();
+  b.reset();
+  c.reset();
+  a.cost = b.cost = c.cost = 0;
+  a.last = b.last = c.last = false;
+  runs[0] = '\0';
+  numRuns = 0;
+  missed = nullptr;
+  TestScheduler::setMissHook(nullptr);
+}
+
+// Admit the 3 jobs, so that only the background coroutine is left in the
+// linked list.
+void admitAll(uint16_t periodA, uint16_t periodB, uint16_t periodC) {
+  resetAll();
+  TestScheduler::admit(&a, periodA);
+  TestScheduler::admit(&b, periodB);
+  TestScheduler::admit(&c, periodC);
+  TestScheduler::setup();
+}
+
+test(EdfSchedulerTest, admission) {
+  resetAll();
+
+  // Invalid periods and WCET.
+  assertFalse(TestScheduler::admit(&a, 0));
+  assertFalse(TestScheduler::admit(&a, 10, 10001));
+
+  // 50% + 40% + 10% = 100%.
+  assertTrue(TestScheduler::admit(&a, 10, 5000));
+  assertTrue(TestScheduler::admit(&b, 20, 8000));
+  assertEqual((uint32_t) 900000, TestScheduler::getUtilization());
+  assertFalse(TestScheduler::admit(&c, 10, 2000));
+  assertFalse(TestScheduler::admit(&a, 100, 0));
+  assertTrue(TestScheduler::admit(&c, 100, 10000));
+  assertEqual((uint32_t) TestScheduler::kMaxUtilization,
+      TestScheduler::getUtilization());
+
+  TestScheduler::remove(&b);
+  assertEqual((uint32_t) 600000, TestScheduler::getUtilization());
+}
+
+test(EdfSchedulerTest, earliestDeadlineFirst) {
+  // All released at 0, with deadlines at 10, 4 and 30.
+  admitAll(10, 4, 30);
+  TestScheduler::loop(); // b
+  TestScheduler::loop(); // a
+  TestScheduler::loop(); // c
+  TestScheduler::loop(); // background
+  assertEqual("bac-", runs);
+
+  // At 4, 'b' is released again. At 10, 'b' has been released at 8 with a
+  // deadline of 12, and 'a' at 10 with a deadline of 20.
+  TestableClockInterface::setMillis(4);
+  TestScheduler::loop();
+  TestableClockInterface::setMillis(10);
+  TestScheduler::loop();
+  TestScheduler::loop();
+  TestScheduler::loop();
+  assertEqual("bac-bba-", runs);
+  assertEqual((uint32_t) 0, TestScheduler::getNumDeadlineMisses());
+
+  // A suspended coroutine is skipped, then released by resume().
+  b.suspend();
+  TestableClockInterface::setMillis(13);
+  TestScheduler::loop();
+  b.resume();
+  TestScheduler::loop();
+  assertEqual("bac-bba--b", runs);
+}
+
+test(EdfSchedulerTest, deadlineMiss) {
+  admitAll(10, 100, 100);
+  TestScheduler::setMissHook(missHook);
+  uint32_t numMisses = TestScheduler::getNumDeadlineMisses();
+
+  // The job of 'a' takes 12 millis, past its deadline at 10.
+  a.cost = 12;
+  TestScheduler::loop();
+  assertEqual(numMisses + 1, TestScheduler::getNumDeadlineMisses());
+  assertEqual(1, TestScheduler::getNumDeadlineMisses(&a));
+  assertTrue(missed == &a);
+
+  // The next job of 'a' was released at 10, with a deadline of 20.
+  a.cost = 0;
+  TestScheduler::loop(); // a
+  TestScheduler::loop(); // b
+  TestScheduler::loop(); // c
+  assertEqual("aabc", runs);
+  assertEqual(1, TestScheduler::getNumDeadlineMisses(&a));
+
+  // The job released at 20 runs at 45. The jobs which would have been
+  // released at 30 and 40 are skipped, and the next one is released at 45.
+  TestableClockInterface::setMillis(45);
+  TestScheduler::loop();
+  assertEqual(2, TestScheduler::getNumDeadlineMisses(&a));
+  TestScheduler::loop();
+  TestScheduler::loop();
+  assertEqual("aabcaa-", runs);
+  assertEqual(2, TestScheduler::getNumDeadlineMisses(&a));
+  assertEqual(0, TestScheduler::getNumDeadlineMisses(&b));
+}
+
+test(EdfSchedulerTest, end) {
+  admitAll(10, 20, 5);
+  TestScheduler::remove(&c);
+  assertTrue(TestScheduler::admit(&c, 5, 1000));
+  assertEqual((uint32_t) 200000, TestScheduler::getUtilization());
+
+  // An ending job terminates the coroutine, and frees its utilization.
+  c.last = true;
+  TestScheduler::loop();
+  assertTrue(c.isTerminated());
+  assertEqual((uint32_t) 0, TestScheduler::getUtilization());
+
+  // A reset() puts it back into the linked list, as a normal coroutine.
+  c.reset();
+  c.last = false;
+  TestScheduler::loop(); // a
+  TestScheduler::loop(); // b
+  TestScheduler::loop(); // background or c
+  TestScheduler::loop(); // c or background
+  assertEqual(5, numRuns);
+  assertEqual('c', runs[0]);
+  assertEqual('a', runs[1]);
+  assertEqual('b', runs[2]);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,139 @@
+#line 2 "HighResClockTest.ino"
+
+#include <AceRoutine.h>
+#include <ace_routine/HighResClockInterface.h>
+#include <AUnitVerbose.h>
+
+using namespace aunit;
+using namespace ace_routine;
+
+#if defined(EPOXY_DUINO)
+
+using MonotonicCoroutine = CoroutineTemplate<MonotonicClockInterface, uint64_t>;
+using MonotonicScheduler = CoroutineSchedulerTemplate<MonotonicCoroutine>;
+
+// Delays 1500 micros, then a delay which does not fit in 32 bits.
+class DelayCoroutine : public MonotonicCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      COROUTINE_DELAY_MICROS(1500);
+      count++;
+      COROUTINE_DELAY(5000000000ULL);
+      count++;
+      COROUTINE_END();
+    }
+
+    using MonotonicCoroutine::getDelayDeadline;
+
+    int count = 0;
+};
+
+DelayCoroutine delayer;
+
+// A 32-bit T_DELAY holds nanos delays of up to 2.1 seconds. Also puts the
+// coroutine into a separate linked list.
+using NanosCoroutine = CoroutineTemplate<MonotonicClockInterface, uint32_t>;
+using NanosScheduler = CoroutineSchedulerTemplate<NanosCoroutine>;
+
+// Delays 300000 nanos, recording the elapsed time.
+class NanosDelayCoroutine : public NanosCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      start = MonotonicClockInterface::nanos();
+      COROUTINE_DELAY_NANOS(300000);
+      elapsed = MonotonicClockInterface::nanos() - start;
+      COROUTINE_END();
+    }
+
+    uint64_t start = 0;
+    uint64_t elapsed = 0;
+};
+
+NanosDelayCoroutine nanosDelayer;
+
+test(HighResClockTest, monotonicClock) {
+  uint64_t startNanos = MonotonicClockInterface::nanos();
+  uint64_t startMicros = MonotonicClockInterface::micros();
+  delay(2);
+  uint64_t elapsedNanos = MonotonicClockInterface::nanos() - startNanos;
+  uint64_t elapsedMicros = MonotonicClockInterface::micros() - startMicros;
+
+  assertMoreOrEqual(elapsedNanos, (uint64_t) 2000000);
+  assertMoreOrEqual(elapsedMicros, (uint64_t) 2000);
+  assertLessOrEqual(elapsedMicros, elapsedNanos / 1000 + 1);
+  assertLessOrEqual(MonotonicClockInterface::millis(),
+      MonotonicClockInterface::micros() / 1000);
+}
+
+test(HighResClockTest, monotonicDelay) {
+  MonotonicScheduler::setup();
+  uint64_t start = MonotonicClockInterface::nanos();
+  while (delayer.count == 0) {
+    MonotonicScheduler::loop();
+  }
+  // micros() truncates nanos() / 1000, so the delay, which starts from
+  // micros(), can begin up to 1 micro before the sampled start.
+  assertMoreOrEqual(MonotonicClockInterface::nanos() - start,
+      (uint64_t) 1500000 - 1000);
+
+  // The 64-bit delay of 5000000000 millis is not truncated.
+  MonotonicScheduler::loop();
+  assertTrue(delayer.isDelaying());
+  uint64_t remaining =
+      delayer.getDelayDeadline() - MonotonicClockInterface::millis();
+  assertMoreOrEqual(remaining, (uint64_t) 4999999000ULL);
+  assertLessOrEqual(remaining, (uint64_t) 5000000000ULL);
+  assertEqual((uint32_t) 0xFFFFFFFF, delayer.getDelayRemainingMicros());
+  MonotonicScheduler::loop();
+  assertEqual(1, delayer.count);
+}
+
+test(HighResClockTest, monotonicDelayNanos) {
+  NanosScheduler::setup();
+  NanosScheduler::loop();
+  assertTrue(nanosDelayer.isDelaying());
+  assertLessOrEqual(nanosDelayer.getDelayRemainingMicros(), (uint32_t) 300);
+
+  while (! nanosDelayer.isDone()) {
+    NanosScheduler::loop();
+  }
+  assertMoreOrEqual(nanosDelayer.elapsed, (uint64_t) 300000);
+}
+
+test(HighResClockTest, cycleClock) {
+  CycleClockInterface::begin();
+  assertMore(CycleClockInterface::getCyclesPerMicro(), (uint32_t) 0);
+
+  uint64_t startNanos = CycleClockInterface::nanos();
+  uint64_t startMicros = CycleClockInterface::micros();
+  unsigned long start = micros();
+  delay(10);
+  uint64_t elapsedMicros = CycleClockInterface::micros() - startMicros;
+  uint64_t elapsedNanos = CycleClockInterface::nanos() - startNanos;
+  unsigned long elapsed = micros() - start;
+
+  // Within 10% of the Arduino micros().
+  assertMoreOrEqual(elapsedMicros, (uint64_t) (elapsed - elapsed / 10));
+  assertLessOrEqual(elapsedMicros, (uint64_t) (elapsed + elapsed / 10));
+  assertMoreOrEqual(elapsedNanos / 1000, elapsedMicros - 1);
+  assertLessOrEqual(elapsedNanos / 1000, elapsedMicros + 1);
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,80 @@
+#line 2 "LongDelayTest.ino"
+
+// Use 32-bit delay fields. Must be defined before AceRoutine.h.
+#define ACE_ROUTINE_DELAY_BITS 32
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Delays longer than the 32767 limit of the 16-bit delay fields.
+class LongDelay : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY(100000);
+        count++;
+        COROUTINE_DELAY_MICROS(100000);
+      }
+    }
+
+    int count = 0;
+};
+
+LongDelay longDelay;
+
+test(LongDelayTest, longDelays) {
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setMicros(0);
+  longDelay.reset();
+  TestableCoroutineScheduler::setup();
+
+  TestableCoroutineScheduler::loop();
+  assertEqual(1, longDelay.count);
+  assertTrue(longDelay.isDelaying());
+  assertEqual((uint32_t) 100000000,
+      longDelay.getDelayRemainingMicros());
+
+  // Still delaying after the 16-bit limit.
+  TestableClockInterface::setMillis(99999);
+  TestableCoroutineScheduler::loop();
+  assertEqual(1, longDelay.count);
+
+  TestableClockInterface::setMillis(100000);
+  TestableCoroutineScheduler::loop();
+  assertEqual(2, longDelay.count);
+
+  TestableClockInterface::setMicros(99999);
+  TestableCoroutineScheduler::loop();
+  assertEqual(2, longDelay.count);
+
+  TestableClockInterface::setMicros(100000);
+  TestableCoroutineScheduler::loop();
+  assertEqual(3, longDelay.count);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,228 @@
+#line 2 "PartitionTest.ino"
+
+// Required by CoroutinePartition::add(). Must be defined before AceRoutine.h.
+#define ACE_ROUTINE_PARTITIONS 1
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+using TestPartition = CoroutinePartitionTemplate<TestableCoroutine>;
+
+char trace[32];
+uint8_t traceLength = 0;
+
+void resetTrace() {
+  traceLength = 0;
+  trace[0] = '\0';
+}
+
+// Records its id in the trace, and advances the micros clock by stepMicros,
+// on each iteration.
+class Tracer : public TestableCoroutine {
+  public:
+    Tracer(char id, uint32_t stepMicros = 0) :
+        mId(id),
+        mStepMicros(stepMicros)
+    {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        if (traceLength < sizeof(trace) - 1) {
+          trace[traceLength++] = mId;
+          trace[traceLength] = '\0';
+        }
+        TestableClockInterface::setMicros(
+            TestableClockInterface::micros() + mStepMicros);
+        COROUTINE_YIELD();
+      }
+    }
+
+  private:
+    char mId;
+    uint32_t mStepMicros;
+};
+
+// Waits on a WaitQueue until 'ready' is set.
+WaitQueueTemplate<TestableCoroutine> queue;
+bool ready = false;
+
+class Waiter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT_ON(queue, ready);
+        ready = false;
+        if (traceLength < sizeof(trace) - 1) {
+          trace[traceLength++] = 'w';
+          trace[traceLength] = '\0';
+        }
+      }
+    }
+};
+
+// Run every 10 millis.
+TestPartition slow(10);
+Tracer slowTracer('s');
+Waiter waiter;
+
+// Run at most 20 micros per pass.
+TestPartition budgeted(0, 20);
+Tracer x('x', 10);
+Tracer y('y', 10);
+Tracer z('z', 10);
+
+// A partition inside a partition.
+TestPartition outer;
+TestPartition inner;
+Tracer nestedTracer('n');
+
+// Run by the global scheduler.
+Tracer fastTracer('f');
+
+void resetAll() {
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setMicros(0);
+  TestableCoroutineScheduler::setup();
+  slow.reset();
+  resetTrace();
+}
+
+// Return the number of times that id appears in the trace.
+uint8_t countOf(char id) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < traceLength; i++) {
+    if (trace[i] == id) count++;
+  }
+  return count;
+}
+
+test(PartitionTest, budget) {
+  resetAll();
+
+  // Finish the current pass of the partition.
+  budgeted.runOnePass();
+
+  // Each coroutine takes 10 micros, so a pass of the 3 coroutines is split
+  // across 2 runs of the partition.
+  resetTrace();
+  budgeted.runCoroutine();
+  assertEqual("zy", trace);
+
+  resetTrace();
+  budgeted.runCoroutine();
+  assertEqual("x", trace);
+
+  resetTrace();
+  budgeted.runCoroutine();
+  assertEqual("zy", trace);
+}
+
+test(PartitionTest, nested) {
+  resetAll();
+
+  // 'nestedTracer' runs once per pass, through 'outer' and 'inner' only.
+  for (int i = 0; i < 3; i++) {
+    resetTrace();
+    TestableCoroutineScheduler::runOnePass();
+    assertEqual(1, countOf('n'));
+    assertEqual(1, countOf('f'));
+  }
+}
+
+test(PartitionTest, period) {
+  resetAll();
+
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(1, countOf('s'));
+
+  // 'slow' is delaying, while 'fastTracer' runs on every pass.
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(0, countOf('s'));
+  assertEqual(2, countOf('f'));
+
+  TestableClockInterface::setMillis(10);
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(1, countOf('s'));
+}
+
+test(PartitionTest, suspendAndResume) {
+  resetAll();
+  TestableCoroutineScheduler::runOnePass();
+
+  // The scheduler of 'slow' moves 'slowTracer' out of its linked list.
+  slowTracer.suspend();
+  TestableClockInterface::setMillis(10);
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(0, countOf('s'));
+
+  // 'slowTracer' goes back into 'slow', which is delaying, instead of the
+  // global linked list.
+  slowTracer.resume();
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(0, countOf('s'));
+
+  TestableClockInterface::setMillis(20);
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(1, countOf('s'));
+}
+
+test(PartitionTest, waitQueue) {
+  resetAll();
+
+  // 'waiter' is parked on the queue.
+  ready = false;
+  TestableCoroutineScheduler::runOnePass();
+  assertFalse(queue.isEmpty());
+
+  // 'waiter' goes back into 'slow', which is delaying, instead of the global
+  // linked list.
+  ready = true;
+  queue.notify();
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(0, countOf('w'));
+
+  TestableClockInterface::setMillis(10);
+  resetTrace();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(1, countOf('w'));
+  assertFalse(ready);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  slow.add(&slowTracer);
+  slow.add(&waiter);
+  budgeted.add(&x);
+  budgeted.add(&y);
+  budgeted.add(&z);
+  inner.add(&nestedTracer);
+  outer.add(&inner);
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,190 @@
+#line 2 "PeriodicTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+
+// ---------------------------------------------------------------------------
+
+// Expose the delay timer of the coroutine to the tests.
+class DeadlineCoroutine : public TestableCoroutine {
+  public:
+    using TestableCoroutine::getDelayDeadline;
+    using TestableCoroutine::setDelayUntilMillis;
+    using TestableCoroutine::setPeriodicMillis;
+};
+
+// Runs every 10 millis, counting the missed periods.
+class PeriodicCoroutine : public DeadlineCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_PERIODIC(10, missed);
+      }
+    }
+
+    int count = 0;
+    int missed = 0;
+};
+
+// Runs every 10 millis, ignoring the missed periods.
+class PeriodicNoCountCoroutine : public DeadlineCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_PERIODIC(10);
+      }
+    }
+
+    int count = 0;
+};
+
+// Waits until 'next', then advances it by 10 millis.
+class UntilCoroutine : public DeadlineCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        next += 10;
+        COROUTINE_DELAY_UNTIL(next);
+      }
+    }
+
+    int count = 0;
+    unsigned long next = 0;
+};
+
+PeriodicCoroutine periodic;
+PeriodicNoCountCoroutine periodicNoCount;
+UntilCoroutine until;
+
+test(PeriodicTest, periodic) {
+  TestableClockInterface::setMillis(0);
+  periodic.reset();
+
+  // The first period starts from the current time.
+  periodic.runCoroutine();
+  assertEqual(1, periodic.count);
+  assertTrue(periodic.isDelaying());
+  assertEqual(10, (int) periodic.getDelayDeadline());
+
+  TestableClockInterface::setMillis(9);
+  periodic.runCoroutine();
+  assertEqual(1, periodic.count);
+
+  // Resuming 3 millis late does not move the next deadline.
+  TestableClockInterface::setMillis(13);
+  periodic.runCoroutine();
+  assertEqual(2, periodic.count);
+  assertEqual(20, (int) periodic.getDelayDeadline());
+
+  TestableClockInterface::setMillis(20);
+  periodic.runCoroutine();
+  assertEqual(3, periodic.count);
+  assertEqual(30, (int) periodic.getDelayDeadline());
+  assertEqual(0, periodic.missed);
+}
+
+test(PeriodicTest, missedPeriods) {
+  TestableClockInterface::setMillis(0);
+  periodic.reset();
+  periodic.missed = 0;
+  periodic.runCoroutine();
+
+  // The periods ending at 20 and 30 are skipped and counted.
+  TestableClockInterface::setMillis(35);
+  periodic.runCoroutine();
+  assertEqual(2, periodic.missed);
+  assertEqual(40, (int) periodic.getDelayDeadline());
+
+  // The 1-argument form skips them too.
+  TestableClockInterface::setMillis(0);
+  periodicNoCount.reset();
+  periodicNoCount.runCoroutine();
+  TestableClockInterface::setMillis(35);
+  periodicNoCount.runCoroutine();
+  assertEqual(2, periodicNoCount.count);
+  assertEqual(40, (int) periodicNoCount.getDelayDeadline());
+}
+
+test(PeriodicTest, resetStartsFromNow) {
+  TestableClockInterface::setMillis(0);
+  periodic.reset();
+  periodic.runCoroutine();
+
+  TestableClockInterface::setMillis(1003);
+  periodic.reset();
+  periodic.count = 0;
+  periodic.missed = 0;
+  periodic.runCoroutine();
+  assertEqual(1, periodic.count);
+  assertEqual(0, periodic.missed);
+  assertEqual(1013, (int) periodic.getDelayDeadline());
+}
+
+test(PeriodicTest, delayUntil) {
+  TestableClockInterface::setMillis(0);
+  until.reset();
+  until.count = 0;
+  until.next = 0;
+
+  until.runCoroutine();
+  assertEqual(1, until.count);
+  assertEqual(10, (int) until.getDelayDeadline());
+
+  TestableClockInterface::setMillis(9);
+  until.runCoroutine();
+  assertEqual(1, until.count);
+
+  // Resuming late does not move the next deadline.
+  TestableClockInterface::setMillis(14);
+  until.runCoroutine();
+  assertEqual(2, until.count);
+  assertEqual(20, (int) until.getDelayDeadline());
+
+  // A deadline in the past expires immediately, but the coroutine still
+  // yields once.
+  TestableClockInterface::setMillis(45);
+  until.runCoroutine();
+  assertEqual(3, until.count);
+  assertEqual(30, (int) until.getDelayDeadline());
+  assertTrue(until.isDelaying());
+  until.runCoroutine();
+  assertEqual(4, until.count);
+}
+
+test(PeriodicTest, periodicAfterDelayUntil) {
+  // The next period starts at the deadline of COROUTINE_DELAY_UNTIL().
+  TestableClockInterface::setMillis(100);
+  periodic.setDelayUntilMillis(95);
+  assertEqual(0, (int) periodic.setPeriodicMillis(10));
+  assertEqual(105, (int) periodic.getDelayDeadline());
+
+  periodic.setDelayUntilMillis(150);
+  TestableClockInterface::setMillis(175);
+  assertEqual(2, (int) periodic.setPeriodicMillis(10));
+  assertEqual(180, (int) periodic.getDelayDeadline());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
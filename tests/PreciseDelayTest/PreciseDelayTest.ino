@@ -0,0 +1,133 @@
+#line 2 "PreciseDelayTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+
+using namespace aunit;
+using namespace ace_routine;
+
+// ---------------------------------------------------------------------------
+
+// A clock whose micros() advances by 1 on every call, so that the scheduler
+// can spin on it.
+class TickingClockInterface {
+  public:
+    static unsigned long millis() { return sMicros / 1000; }
+    static unsigned long micros() { return sMicros++; }
+    static unsigned long seconds() { return sMicros / 1000000; }
+
+    static unsigned long sMicros;
+};
+
+unsigned long TickingClockInterface::sMicros;
+
+using TickingCoroutine = CoroutineTemplate<TickingClockInterface>;
+using TickingScheduler = CoroutineSchedulerTemplate<TickingCoroutine>;
+
+class PreciseCoroutine : public TickingCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY_MICROS_PRECISE(1000);
+      }
+    }
+
+    using TickingCoroutine::getDelayDeadline;
+
+    int count = 0;
+};
+
+PreciseCoroutine precise;
+
+// Start the delay of 'precise', returning its deadline.
+unsigned long startDelay() {
+  TickingClockInterface::sMicros = 0;
+  precise.reset();
+  precise.count = 0;
+  TickingScheduler::setup();
+  TickingScheduler::loop();
+  return precise.getDelayDeadline();
+}
+
+test(PreciseDelayTest, spinsThroughGuardWindow) {
+  TickingScheduler::setSpinGuardMicros(100);
+  unsigned long deadline = startDelay();
+  assertEqual(1, precise.count);
+  assertTrue(precise.isDelaying());
+
+  // Outside the guard window, the coroutine yields as usual.
+  TickingScheduler::loop();
+  assertEqual(1, precise.count);
+
+  // Inside the guard window, the scheduler spins until the delay expires.
+  TickingClockInterface::sMicros = deadline - 50;
+  TickingScheduler::loop();
+  assertEqual(2, precise.count);
+  assertMoreOrEqual(TickingClockInterface::sMicros, deadline);
+  assertLessOrEqual(TickingScheduler::getLatenessMicros(), (uint32_t) 1);
+}
+
+test(PreciseDelayTest, reportsLateness) {
+  TickingScheduler::setSpinGuardMicros(100);
+  unsigned long deadline = startDelay();
+  TickingScheduler::clearLateness();
+
+  // Reached 500 micros after the delay expired. Each read of the clock adds
+  // 1 micro.
+  TickingClockInterface::sMicros = deadline + 500;
+  TickingScheduler::loop();
+  assertEqual(2, precise.count);
+  uint32_t lateness = TickingScheduler::getLatenessMicros();
+  assertMoreOrEqual(lateness, (uint32_t) 500);
+  assertLessOrEqual(lateness, (uint32_t) 505);
+  assertEqual(lateness, TickingScheduler::getMaxLatenessMicros());
+
+  // The next one is on time, which does not change the maximum.
+  TickingClockInterface::sMicros = precise.getDelayDeadline() - 10;
+  TickingScheduler::loop();
+  assertEqual(3, precise.count);
+  assertLessOrEqual(TickingScheduler::getLatenessMicros(), (uint32_t) 1);
+  assertEqual(lateness, TickingScheduler::getMaxLatenessMicros());
+
+  TickingScheduler::clearLateness();
+  assertEqual((uint32_t) 0, TickingScheduler::getMaxLatenessMicros());
+}
+
+test(PreciseDelayTest, zeroGuardDoesNotSpin) {
+  TickingScheduler::setSpinGuardMicros(0);
+  unsigned long deadline = startDelay();
+
+  TickingClockInterface::sMicros = deadline - 50;
+  TickingScheduler::loop();
+  assertEqual(1, precise.count);
+}
+
+test(PreciseDelayTest, nextWakeupMicros) {
+  TickingScheduler::setSpinGuardMicros(100);
+  unsigned long deadline = startDelay();
+
+  // The scheduler wakes up at the start of the guard window.
+  TickingClockInterface::sMicros = deadline - 500;
+  uint32_t wakeup = TickingScheduler::nextWakeupMicros();
+  assertMoreOrEqual(wakeup, (uint32_t) 390);
+  assertLessOrEqual(wakeup, (uint32_t) 400);
+
+  TickingClockInterface::sMicros = deadline - 50;
+  assertEqual((uint32_t) 0, TickingScheduler::nextWakeupMicros());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
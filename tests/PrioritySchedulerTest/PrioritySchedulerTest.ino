@@ -0,0 +1,277 @@
+#line 2 "PrioritySchedulerTest.ino"
+
+// Required by CoroutinePriorityScheduler. Must be defined before AceRoutine.h.
+#define ACE_ROUTINE_PRIORITIES 1
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+
+using TestablePriorityScheduler =
+    CoroutinePrioritySchedulerTemplate<TestableCoroutine, 4>;
+using TestableWaitQueue = WaitQueueTemplate<TestableCoroutine>;
+
+// ---------------------------------------------------------------------------
+
+// Create the coroutines in the reverse order to the order desired, because each
+// coroutine is inserted at the head of the singly-linked list.
+
+// Never blocks, so it always competes for the lowest level.
+class Busy : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_YIELD();
+      }
+    }
+
+    int count = 0;
+};
+
+Busy low2;
+Busy low1;
+
+TestableWaitQueue queue;
+bool ready = false;
+
+// Parks on the queue at a middle priority.
+class Waiter : public TestableCoroutine {
+  public:
+    Waiter() { setPriority(3); }
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT_ON(queue, ready);
+        ready = false;
+        count++;
+      }
+    }
+
+    int count = 0;
+};
+
+Waiter mid;
+
+// Sleeps at the highest priority.
+class Sleeper : public TestableCoroutine {
+  public:
+    Sleeper() { setPriority(TestablePriorityScheduler::kMaxPriority); }
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY(10);
+      }
+    }
+
+    int count = 0;
+};
+
+Sleeper high;
+
+test(PrioritySchedulerTest, highestReadyLevelRunsFirst) {
+  TestableClockInterface::setMillis(0);
+
+  // high runs first, then mid, then the low level round-robin.
+  TestablePriorityScheduler::loop();
+  assertEqual(1, high.count);
+  assertTrue(high.isDelaying());
+  assertEqual(0, low1.count);
+
+  TestablePriorityScheduler::loop();
+  assertTrue(mid.isWaiting());
+  assertEqual(0, low1.count);
+
+  TestablePriorityScheduler::loop();
+  assertEqual(1, low1.count);
+  assertEqual(0, low2.count);
+  TestablePriorityScheduler::loop();
+  assertEqual(1, low2.count);
+  TestablePriorityScheduler::loop();
+  TestablePriorityScheduler::loop();
+  assertEqual(2, low1.count);
+  assertEqual(2, low2.count);
+
+  // high preempts the low level on the first loop after its delay expires.
+  TestableClockInterface::setMillis(10);
+  TestablePriorityScheduler::loop();
+  assertEqual(2, high.count);
+  assertEqual(2, low1.count);
+  assertEqual(2, low2.count);
+
+  // mid runs as soon as it is notified, even though it was parked.
+  ready = true;
+  queue.notify();
+  TestablePriorityScheduler::loop();
+  assertEqual(1, mid.count);
+  assertTrue(mid.isWaiting());
+
+  // Then back to the low level, continuing the round-robin.
+  TestablePriorityScheduler::loop();
+  assertEqual(3, low1.count);
+  assertEqual(2, low2.count);
+
+  // A suspended high priority coroutine does not preempt until resumed.
+  high.suspend();
+  TestableClockInterface::setMillis(20);
+  TestablePriorityScheduler::loop();
+  TestablePriorityScheduler::loop();
+  assertEqual(2, high.count);
+  assertEqual(4, low1.count);
+  assertEqual(3, low2.count);
+  high.resume();
+  TestablePriorityScheduler::loop();
+  assertEqual(3, high.count);
+}
+
+// ---------------------------------------------------------------------------
+
+// A separate clock type, so that the following coroutines are in a separate
+// linked list, run by a separate scheduler.
+class SleepersClock : public TestableClockInterface {};
+using SleepersCoroutine = CoroutineTemplate<SleepersClock>;
+
+// Holds 8 sleepers in its heap, so that 2 of the 10 are polled.
+using SleepersScheduler = CoroutinePrioritySchedulerTemplate<
+    SleepersCoroutine, 8>;
+
+const uint8_t NUM_SLEEPERS = 10;
+
+// Sleeps at the highest priority, in the heap of the scheduler.
+class HighSleeper : public SleepersCoroutine {
+  public:
+    HighSleeper() { setPriority(SleepersScheduler::kMaxPriority); }
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY(100);
+      }
+    }
+
+    int count = 0;
+};
+
+// Runs once at a middle priority, then terminates.
+class Finite : public SleepersCoroutine {
+  public:
+    Finite() { setPriority(5); }
+
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      count++;
+      COROUTINE_END();
+    }
+
+    void recycleCoroutine() override { recycled++; }
+
+    int count = 0;
+    int recycled = 0;
+};
+
+// Never blocks, at the lowest level.
+class LowBusy : public SleepersCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_YIELD();
+      }
+    }
+
+    int count = 0;
+};
+
+LowBusy lowBusy;
+Finite finite;
+HighSleeper sleepers[NUM_SLEEPERS];
+
+void loopSleepers(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    SleepersScheduler::loop();
+  }
+}
+
+// Return true if the sleepers from the given index have run expected times.
+bool sleepersRan(int expected, uint8_t from = 0) {
+  for (uint8_t i = from; i < NUM_SLEEPERS; i++) {
+    if (sleepers[i].count != expected) return false;
+  }
+  return true;
+}
+
+test(PrioritySchedulerTest, sleepingHighLevelsDoNotCostLowLevel) {
+  SleepersClock::setMillis(0);
+  SleepersScheduler::setup();
+
+  // Each sleeper runs once, then the finite coroutine runs and terminates.
+  loopSleepers(NUM_SLEEPERS);
+  assertTrue(sleepersRan(1));
+  assertEqual(0, lowBusy.count);
+  loopSleepers(1);
+  assertEqual(1, finite.count);
+  assertTrue(finite.isEnding());
+
+  // The ending coroutine is terminated and recycled, then the low level runs
+  // while the sleepers wait in the heap and the blocked list.
+  loopSleepers(1);
+  assertTrue(finite.isTerminated());
+  assertEqual(1, finite.recycled);
+  loopSleepers(20);
+  assertEqual(20, lowBusy.count);
+  assertTrue(sleepersRan(1));
+
+  // All the expired sleepers preempt the low level on the following loops.
+  SleepersClock::setMillis(100);
+  loopSleepers(NUM_SLEEPERS);
+  assertTrue(sleepersRan(2));
+  assertEqual(20, lowBusy.count);
+  loopSleepers(1);
+  assertEqual(21, lowBusy.count);
+
+  // A suspended sleeper leaves the heap when it expires, and is run again
+  // only after resume().
+  sleepers[0].suspend();
+  SleepersClock::setMillis(200);
+  loopSleepers(NUM_SLEEPERS - 1);
+  assertTrue(sleepersRan(3, 1));
+  assertEqual(2, sleepers[0].count);
+  assertEqual(21, lowBusy.count);
+  loopSleepers(2);
+  assertEqual(23, lowBusy.count);
+  assertEqual(2, sleepers[0].count);
+
+  sleepers[0].resume();
+  loopSleepers(1);
+  assertEqual(3, sleepers[0].count);
+
+  // A terminated coroutine returns only after reset().
+  assertEqual(1, finite.count);
+  finite.reset();
+  loopSleepers(1);
+  assertEqual(2, finite.count);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestablePriorityScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
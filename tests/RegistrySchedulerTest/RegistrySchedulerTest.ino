@@ -0,0 +1,129 @@
+#line 2 "RegistrySchedulerTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+
+using TestScheduler = CoroutineRegistrySchedulerTemplate<TestableCoroutine, 8>;
+
+// ---------------------------------------------------------------------------
+
+// Create the coroutines in the reverse order to the order desired, because each
+// coroutine is inserted at the head of the singly-linked list.
+
+class Sleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      runs++;
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(100);
+      }
+    }
+
+    int runs = 0;
+};
+
+Sleeper sleepers[5];
+
+class Yielder : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_YIELD();
+      }
+    }
+
+    int count = 0;
+};
+
+Yielder yielder;
+
+void resetAll(unsigned long millis) {
+  TestableClockInterface::setMillis(millis);
+  yielder.reset();
+  yielder.count = 0;
+  for (Sleeper& sleeper : sleepers) {
+    sleeper.reset();
+    sleeper.runs = 0;
+  }
+  TestScheduler::setup();
+}
+
+test(RegistrySchedulerTest, sleepersNotRun) {
+  resetAll(0);
+  assertEqual(6, TestScheduler::getNumCoroutines());
+
+  TestScheduler::runOnePass();
+  assertEqual(1, yielder.count);
+  assertEqual(1, sleepers[0].runs);
+  assertTrue(sleepers[4].isDelaying());
+
+  // Only the yielder is run until the delay expires.
+  TestableClockInterface::setMillis(99);
+  TestScheduler::runOnePass();
+  TestScheduler::runOnePass();
+  assertEqual(3, yielder.count);
+  assertEqual(1, sleepers[0].runs);
+
+  TestableClockInterface::setMillis(100);
+  TestScheduler::runOnePass();
+  assertEqual(4, yielder.count);
+  for (Sleeper& sleeper : sleepers) {
+    assertEqual(2, sleeper.runs);
+  }
+}
+
+test(RegistrySchedulerTest, millisRollover) {
+  resetAll(0xFFFFFFC0);
+
+  TestScheduler::runOnePass();
+  assertEqual(1, sleepers[0].runs);
+
+  TestableClockInterface::setMillis(0x23);
+  TestScheduler::runOnePass();
+  assertEqual(1, sleepers[0].runs);
+
+  TestableClockInterface::setMillis(0x24);
+  TestScheduler::runOnePass();
+  assertEqual(2, sleepers[0].runs);
+}
+
+test(RegistrySchedulerTest, suspendAndRefresh) {
+  resetAll(0);
+
+  yielder.suspend();
+  TestScheduler::runOnePass();
+  assertEqual(0, yielder.count);
+  assertTrue(yielder.isSuspended());
+
+  // Not run again until refresh().
+  yielder.resume();
+  TestScheduler::runOnePass();
+  assertEqual(0, yielder.count);
+
+  TestScheduler::refresh();
+  TestScheduler::runOnePass();
+  assertEqual(1, yielder.count);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
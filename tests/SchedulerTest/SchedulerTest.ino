@@ -111,7 +111,7 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isDelaying());
   assertTrue(extra.isSuspended());
 
-  // skip extra
+  // move 'extra' to the suspended list
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isYielding());
@@ -141,7 +141,7 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isDelaying());
   assertTrue(extra.isSuspended());
 
-  // skip extra
+  // 'extra' is no longer visited, so run a
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isDelaying());
@@ -150,37 +150,21 @@ test(AceRoutineTest, scheduler) {
 
   TestableClockInterface::setMillis(36);
 
-  // run a
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isDelaying());
-  assertTrue(c.isDelaying());
-  assertTrue(extra.isSuspended());
-
   // run b, goes into Yielding
   TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isYielding());
-  assertTrue(c.isDelaying());
-  assertTrue(extra.isSuspended());
-
-  // run c
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
+  assertTrue(a.isDelaying());
   assertTrue(b.isYielding());
   assertTrue(c.isDelaying());
   assertTrue(extra.isSuspended());
 
   // run c
   TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
+  assertTrue(a.isDelaying());
   assertTrue(b.isYielding());
   assertTrue(c.isDelaying());
   assertTrue(extra.isSuspended());
 
-  TestableClockInterface::setMillis(101);
-
-  // run a
+  // run a, hits COROUTINE_AWAIT() which yields immediately
   TestableCoroutineScheduler::loop();
   assertTrue(a.isYielding());
   assertTrue(b.isYielding());
@@ -194,22 +178,15 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isDelaying());
   assertTrue(extra.isSuspended());
 
-  // run c
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isYielding());
-  assertTrue(c.isEnding());
-  assertTrue(extra.isSuspended());
+  TestableClockInterface::setMillis(101);
 
-  // run extra
+  // run c
   TestableCoroutineScheduler::loop();
   assertTrue(a.isYielding());
   assertTrue(b.isYielding());
   assertTrue(c.isEnding());
   assertTrue(extra.isSuspended());
 
-  TestableClockInterface::setMillis(102);
-
   // run a
   TestableCoroutineScheduler::loop();
   assertTrue(a.isYielding());
@@ -224,173 +201,92 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isEnding());
   assertTrue(extra.isSuspended());
 
-  // run c - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isEnding());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run extra - suspended
+  // run c - terminated, and moved to the terminated list
   TestableCoroutineScheduler::loop();
   assertTrue(a.isYielding());
   assertTrue(b.isEnding());
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
-  TestableClockInterface::setMillis(103);
+  TestableClockInterface::setMillis(102);
 
-  // run a, waiting for b over
+  // run a, hits COROUTINE_DELAY(25)
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isEnding());
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
-  // run b - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run c - terminated
+  // run b - terminated, and moved to the terminated list
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
-  // run extra - suspended
+  // only 'a' is left, run a
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
-  TestableClockInterface::setMillis(104);
-
-  // run a - hits COROUTINE_DELAY(25)
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run b - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run c - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run extra - suspended
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // step +26 millis
   TestableClockInterface::setMillis(130);
 
-  // run a - hits COROUTINE_AWAIT() which yields immediately
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run b - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run c - terminated
+  // run a, hits COROUTINE_AWAIT() which yields immediately
   TestableCoroutineScheduler::loop();
   assertTrue(a.isYielding());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
-  // run extra - suspended
+  // run a, hits COROUTINE_DELAY(25)
   TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
+  assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
-  // step 1 millis
   TestableClockInterface::setMillis(131);
 
-  // resume 'extra'
+  // resume 'extra', which is inserted at the head of the list
   assertTrue(extra.isSuspended());
   extra.resume();
-
-  // run a, hits COROUTINE_DELAY()
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
   assertTrue(extra.isYielding());
 
-  // run b
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isYielding());
-
-  // run c
+  // run extra
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
-  assertTrue(extra.isYielding());
+  assertTrue(extra.isEnding());
 
-  // run extra
+  // run a
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
   assertTrue(extra.isEnding());
 
-  // step +28 millis
   TestableClockInterface::setMillis(159);
 
-  // run a, hits AWAIT()
+  // run extra - terminated
   TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isEnding());
-
-  // run b
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
+  assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
-  assertTrue(extra.isEnding());
+  assertTrue(extra.isTerminated());
 
-  // run c
+  // run a, hits COROUTINE_AWAIT()
   TestableCoroutineScheduler::loop();
   assertTrue(a.isYielding());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
-  assertTrue(extra.isEnding());
+  assertTrue(extra.isTerminated());
 
-  // run extra
+  // run a, hits COROUTINE_DELAY(25)
   TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
+  assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
   assertTrue(extra.isTerminated());
@@ -406,8 +302,8 @@ void setup() {
   Serial.begin(115200);
   while (!Serial); // Leonardo/Micro
 
-  // Start the 'extra' coroutine in suspended state. Starting v1.2, a
-  // suspended coroutine will be retained in the linked list of coroutines.
+  // Start the 'extra' coroutine in suspended state. It is moved out of the
+  // linked list when the scheduler first reaches it.
   extra.suspend();
 
   TestableCoroutineScheduler::setup();
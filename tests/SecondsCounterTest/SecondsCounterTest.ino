@@ -0,0 +1,80 @@
+#line 2 "SecondsCounterTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+
+using namespace aunit;
+using namespace ace_routine;
+
+// ---------------------------------------------------------------------------
+
+test(SecondsCounterTest, update) {
+  SecondsCounter counter;
+  assertEqual((uint32_t) 0, counter.update(0));
+  assertEqual((uint32_t) 0, counter.update(999));
+  assertEqual((uint32_t) 1, counter.update(1000));
+  assertEqual((uint32_t) 1, counter.update(1999));
+  assertEqual((uint32_t) 2, counter.update(2500));
+
+  // Catch up after a long time without calls.
+  assertEqual((uint32_t) 3602, counter.update(3602000));
+  assertEqual((uint32_t) 3602, counter.update(3602999));
+}
+
+test(SecondsCounterTest, gapOfSeveralMinutes) {
+  SecondsCounter counter;
+  assertEqual((uint32_t) 1, counter.update(1250));
+
+  // A gap of 7 minutes is caught up in one call, and the next second still
+  // starts on a multiple of 1000 millis.
+  assertEqual((uint32_t) 421, counter.update(421249));
+  assertEqual((uint32_t) 421, counter.update(421999));
+  assertEqual((uint32_t) 422, counter.update(422000));
+
+  // Gaps just below and above the threshold of the loop.
+  assertEqual((uint32_t) 425, counter.update(425999));
+  assertEqual((uint32_t) 429, counter.update(429250));
+  assertEqual((uint32_t) 429, counter.update(429999));
+  assertEqual((uint32_t) 430, counter.update(430000));
+}
+
+test(SecondsCounterTest, matchesDivision) {
+  SecondsCounter counter;
+
+  // Gaps from 0 to about 19 hours, so that every step of the catch-up is used.
+  uint32_t now = 0;
+  uint32_t seed = 1;
+  for (uint16_t i = 0; i < 1000; i++) {
+    seed = seed * 1103515245 + 12345;
+    now += (seed >> 8) % (1UL << (i % 27));
+    assertEqual(now / 1000, counter.update(now));
+  }
+}
+
+test(SecondsCounterTest, millisRollover) {
+  SecondsCounter counter;
+
+  // Catch up to the last full second before the millis rollover.
+  assertEqual((uint32_t) 4294967, counter.update(4294967295UL));
+
+  // The next second starts 1000 millis after the previous one, instead of at
+  // the millis rollover, so the seconds do not go back to 0.
+  assertEqual((uint32_t) 4294967, counter.update(703));
+  assertEqual((uint32_t) 4294968, counter.update(704));
+  assertEqual((uint32_t) 4294969, counter.update(1704));
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,141 @@
+#line 2 "SectionTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+
+#if ACE_ROUTINE_HAS_SECTION_REGISTRY
+
+using TestableSectionCoroutine =
+    SectionCoroutineTemplate<TestableClockInterface>;
+using TestScheduler = SectionCoroutineSchedulerTemplate<TestableClockInterface>;
+
+// ---------------------------------------------------------------------------
+
+// The order of the coroutines in the section is not specified, so the tests
+// only check the effect of whole passes.
+
+int blinkCount = 0;
+
+COROUTINE_SECTION(TestableSectionCoroutine, blinker) {
+  COROUTINE_LOOP() {
+    blinkCount++;
+    COROUTINE_DELAY(10);
+  }
+}
+
+int oneShotCount = 0;
+
+// Counts to 3, then terminates.
+COROUTINE_SECTION(TestableSectionCoroutine, oneShot) {
+  COROUTINE_BEGIN();
+  for (oneShotCount = 0; oneShotCount < 3; oneShotCount++) {
+    COROUTINE_YIELD();
+  }
+  COROUTINE_END();
+}
+
+void resetAll() {
+  TestableClockInterface::setMillis(0);
+  blinker.reset();
+  oneShot.reset();
+  blinkCount = 0;
+  TestScheduler::setup();
+}
+
+test(SectionTest, registry) {
+  assertEqual(2, TestScheduler::getNumCoroutines());
+
+  // There is no vtable pointer and no linked list pointer.
+  assertTrue(sizeof(TestableSectionCoroutine)
+      < sizeof(CoroutineCrtpBaseTemplate<TestableClockInterface>));
+}
+
+test(SectionTest, delay) {
+  resetAll();
+
+  TestScheduler::runOnePass();
+  assertEqual(1, blinkCount);
+  assertTrue(blinker.isDelaying());
+
+  TestableClockInterface::setMillis(9);
+  TestScheduler::runOnePass();
+  assertEqual(1, blinkCount);
+
+  TestableClockInterface::setMillis(10);
+  TestScheduler::runOnePass();
+  assertEqual(2, blinkCount);
+}
+
+test(SectionTest, endAndReset) {
+  resetAll();
+
+  for (int i = 0; i < 4; i++) {
+    TestScheduler::runOnePass();
+  }
+  assertEqual(3, oneShotCount);
+  assertTrue(oneShot.isEnding());
+
+  // The scheduler retires the ending coroutine, which is then skipped.
+  TestScheduler::runOnePass();
+  assertTrue(oneShot.isTerminated());
+  TestScheduler::runOnePass();
+  assertTrue(oneShot.isTerminated());
+
+  // A reset coroutine is run again from the beginning.
+  oneShot.reset();
+  TestScheduler::runOnePass();
+  assertEqual(0, oneShotCount);
+  assertTrue(oneShot.isYielding());
+}
+
+test(SectionTest, suspendAndResume) {
+  resetAll();
+
+  blinker.suspend();
+  assertTrue(blinker.isSuspended());
+  TestScheduler::runOnePass();
+  assertEqual(0, blinkCount);
+
+  blinker.resume();
+  TestScheduler::runOnePass();
+  assertEqual(1, blinkCount);
+}
+
+test(SectionTest, loop) {
+  resetAll();
+
+  // Each loop() runs one coroutine, so two loops() make one pass.
+  TestScheduler::loop();
+  TestScheduler::loop();
+  assertEqual(1, blinkCount);
+  assertEqual(0, oneShotCount);
+
+  // The next pass wraps around to the first coroutine.
+  TestableClockInterface::setMillis(10);
+  TestScheduler::loop();
+  TestScheduler::loop();
+  assertEqual(2, blinkCount);
+  assertEqual(1, oneShotCount);
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
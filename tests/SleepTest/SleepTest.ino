@@ -0,0 +1,147 @@
+#line 2 "SleepTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Create the coroutines in the reverse order to the order desired, because each
+// coroutine is inserted at the head of the singly-linked list.
+
+class CoroutineB : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY_SECONDS(2);
+      }
+    }
+
+    int count = 0;
+};
+
+CoroutineB b;
+
+class CoroutineA : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_DELAY(20);
+      }
+    }
+
+    int count = 0;
+};
+
+CoroutineA a;
+
+// Sleep hook which advances the testable clock instead of sleeping.
+uint32_t sleptMicros = 0;
+int numSleeps = 0;
+
+void fakeSleep(uint32_t micros) {
+  sleptMicros = micros;
+  numSleeps++;
+  TestableClockInterface::setMillis(
+      TestableClockInterface::millis() + micros / 1000);
+}
+
+void resetAll() {
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setMicros(0);
+  TestableClockInterface::setSeconds(0);
+  a.reset();
+  b.reset();
+  a.count = 0;
+  b.count = 0;
+  TestableCoroutineScheduler::setup();
+}
+
+test(SleepTest, loopOrSleep) {
+  resetAll();
+  TestableCoroutineScheduler::setSleepHook(fakeSleep);
+  numSleeps = 0;
+
+  // The first pass does not sleep, because both coroutines are ready.
+  TestableCoroutineScheduler::loopOrSleep(); // a
+  TestableCoroutineScheduler::loopOrSleep(); // b
+  assertEqual(0, numSleeps);
+  assertEqual(1, a.count);
+  assertEqual(1, b.count);
+
+  // The next pass sleeps until 'a' wakes up, then runs 'a'.
+  TestableCoroutineScheduler::loopOrSleep();
+  assertEqual(1, numSleeps);
+  assertEqual((uint32_t) 20000, sleptMicros);
+  assertEqual(2, a.count);
+
+  // The sleep is limited by maxSleepMicros.
+  TestableCoroutineScheduler::loopOrSleep(); // b
+  TestableCoroutineScheduler::loopOrSleep(5000);
+  assertEqual(2, numSleeps);
+  assertEqual((uint32_t) 5000, sleptMicros);
+  assertEqual(2, a.count);
+
+  // No sleeping without a hook.
+  TestableCoroutineScheduler::setSleepHook(nullptr);
+  TestableCoroutineScheduler::loopOrSleep(); // b
+  TestableCoroutineScheduler::loopOrSleep(); // a
+  assertEqual(2, numSleeps);
+}
+
+test(SleepTest, nextWakeupMicros) {
+  resetAll();
+
+  // Ready to run.
+  assertEqual((uint32_t) 0, TestableCoroutineScheduler::nextWakeupMicros());
+
+  // 'a' sleeps 20 millis, 'b' sleeps 2 seconds.
+  TestableCoroutineScheduler::loop();
+  TestableCoroutineScheduler::loop();
+  assertEqual((uint32_t) 20000,
+      TestableCoroutineScheduler::nextWakeupMicros());
+
+  TestableClockInterface::setMillis(15);
+  assertEqual((uint32_t) 5000, TestableCoroutineScheduler::nextWakeupMicros());
+
+  TestableClockInterface::setMillis(20);
+  assertEqual((uint32_t) 0, TestableCoroutineScheduler::nextWakeupMicros());
+
+  // Only 'b' is left.
+  a.suspend();
+  assertEqual((uint32_t) 2000000,
+      TestableCoroutineScheduler::nextWakeupMicros());
+
+  // Nothing will wake up by itself.
+  b.suspend();
+  assertEqual((uint32_t) TestableCoroutineScheduler::kNoWakeup,
+      TestableCoroutineScheduler::nextWakeupMicros());
+
+  a.resume();
+  assertEqual((uint32_t) 0, TestableCoroutineScheduler::nextWakeupMicros());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,163 @@
+#line 2 "SpscChannelTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#if defined(EPOXY_DUINO)
+  #include <thread>
+#endif
+
+using namespace ace_routine;
+using namespace aunit;
+
+test(SpscChannelTest, readAndWrite) {
+  SpscChannel<int, 4> channel;
+  int value = 0;
+
+  assertEqual(4, channel.capacity());
+  assertFalse(channel.read(value));
+
+  // Fill the channel.
+  for (int i = 0; i < 4; i++) {
+    assertTrue(channel.write(i));
+  }
+  assertEqual(4, channel.size());
+  assertFalse(channel.write(4));
+
+  // Values are read in order.
+  assertTrue(channel.read(value));
+  assertEqual(0, value);
+  assertTrue(channel.write(4));
+  for (int i = 1; i <= 4; i++) {
+    assertTrue(channel.read(value));
+    assertEqual(i, value);
+  }
+  assertFalse(channel.read(value));
+  assertEqual(0, channel.size());
+}
+
+test(SpscChannelTest, indexWrapAround) {
+  SpscChannel<uint32_t, 8> channel;
+  uint32_t value = 0;
+
+  // Run the 16-bit indexes around more than once, with 3 elements in flight.
+  for (uint32_t i = 0; i < 3; i++) {
+    assertTrue(channel.write(i));
+  }
+  for (uint32_t i = 3; i < 70000; i++) {
+    assertTrue(channel.write(i));
+    assertTrue(channel.read(value));
+    assertEqual(i - 3, value);
+  }
+  assertEqual(3, channel.size());
+}
+
+// A writer and a reader using the macros, through the CoroutineScheduler.
+SpscChannel<int, 2> macroChannel;
+const int NUM_MESSAGES = 10;
+int received[NUM_MESSAGES];
+int numReceived = 0;
+
+class Reader : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (i = 0; i < NUM_MESSAGES; i++) {
+        COROUTINE_CHANNEL_READ(macroChannel, received[i]);
+        numReceived++;
+
+        // Let the writer fill the channel.
+        COROUTINE_YIELD();
+        COROUTINE_YIELD();
+      }
+      COROUTINE_END();
+    }
+
+    int i = 0;
+};
+
+class Writer : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (i = 0; i < NUM_MESSAGES; i++) {
+        COROUTINE_CHANNEL_WRITE(macroChannel, i * 10);
+        if (macroChannel.size() == 2) maxFull = true;
+      }
+      COROUTINE_END();
+    }
+
+    int i = 0;
+    bool maxFull = false;
+};
+
+Reader reader;
+Writer writer;
+
+test(SpscChannelTest, channelMacros) {
+  CoroutineScheduler::setup();
+  for (int i = 0; i < 200 && ! reader.isDone(); i++) {
+    CoroutineScheduler::loop();
+
+    // A waiting coroutine is polled, never parked.
+    assertFalse(reader.isWaiting());
+    assertFalse(writer.isWaiting());
+  }
+
+  assertTrue(reader.isDone());
+  assertTrue(writer.isDone());
+  assertTrue(writer.maxFull);
+  assertEqual(NUM_MESSAGES, numReceived);
+  for (int i = 0; i < NUM_MESSAGES; i++) {
+    assertEqual(i * 10, received[i]);
+  }
+}
+
+#if defined(EPOXY_DUINO)
+
+// The writer and reader on separate threads.
+test(SpscChannelTest, twoThreads) {
+  const uint32_t count = 200000;
+  static SpscChannel<uint32_t, 64> channel;
+  uint32_t errors = 0;
+
+  std::thread consumer([&]() {
+    uint32_t expected = 0;
+    uint32_t value;
+    while (expected < count) {
+      if (channel.read(value)) {
+        if (value != expected) errors++;
+        expected++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  for (uint32_t i = 0; i < count; ) {
+    if (channel.write(i)) {
+      i++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  consumer.join();
+
+  assertEqual((uint32_t) 0, errors);
+  assertEqual(0, channel.size());
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
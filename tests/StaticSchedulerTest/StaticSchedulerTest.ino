@@ -0,0 +1,151 @@
+#line 2 "StaticSchedulerTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+
+// ---------------------------------------------------------------------------
+
+using TestableStaticCoroutine = StaticCoroutineTemplate<TestableClockInterface>;
+
+// Records the order in which the coroutines run.
+char trace[32];
+uint8_t traceLength = 0;
+
+void record(char c) {
+  if (traceLength < sizeof(trace) - 1) {
+    trace[traceLength++] = c;
+    trace[traceLength] = '\0';
+  }
+}
+
+void clearTrace() {
+  traceLength = 0;
+  trace[0] = '\0';
+}
+
+class CoroutineA : public TestableStaticCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        record('a');
+        COROUTINE_YIELD();
+      }
+    }
+
+    void setupCoroutine() override { setupCount++; }
+
+    int setupCount = 0;
+};
+
+class CoroutineB : public TestableStaticCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        record('b');
+        COROUTINE_DELAY(10);
+      }
+    }
+};
+
+// Runs twice, then terminates.
+class CoroutineC : public TestableStaticCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      record('c');
+      COROUTINE_YIELD();
+      record('c');
+      COROUTINE_END();
+    }
+};
+
+using TestScheduler = StaticCoroutineScheduler<
+    CoroutineA, CoroutineB, CoroutineC>;
+
+void resetAll() {
+  TestableClockInterface::setMillis(0);
+  TestScheduler::get<CoroutineA>().reset();
+  TestScheduler::get<CoroutineB>().reset();
+  TestScheduler::get<CoroutineC>().reset();
+  TestScheduler::setup();
+  clearTrace();
+}
+
+test(StaticSchedulerTest, notInLinkedList) {
+  resetAll();
+  assertEqual(3, (int) TestScheduler::kNumCoroutines);
+
+  // The CoroutineScheduler for the same clock does not see the coroutines.
+  using LinkedScheduler =
+      CoroutineSchedulerTemplate<CoroutineTemplate<TestableClockInterface>>;
+  LinkedScheduler::setup();
+  LinkedScheduler::runOnePass();
+  assertEqual("", trace);
+}
+
+test(StaticSchedulerTest, setupCoroutines) {
+  TestScheduler::get<CoroutineA>().setupCount = 0;
+  TestScheduler::setupCoroutines();
+  assertEqual(1, TestScheduler::get<CoroutineA>().setupCount);
+}
+
+test(StaticSchedulerTest, loop) {
+  resetAll();
+
+  // Round-robin in the order of the template arguments.
+  TestScheduler::loop();
+  TestScheduler::loop();
+  TestScheduler::loop();
+  assertEqual("abc", trace);
+
+  // 'b' is delaying, 'c' reaches COROUTINE_END().
+  TestScheduler::loop();
+  TestScheduler::loop();
+  TestScheduler::loop();
+  assertEqual("abcac", trace);
+  assertTrue(TestScheduler::get<CoroutineC>().isEnding());
+
+  // 'c' is marked terminated and skipped from now on.
+  TestableClockInterface::setMillis(10);
+  TestScheduler::loop();
+  TestScheduler::loop();
+  TestScheduler::loop();
+  assertEqual("abcacab", trace);
+  assertTrue(TestScheduler::get<CoroutineC>().isTerminated());
+}
+
+test(StaticSchedulerTest, runOnePass) {
+  resetAll();
+
+  TestScheduler::runOnePass();
+  assertEqual("abc", trace);
+
+  // A suspended coroutine is skipped until it is resumed.
+  TestScheduler::get<CoroutineA>().suspend();
+  TestScheduler::runOnePass();
+  assertEqual("abcc", trace);
+
+  TestScheduler::get<CoroutineA>().resume();
+  TestScheduler::runOnePass();
+  assertEqual("abcca", trace);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,129 @@
+#line 2 "SuspendListTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+class Counter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        count++;
+        COROUTINE_YIELD();
+      }
+    }
+
+    int count = 0;
+};
+
+class Finisher : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      count++;
+      COROUTINE_END();
+    }
+
+    int count = 0;
+};
+
+Finisher finisher;
+Counter d;
+Counter c;
+Counter b;
+Counter a;
+
+TestableCoroutine* const groupCoroutines[] = {&c, &d};
+CoroutineGroupTemplate<TestableCoroutine> group(groupCoroutines);
+
+test(SuspendListTest, suspendedAndTerminatedAreNotVisited) {
+  assertEqual(2, group.size());
+
+  // Order is a, b, c, d, finisher.
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(1, a.count);
+  assertEqual(1, d.count);
+  assertEqual(1, finisher.count);
+  assertTrue(finisher.isEnding());
+
+  // The suspended and terminated coroutines are moved out on the next pass.
+  group.suspend();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(2, a.count);
+  assertEqual(2, b.count);
+  assertEqual(1, c.count);
+  assertEqual(1, d.count);
+  assertTrue(c.isSuspended());
+  assertTrue(finisher.isTerminated());
+
+  // Only 'a' and 'b' remain, so each loop() alternates between them.
+  for (int i = 0; i < 4; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+  assertEqual(4, a.count);
+  assertEqual(4, b.count);
+  assertEqual(1, c.count);
+  assertEqual(1, d.count);
+
+  // Resume the group. The coroutines are inserted at the head of the list.
+  group.resume();
+  assertTrue(c.isYielding());
+  assertTrue(d.isYielding());
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(5, a.count);
+  assertEqual(5, b.count);
+  assertEqual(2, c.count);
+  assertEqual(2, d.count);
+
+  // A terminated coroutine runs again after reset().
+  assertFalse(group.isDone());
+  finisher.reset();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(2, finisher.count);
+  assertTrue(finisher.isEnding());
+}
+
+test(SuspendListTest, suspendThenResumeBeforeVisit) {
+  // A suspend() immediately followed by resume() only changes the status.
+  a.suspend();
+  a.resume();
+  int count = a.count;
+  TestableCoroutineScheduler::runOnePass();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(count + 2, a.count);
+
+  // Resuming twice does not insert the coroutine twice.
+  a.suspend();
+  TestableCoroutineScheduler::runOnePass();
+  a.resume();
+  a.resume();
+  count = a.count;
+  TestableCoroutineScheduler::runOnePass();
+  TestableCoroutineScheduler::runOnePass();
+  assertEqual(count + 2, a.count);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
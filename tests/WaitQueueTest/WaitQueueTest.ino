@@ -0,0 +1,184 @@
+#line 2 "WaitQueueTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableCoroutine;
+
+using TestableScheduler = CoroutineSchedulerTemplate<TestableCoroutine>;
+using TestableWaitQueue = WaitQueueTemplate<TestableCoroutine>;
+
+// ---------------------------------------------------------------------------
+
+TestableWaitQueue queue;
+bool ready = false;
+
+// Parks on the queue until 'ready' is true.
+class Waiter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      runs++;
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT_ON(queue, ready);
+        count++;
+        ready = false;
+      }
+    }
+
+    int runs = 0;
+    int count = 0;
+};
+
+// Sends 0, 1, 2, ... through the channel.
+class Writer : public TestableCoroutine {
+  public:
+    Writer(Channel<int, TestableCoroutine>& channel) : mChannel(channel) {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_CHANNEL_WRITE(mChannel, value);
+        value++;
+      }
+    }
+
+    int value = 0;
+
+  private:
+    Channel<int, TestableCoroutine>& mChannel;
+};
+
+// Receives the values from the channel.
+class Reader : public TestableCoroutine {
+  public:
+    Reader(Channel<int, TestableCoroutine>& channel) : mChannel(channel) {}
+
+    int runCoroutine() override {
+      runs++;
+      COROUTINE_LOOP() {
+        COROUTINE_CHANNEL_READ(mChannel, value);
+        if (value != count) mismatch = true;
+        count++;
+      }
+    }
+
+    int runs = 0;
+    int value = -1;
+    int count = 0;
+    bool mismatch = false;
+
+  private:
+    Channel<int, TestableCoroutine>& mChannel;
+};
+
+Channel<int, TestableCoroutine> channel;
+Waiter waiter;
+Reader reader(channel);
+Writer writer(channel);
+
+// ---------------------------------------------------------------------------
+
+test(WaitQueueTest, parkedCoroutineIsNotRunUntilNotify) {
+  TestableScheduler::setup();
+
+  // Run enough passes for every coroutine to park itself at least once.
+  for (int i = 0; i < 10; i++) {
+    TestableScheduler::loop();
+  }
+  assertTrue(waiter.isWaiting());
+  assertFalse(queue.isEmpty());
+  int runs = waiter.runs;
+
+  // Changing the condition without notify() does not wake the waiter.
+  ready = true;
+  for (int i = 0; i < 10; i++) {
+    TestableScheduler::loop();
+  }
+  assertEqual(runs, waiter.runs);
+  assertEqual(0, waiter.count);
+
+  // After notify(), the waiter runs once, then parks itself again.
+  queue.notify();
+  assertTrue(queue.isEmpty());
+  assertTrue(waiter.isYielding());
+  for (int i = 0; i < 10; i++) {
+    TestableScheduler::loop();
+  }
+  assertEqual(runs + 1, waiter.runs);
+  assertEqual(1, waiter.count);
+  assertTrue(waiter.isWaiting());
+  assertFalse(queue.isEmpty());
+
+  // A notify() with a false condition parks the waiter again.
+  queue.notify();
+  for (int i = 0; i < 10; i++) {
+    TestableScheduler::loop();
+  }
+  assertEqual(runs + 2, waiter.runs);
+  assertEqual(1, waiter.count);
+  assertTrue(waiter.isWaiting());
+}
+
+test(WaitQueueTest, channelReaderAndWriterPark) {
+  TestableScheduler::setup();
+
+  for (int i = 0; i < 100; i++) {
+    TestableScheduler::loop();
+  }
+
+  // Values arrive in order, and the reader is resumed only when the writer
+  // has changed the state of the channel, about twice per value.
+  assertFalse(reader.mismatch);
+  assertMore(reader.count, 10);
+  assertLessOrEqual(reader.runs, 2 * reader.count + 2);
+}
+
+test(WaitQueueTest, resetUnparksCoroutine) {
+  TestableScheduler::setup();
+
+  ready = false;
+  for (int i = 0; i < 10; i++) {
+    TestableScheduler::loop();
+  }
+  assertTrue(waiter.isWaiting());
+  assertFalse(queue.isEmpty());
+  int runs = waiter.runs;
+  int count = waiter.count;
+
+  // reset() takes the waiter off the queue, so it restarts without notify().
+  waiter.reset();
+  assertTrue(queue.isEmpty());
+  assertTrue(waiter.isYielding());
+  for (int i = 0; i < 10; i++) {
+    TestableScheduler::loop();
+  }
+  assertEqual(runs + 1, waiter.runs);
+  assertEqual(count, waiter.count);
+  assertTrue(waiter.isWaiting());
+  assertFalse(queue.isEmpty());
+
+  // The waiter is parked only once, so notify() runs it only once.
+  queue.notify();
+  for (int i = 0; i < 10; i++) {
+    TestableScheduler::loop();
+  }
+  assertEqual(runs + 2, waiter.runs);
+  assertTrue(waiter.isWaiting());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
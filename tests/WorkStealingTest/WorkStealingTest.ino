@@ -0,0 +1,151 @@
+#line 2 "WorkStealingTest.ino"
+
+#include <AceRoutine.h>
+#include <ace_routine/CoroutineWorkStealingScheduler.h>
+#include <AUnitVerbose.h>
+
+using namespace aunit;
+using namespace ace_routine;
+
+#if defined(EPOXY_DUINO) || defined(ESP32)
+
+using TestScheduler = CoroutineWorkStealingSchedulerTemplate<Coroutine, 4>;
+
+const uint8_t NUM_COUNTERS = 100;
+const uint16_t NUM_STEPS = 50;
+
+// Counts to NUM_STEPS, recording the workers which ran it.
+class Counter : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (count = 0; count < NUM_STEPS; count++) {
+        workers |= (1 << TestScheduler::currentWorker());
+        COROUTINE_YIELD();
+      }
+      COROUTINE_END();
+    }
+
+    uint16_t count = 0;
+    uint8_t workers = 0;
+};
+
+Counter counters[NUM_COUNTERS];
+Counter pinned;
+
+const uint8_t NUM_AWAITERS = 16;
+std::atomic<bool> go(false);
+WaitQueue waitQueue;
+
+// Waits on the WaitQueue on every worker at the same time. The worker polls
+// the condition instead of parking the coroutine.
+class Awaiter : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (count = 0; count < NUM_STEPS; count++) {
+        COROUTINE_AWAIT_ON(waitQueue, go.load());
+        COROUTINE_YIELD();
+      }
+      COROUTINE_END();
+    }
+
+    uint16_t count = 0;
+};
+
+Awaiter awaiters[NUM_AWAITERS];
+
+// Wait until all coroutines are terminated, or 5 seconds have passed.
+bool waitUntilDone() {
+  unsigned long start = millis();
+  while (TestScheduler::getNumActive() > 0) {
+    if (millis() - start > 5000) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// Run all the coroutines from the beginning, returning true if they finished.
+bool runAll(uint8_t numWorkers) {
+  for (uint8_t i = 0; i < NUM_COUNTERS; i++) {
+    counters[i].reset();
+    counters[i].workers = 0;
+  }
+  pinned.reset();
+  pinned.workers = 0;
+  go = true;
+  for (uint8_t i = 0; i < NUM_AWAITERS; i++) {
+    awaiters[i].reset();
+  }
+
+  TestScheduler::setup(numWorkers);
+  TestScheduler::start();
+  bool done = waitUntilDone();
+  TestScheduler::stop();
+  return done;
+}
+
+test(WorkStealingTest, runsAllCoroutines) {
+  assertEqual(-1, TestScheduler::currentWorker());
+
+  for (uint8_t numWorkers = 1; numWorkers <= 4; numWorkers++) {
+    assertTrue(runAll(numWorkers));
+
+    assertEqual((uint32_t) 0, TestScheduler::getNumActive());
+    uint8_t allWorkers = 0;
+    for (uint8_t i = 0; i < NUM_COUNTERS; i++) {
+      assertEqual(NUM_STEPS, counters[i].count);
+      assertTrue(counters[i].isTerminated());
+      allWorkers |= counters[i].workers;
+    }
+    // Which workers ran the coroutines depends on the timing of the threads,
+    // but only the started workers can run them.
+    assertEqual(0, allWorkers & ~((1 << numWorkers) - 1));
+
+    // The pinned coroutine runs only on worker 0.
+    assertEqual(NUM_STEPS, pinned.count);
+    assertEqual(1, pinned.workers);
+  }
+}
+
+test(WorkStealingTest, awaitOnPollsOnEveryWorker) {
+  go = false;
+  for (uint8_t i = 0; i < NUM_AWAITERS; i++) {
+    awaiters[i].reset();
+  }
+
+  TestScheduler::setup(4);
+  TestScheduler::start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  go = true;
+  bool done = waitUntilDone();
+  TestScheduler::stop();
+
+  assertTrue(done);
+  assertTrue(waitQueue.isEmpty());
+  for (uint8_t i = 0; i < NUM_AWAITERS; i++) {
+    assertEqual(NUM_STEPS, awaiters[i].count);
+    assertTrue(awaiters[i].isTerminated());
+  }
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+#if defined(EPOXY_DUINO) || defined(ESP32)
+  TestScheduler::pin(&pinned, 0);
+#endif
+}
+
+void loop() {
+  TestRunner::run();
+}